@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+/**
+ * Allocates memory from the arena. The memory stays valid until the arena is reset;
+ * it is never freed on its own.
+ * @param pool The arena.
+ * @param size The number of bytes to allocate.
+ * @return Returns a pointer to the allocated memory, or NULL if memory allocation failed.
+ */
+void *arena_alloc(arena *pool, long size)
+{
+    arenaBlock *block = pool->blocks;
+    long block_size;
+    void *ptr;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~(long)(ARENA_ALIGNMENT - 1); // Keep the next allocation aligned
+
+    // Start a new block when the current one is full, reusing a spare one if it fits
+    if ((block == NULL || block->used + size > block->size) && pool->spare != NULL && size <= ARENA_BLOCK_SIZE)
+    {
+        block = pool->spare;
+        pool->spare = block->next;
+        block->used = 0;
+        block->next = pool->blocks;
+        pool->blocks = block;
+    }
+    else if (block == NULL || block->used + size > block->size)
+    {
+        block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = (arenaBlock *)malloc(sizeof(arenaBlock) + block_size);
+        if (block == NULL)
+        {
+            fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+            return NULL;
+        }
+        block->size = block_size;
+        block->used = 0;
+        block->next = pool->blocks;
+        pool->blocks = block;
+        pool->block_count++;
+    }
+
+    ptr = (char *)(block + 1) + block->used;
+    block->used += size;
+    pool->allocations++;
+    pool->bytes += size;
+    return ptr;
+}
+
+/**
+ * Frees everything allocated from the arena at once.
+ * @param pool The arena to reset.
+ */
+void reset_arena(arena *pool)
+{
+    arenaBlock *block = pool->blocks;
+    arenaBlock *next;
+
+    while (block != NULL)
+    {
+        next = block->next;
+        free(block);
+        block = next;
+    }
+    for (block = pool->spare; block != NULL; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    pool->blocks = NULL;
+    pool->spare = NULL;
+    pool->allocations = 0;
+    pool->bytes = 0;
+    pool->block_count = 0;
+}
+
+/**
+ * Empties the arena like reset_arena, but keeps up to ARENA_SPARE_BLOCKS regular
+ * blocks so the next file can allocate without going to the system.
+ * @param pool The arena to recycle.
+ */
+void recycle_arena(arena *pool)
+{
+    arenaBlock *block = pool->blocks;
+    arenaBlock *next;
+    int kept = 0;
+
+    for (next = pool->spare; next != NULL; next = next->next)
+        kept++;
+    while (block != NULL)
+    {
+        next = block->next;
+        if (block->size == ARENA_BLOCK_SIZE && kept < ARENA_SPARE_BLOCKS)
+        {
+            block->next = pool->spare;
+            pool->spare = block;
+            kept++;
+        }
+        else
+            free(block);
+        block = next;
+    }
+    pool->blocks = NULL;
+    pool->allocations = 0;
+    pool->bytes = 0;
+    pool->block_count = 0;
+}
@@ -0,0 +1,310 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "preAssembler.h"
+#include "vars.h"
+#include "utils.h"
+#include "writeFiles.h"
+#include "assembler.h"
+
+typedef struct assemblyJob
+{
+    char *name;       // The file name given on the command line, without extension
+    char *out_text;   // Progress messages collected while assembling
+    size_t out_size;  // Length of the progress messages
+    char *diag_text;  // Error and warning messages collected while assembling
+    size_t diag_size; // Length of the error and warning messages
+    int done;         // Flag indicating the job has finished
+} assemblyJob;        // Definition of one input file assembled by a worker thread
+
+typedef struct jobQueue
+{
+    assemblyJob *jobs;       // The jobs, in command-line order
+    int count;               // Number of jobs
+    int next;                // Index of the next job to hand out
+    asmOptions *options;     // The command-line options
+    pthread_mutex_t lock;    // Protects next and the done flags
+    pthread_cond_t finished; // Signalled whenever a job finishes
+} jobQueue;                  // Definition of the work shared by the worker threads
+
+/**
+ * Assembles a single file into its output files, using the current thread's context.
+ * @param name The file name given on the command line, without extension.
+ * @param options The command-line options.
+ * @return TRUE if the source file was opened, FALSE otherwise.
+ */
+int assemble_file(char *name, asmOptions *options)
+{
+    FILE *file;
+
+    // Open input file with .as extension for reading
+    file = fopen(create_file_name(name, AS_FILE), "r");
+
+    // Check if the file was opened successfully
+    if (file == NULL)
+    {
+        print_error_message(CANNOT_OPEN_FILE, 0);
+        return FALSE;
+    }
+
+    assemble_source(name, file, options);
+    fclose(file);
+    return TRUE;
+}
+
+/**
+ * Assembles an open source into the output files of the given name, using the current
+ * thread's context. The source is read as if it were the file name.as.
+ * @param name The name of the output files, without extension.
+ * @param file The source, open for reading.
+ * @param options The command-line options.
+ */
+void assemble_source(char *name, FILE *file, asmOptions *options)
+{
+    char *input_filename;
+    FILE *fp;
+    sourceBuffer source; // In-memory expanded source shared by all passes
+    hashStats macro_stats; // Chain lengths and lookups of the macro table
+
+    context->large_memory = options->large_memory;
+    context->pool_strings = options->pool_strings;
+    input_filename = create_file_name(name, AS_FILE);
+
+    // Print pre-assembling process start message
+    fprintf(context->out, "************* Started %s pre_assembling process *************\n\n", input_filename);
+
+    // Create filename for the expanded source with .am extension
+    input_filename = create_file_name(name, AM_FILE);
+
+    // Perform pre-assembly process into the in-memory source buffer
+    initSource(&source);
+    start_phase(&context->stats);
+    preAssembler(file, &source);
+    end_phase(&context->stats, PRE_ASSEMBLER_PHASE);
+
+    // Write the expanded source to the .am file only if requested
+    if (options->emit_am)
+    {
+        fp = fopen(input_filename, "w");
+        if (fp == NULL || !write_source(&source, fp))
+            print_error_message(FAILED_TO_CREATE_FILE, 0);
+        if (fp != NULL)
+            fclose(fp);
+    }
+
+    // Check if there were no errors in pre-assembly process
+    if (!has_error)
+    {
+        // Print assembling process start message, then perform both passes of assembly process
+        fprintf(context->out, "\n************* Started %s assembling process *************\n\n", input_filename);
+        assemble_passes(&source, options);
+    }
+
+    // Check if there were no errors in second pass
+    if (!has_error)
+    {
+        // Write output files
+        start_phase(&context->stats);
+        write_output_files(name);
+        end_phase(&context->stats, WRITE_FILES_PHASE);
+    }
+
+    // Check that the output files could be written
+    if (!has_error)
+    {
+
+        // Report what sharing the strings' storage saved
+        if (options->pool_strings)
+            fprintf(context->out, "Pooled %ld strings, saving %ld data words\n", context->stats.strings_pooled,
+                    context->stats.data_words_pooled);
+
+        // Print assembling process finish message
+        fprintf(context->out, "\n************* Finished %s assembling process *************\n\n", input_filename);
+    }
+    else
+    {
+        // Print assembling process Failed message
+        fprintf(context->out, "\n************* Failed %s assembling process *************\n\n", input_filename);
+    }
+
+    // Report the statistics of the file
+    if (options->stats)
+    {
+        table_stats(macroTable, &macro_stats);
+        context->stats.macros = macro_stats.keys;
+        context->stats.macro_buckets = macro_stats.buckets;
+        context->stats.macro_max_chain = macro_stats.max_chain;
+        context->stats.macro_avg_chain = macro_stats.avg_chain;
+        context->stats.macro_lookups = (long)macro_stats.lookups;
+        context->stats.macro_filtered = (long)macro_stats.filtered;
+        context->stats.macro_avg_probes = macro_stats.avg_probes;
+        context->stats.names = context->names.count;
+        context->stats.name_bytes = context->names.bytes;
+        context->stats.shared_names = context->names.shared;
+        context->stats.shared_name_bytes = context->names.shared_bytes;
+        context->stats.allocations = context->pool.allocations;
+        context->stats.allocated_bytes = context->pool.bytes;
+        context->stats.system_allocations = context->pool.block_count;
+        print_stats(context->out, name, &context->stats);
+        fp = open_file(name, STATS_FILE);
+        if (fp == NULL)
+            print_error_message(FAILED_TO_CREATE_FILE, 0);
+        else
+        {
+            write_stats(fp, name, &context->stats);
+            fclose(fp);
+        }
+    }
+
+    resetSource(&source);
+}
+
+/**
+ * Worker thread: takes jobs off the queue until none are left. Every job gets its own
+ * context whose messages are collected in memory, so they can be printed in order later.
+ * @param arg The shared job queue.
+ * @return Always NULL.
+ */
+static void *assembly_worker(void *arg)
+{
+    jobQueue *queue = (jobQueue *)arg;
+    assemblyJob *job;
+    FILE *out;
+    FILE *diag;
+
+    for (;;)
+    {
+        // Take the next job
+        pthread_mutex_lock(&queue->lock);
+        job = queue->next < queue->count ? &queue->jobs[queue->next++] : NULL;
+        pthread_mutex_unlock(&queue->lock);
+        if (job == NULL)
+            return NULL;
+
+        out = open_memstream(&job->out_text, &job->out_size);
+        diag = open_memstream(&job->diag_text, &job->diag_size);
+        if (out == NULL || diag == NULL)
+        {
+            fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        context = create_context(out, diag);
+        if (context == NULL)
+            exit(EXIT_FAILURE);
+        assemble_file(job->name, queue->options);
+        free_context(context);
+        context = NULL;
+        fclose(out);
+        fclose(diag);
+
+        // Tell the main thread the job's messages are ready
+        pthread_mutex_lock(&queue->lock);
+        job->done = TRUE;
+        pthread_cond_broadcast(&queue->finished);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+/**
+ * Assembles the files on a pool of worker threads. The messages of every file are
+ * printed in command-line order, exactly as a sequential run would print them.
+ * @param names The file names given on the command line.
+ * @param count The number of files.
+ * @param threads The number of worker threads.
+ * @param options The command-line options.
+ * @return TRUE if the threads were started, FALSE otherwise.
+ */
+static int assemble_parallel(char **names, int count, int threads, asmOptions *options)
+{
+    jobQueue queue;
+    pthread_t *workers;
+    int i, started;
+
+    queue.jobs = (assemblyJob *)calloc(count, sizeof(assemblyJob));
+    workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (queue.jobs == NULL || workers == NULL)
+    {
+        free(queue.jobs);
+        free(workers);
+        return FALSE;
+    }
+    for (i = 0; i < count; i++)
+        queue.jobs[i].name = names[i];
+    queue.count = count;
+    queue.next = 0;
+    queue.options = options;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.finished, NULL);
+
+    for (started = 0; started < threads; started++)
+    {
+        if (pthread_create(&workers[started], NULL, assembly_worker, &queue) != 0)
+            break;
+    }
+    if (started == 0)
+    {
+        pthread_mutex_destroy(&queue.lock);
+        pthread_cond_destroy(&queue.finished);
+        free(queue.jobs);
+        free(workers);
+        return FALSE;
+    }
+
+    // Print every job's messages in order, as soon as it and all jobs before it are done
+    for (i = 0; i < count; i++)
+    {
+        pthread_mutex_lock(&queue.lock);
+        while (!queue.jobs[i].done)
+            pthread_cond_wait(&queue.finished, &queue.lock);
+        pthread_mutex_unlock(&queue.lock);
+
+        fwrite(queue.jobs[i].out_text, 1, queue.jobs[i].out_size, stdout);
+        fflush(stdout);
+        fwrite(queue.jobs[i].diag_text, 1, queue.jobs[i].diag_size, stderr);
+        free(queue.jobs[i].out_text);
+        free(queue.jobs[i].diag_text);
+    }
+
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.finished);
+    free(queue.jobs);
+    free(workers);
+    return TRUE;
+}
+
+/**
+ * Assembles files into their output files, on a pool of worker threads or one after the
+ * other in the calling thread. The messages of every file are printed in order either way.
+ * @param names The file names given on the command line.
+ * @param count The number of files.
+ * @param threads The number of worker threads.
+ * @param options The command-line options.
+ * @return TRUE if every file was handled, FALSE if memory allocation failed.
+ */
+int assemble_files(char **names, int count, int threads, asmOptions *options)
+{
+    int i;
+
+    if (threads > count)
+        threads = count;
+
+    // Assemble the files on worker threads, or one after the other in this thread
+    if (threads <= 1 || !assemble_parallel(names, count, threads, options))
+    {
+        for (i = 0; i < count; i++)
+        {
+            context = create_context(stdout, stderr);
+            if (context == NULL)
+                return FALSE;
+            assemble_file(names[i], options);
+            free_context(context);
+            context = NULL;
+        }
+    }
+    return TRUE;
+}
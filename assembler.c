@@ -1,114 +1,64 @@
+#include <stdio.h>
 #include <stdlib.h>
-#include "firstPass.h"
-#include "secondPass.h"
-#include "preAssembler.h"
-#include "vars.h"
-#include "utils.h"
-#include "writeFiles.h"
-
-const char base4[4] = {'*', '#', '%', '!'};
-
-unsigned int data[MAX_MEMORY_SIZE - RESERVED_MEMORY];
-unsigned int instructions[MAX_MEMORY_SIZE - RESERVED_MEMORY];
-Symbol *symbols = NULL;
-external *externals = NULL;
-hashTable *macroTable = NULL;
+#include <string.h>
+#include "globals.h"
+#include "libasm.h"
 
 int main(int argc, char *argv[])
 {
     int i;
-    char *input_filename;
-    FILE *file;
-    FILE *fp;
-    macroTable = initTable(); // Initialize macro table
+    char **names;         // The input file names, in command-line order
+    int count = 0;        // Number of input files
+    int threads = 1;      // Number of files assembled at the same time
+    char *server = NULL;  // Socket path of server mode, "-" for stdin and stdout
+    asmOptions options = {FALSE, FALSE, FALSE, FALSE, FALSE, FALSE};
+
+    names = (char **)malloc(argc * sizeof(char *));
+    if (names == NULL)
+    {
+        fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+        return EXIT_FAILURE;
+    }
 
-    // Loop through each command-line argument
+    // Separate the option flags from the input files
     for (i = 1; i < argc; i++)
     {
-        // Reset global variables for each input file
-        reset_global_vars();
-
-        // Create filename for input file with .as extension
-        input_filename = create_file_name(argv[i], AS_FILE);
-
-        // Open input file for reading
-        file = fopen(input_filename, "r");
-
-        // Check if the file was opened successfully
-        if (file != NULL)
-        {
-            // Print pre-assembling process start message
-            printf("************* Started %s pre_assembling process *************\n\n", input_filename);
-
-            // Free memory allocated for input filename
-            free(input_filename);
-
-            // Create filename for output file with .am extension
-            input_filename = create_file_name(argv[i], AM_FILE);
-
-            // Open output file for writing
-            fp = fopen(input_filename, "w");
-
-            // Check if the output file was created successfully
-            if (fp != NULL)
-            {
-                // Perform pre-assembly process
-                preAssembler(file, fp);
-
-                // Close output file
-                fclose(fp);
-
-                // Reopen output file for reading
-                fp = fopen(input_filename, "r");
-
-                // Check if there were no errors in pre-assembly process
-                if (!has_error)
-                {
-                    // Print assembling process start message
-                    printf("\n************* Started %s assembling process *************\n\n", input_filename);
-
-                    // Perform first pass of assembly process
-                    first_pass(fp);
-                }
-
-                // Check if there were no errors in first pass
-                if (!has_error)
-                {
-                    // Rewind output file to beginning
-                    rewind(fp);
-
-                    // Perform second pass of assembly process
-                    second_pass(fp);
-                }
-
-                // Check if there were no errors in second pass
-                if (!has_error)
-                {
-                    // Write output files
-                    write_output_files(argv[i]);
+        if (strcmp(argv[i], "--emit-am") == 0)
+            options.emit_am = TRUE;
+        else if (strcmp(argv[i], "--one-pass") == 0)
+            options.one_pass = TRUE;
+        else if (strcmp(argv[i], "--stats") == 0)
+            options.stats = TRUE;
+        else if (strcmp(argv[i], "--large-memory") == 0)
+            options.large_memory = TRUE;
+        else if (strcmp(argv[i], "-O") == 0)
+            options.optimize = TRUE;
+        else if (strcmp(argv[i], "--pool-strings") == 0)
+            options.pool_strings = TRUE;
+        else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+            server = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0')
+            threads = atoi(&argv[i][2]);
+        else if (strncmp(argv[i], "--", 2) != 0)
+            names[count++] = argv[i];
+    }
+    if (threads < 1)
+        threads = 1;
 
-                    // Print assembling process finish message
-                    printf("\n************* Finished %s assembling process *************\n\n", input_filename);
-                }
-                else
-                {
-                    // Print assembling process Failed message
-                    printf("\n************* Failed %s assembling process *************\n\n", input_filename);
-                }
+    // Serve jobs until the input ends, instead of assembling the files given
+    if (server != NULL)
+    {
+        free(names);
+        if (strcmp(server, "-") == 0)
+            return serve_stream(stdin, stdout, &options) ? 0 : EXIT_FAILURE;
+        return serve_socket(server, threads, &options) ? 0 : EXIT_FAILURE;
+    }
 
-                // Close output file
-                fclose(fp);
-                free(input_filename);
-            }
-            else
-                print_error_message(FAILED_TO_CREATE_FILE, 0);
-        }
-        else
-        {
-            print_error_message(CANNOT_OPEN_FILE, 0);
-        }
-        reset_global_vars();
+    if (!assemble_files(names, count, threads, &options))
+        return EXIT_FAILURE;
 
-        return 0;
-    }
+    free(names);
+    return 0;
 }
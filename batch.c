@@ -0,0 +1,238 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "batch.h"
+#include "blockCache.h"
+
+typedef struct batchQueue
+{
+    emuBatch *batch;        // The program and its runs
+    long *written;          // Memory cells some instruction of the image writes, each once
+    long written_count;     // Number of written cells
+    int next;               // Index of the next run to hand out
+    int failed;             // TRUE if a worker ran out of memory
+    pthread_mutex_t lock;   // Protects next and failed
+} batchQueue;               // Definition of the work shared by the worker threads
+
+/**
+ * Tells if an instruction stores into its destination operand.
+ * @param op The decoded instruction.
+ * @return TRUE if it writes a cell, FALSE otherwise.
+ */
+static int writes_cell(emuOp *op)
+{
+    switch (op->handler)
+    {
+    case MOV_OP:
+    case ADD_OP:
+    case SUB_OP:
+    case NOT_OP:
+    case CLR_OP:
+    case LEA_OP:
+    case INC_OP:
+    case DEC_OP:
+    case RED_OP:
+        return !(op->flags & EMU_TARGET_CONST);
+    default:
+        return FALSE;
+    }
+}
+
+/**
+ * Lists the memory cells the image's code can write. Operands are resolved when
+ * the code is decoded, so this is every cell a run can change as long as it does
+ * not write into its code.
+ * @param queue Receives the cells.
+ * @param image The image.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+static int find_written_cells(batchQueue *queue, emuImage *image)
+{
+    char *seen = (char *)calloc(EMU_REGISTERS + image->memory_words, 1);
+    emuOp *op;
+    long i;
+
+    queue->written = (long *)malloc((image->code_words + 1) * sizeof(long));
+    queue->written_count = 0;
+    if (seen == NULL || queue->written == NULL)
+    {
+        free(seen);
+        return FALSE;
+    }
+    for (i = 0; i < image->code_words; i += op->length)
+    {
+        op = &image->ops[i];
+        if (writes_cell(op) && op->dst >= EMU_REGISTERS && !seen[op->dst])
+        {
+            seen[op->dst] = TRUE;
+            queue->written[queue->written_count++] = op->dst;
+        }
+    }
+    free(seen);
+    return TRUE;
+}
+
+/**
+ * Brings a used machine back to the state init_machine leaves it in. Only the
+ * cells the code writes are restored, unless the program wrote into its code.
+ * @param machine The machine.
+ * @param cache The machine's block cache.
+ * @param queue The shared work, with the written cells.
+ */
+static void reset_machine(emuMachine *machine, blockCache *cache, batchQueue *queue)
+{
+    emuImage *image = machine->image;
+    unsigned int *cells = machine->cells;
+    long i;
+
+    if (machine->ops != image->ops)
+    {
+        free(machine->ops);
+        machine->ops = image->ops;
+        memcpy(cells + EMU_REGISTERS, image->words, image->memory_words * sizeof(unsigned int));
+        flush_block_cache(cache);
+    }
+    else
+    {
+        for (i = 0; i < queue->written_count; i++)
+            cells[queue->written[i]] = image->words[queue->written[i] - EMU_REGISTERS];
+    }
+    memset(cells, 0, EMU_REGISTERS * sizeof(unsigned int));
+    machine->pc = RESERVED_MEMORY;
+    machine->zero = FALSE;
+    machine->depth = 0;
+    machine->input_position = 0;
+    machine->output_length = 0;
+    machine->steps = 0;
+    machine->status = EMU_RUNNING;
+}
+
+/**
+ * Worker thread: takes runs off the queue until none are left, all on one
+ * machine and block cache of its own that are reset between runs.
+ * @param arg The shared queue.
+ * @return Always NULL.
+ */
+static void *batch_worker(void *arg)
+{
+    batchQueue *queue = (batchQueue *)arg;
+    emuBatch *batch = queue->batch;
+    emuMachine machine;
+    blockCache cache;
+    emuRun *run;
+    int used = FALSE, ok;
+
+    ok = init_machine(&machine, batch->image);
+    if (ok && !init_block_cache(&cache, batch->image))
+    {
+        free_machine(&machine);
+        ok = FALSE;
+    }
+    if (!ok)
+    {
+        pthread_mutex_lock(&queue->lock);
+        queue->failed = TRUE;
+        pthread_mutex_unlock(&queue->lock);
+        return NULL;
+    }
+    machine.numbers = batch->numbers;
+
+    for (;;)
+    {
+        // Take the next run
+        pthread_mutex_lock(&queue->lock);
+        run = queue->next < batch->count && !queue->failed ? &batch->runs[queue->next++] : NULL;
+        pthread_mutex_unlock(&queue->lock);
+        if (run == NULL)
+            break;
+
+        if (used)
+            reset_machine(&machine, &cache, queue);
+        used = TRUE;
+        machine.input = run->tape.text;
+        machine.input_length = run->tape.length;
+        run->status = batch->single_step ? run_machine(&machine, batch->max_steps)
+                                         : run_blocks(&machine, &cache, batch->max_steps);
+        run->steps = machine.steps;
+        run->pc = machine.pc;
+
+        // The run keeps what it printed, the machine starts a new output buffer
+        free(run->output);
+        run->output = machine.output;
+        run->output_length = machine.output_length;
+        machine.output = (char *)malloc(EMU_OUTPUT_SIZE);
+        machine.output_capacity = EMU_OUTPUT_SIZE;
+        if (machine.output == NULL)
+        {
+            pthread_mutex_lock(&queue->lock);
+            queue->failed = TRUE;
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+    }
+
+    free_block_cache(&cache);
+    free_machine(&machine);
+    return NULL;
+}
+
+/**
+ * Runs the program of a batch on every tape, on a pool of worker threads that
+ * share the image. Each run keeps its status, step count and output.
+ * @param batch The batch.
+ * @param threads The number of worker threads.
+ * @return TRUE if every run was made, FALSE if memory allocation or starting the threads failed.
+ */
+int run_batch(emuBatch *batch, int threads)
+{
+    batchQueue queue;
+    pthread_t *workers;
+    int started;
+
+    if (threads > batch->count)
+        threads = batch->count;
+    if (threads < 1)
+        return TRUE;
+    workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (workers == NULL || !find_written_cells(&queue, batch->image))
+    {
+        free(workers);
+        return FALSE;
+    }
+    queue.batch = batch;
+    queue.next = 0;
+    queue.failed = FALSE;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    for (started = 0; started < threads; started++)
+    {
+        if (pthread_create(&workers[started], NULL, batch_worker, &queue) != 0)
+            break;
+    }
+    for (threads = 0; threads < started; threads++)
+        pthread_join(workers[threads], NULL);
+
+    pthread_mutex_destroy(&queue.lock);
+    free(queue.written);
+    free(workers);
+    return started > 0 && !queue.failed && queue.next == batch->count;
+}
+
+/**
+ * Frees the tapes and outputs of a batch's runs, and the runs themselves.
+ * @param batch The batch.
+ */
+void free_batch_runs(emuBatch *batch)
+{
+    int i;
+
+    for (i = 0; i < batch->count; i++)
+    {
+        close_input(&batch->runs[i].tape);
+        free(batch->runs[i].tape_name);
+        free(batch->runs[i].output);
+    }
+    free(batch->runs);
+    batch->runs = NULL;
+    batch->count = 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Measures the I/O saved by keeping the expanded source in memory.
+# Usage: bench/amRoundTrip.sh [lines] [asm binary] [reference asm binary]
+# Every generated line survives pre-assembly and is visited by both passes
+# without using memory words, so the input can be made as large as wanted.
+# When a reference binary (e.g. one built before the in-memory pipeline) is
+# given, it is timed on the same input as well.
+
+LINES=${1:-200000}
+ASM=${2:-./asm}
+REF=$3
+DIR=$(mktemp -d)
+
+# Generate the large input file
+awk -v n="$LINES" 'BEGIN {
+    print "mcr m_body"
+    print "    .entry MAIN"
+    print "endmcr"
+    print "MAIN: hlt"
+    for (i = 0; i < n; i++)
+        print (i % 2) ? "m_body" : ".entry MAIN"
+}' > "$DIR/big.as"
+
+# Runs a binary with the given flags and prints the elapsed wall time
+run()
+{
+    start=$(date +%s.%N)
+    "$@" "$DIR/big" > /dev/null 2>&1
+    end=$(date +%s.%N)
+    awk -v s="$start" -v e="$end" 'BEGIN { printf "%.3f", e - s }'
+}
+
+echo "input lines: $LINES"
+echo "in-memory (no .am):   $(run "$ASM") s"
+echo "in-memory + --emit-am: $(run "$ASM" --emit-am) s"
+if [ -n "$REF" ]; then
+    echo "reference binary:      $(run "$REF") s"
+fi
+
+rm -rf "$DIR"
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vars.h"
+#include "utils.h"
+#include "writeFiles.h"
+
+/*
+ * Object file encoding benchmark.
+ * Encodes WORDS words into object file lines, ROUNDS times, the way
+ * write_output_ob did before (convert_to_base_4, fprintf and free for every
+ * word) and with the table encoder into a large buffer. Both write to a
+ * temporary file, and the two outputs are compared. Reports words per second.
+ */
+
+#define WORDS 4096 // Number of words encoded in every round
+#define ROUNDS 500 // Number of rounds
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+/**
+ * Returns the elapsed CPU time in seconds since the given start.
+ */
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Returns the whole content of a file, rewinding it first.
+ */
+static char *read_back(FILE *fp, long *size)
+{
+    char *text;
+
+    fflush(fp);
+    *size = ftell(fp);
+    text = (char *)checkedAlloc(*size + 1);
+    rewind(fp);
+    if (fread(text, 1, *size, fp) != (size_t)*size)
+    {
+        fprintf(stderr, "base4Bench: cannot read back the output\n");
+        exit(EXIT_FAILURE);
+    }
+    return text;
+}
+
+int main(void)
+{
+    static char buffer[OB_BUFFER_SIZE];
+    static unsigned int words[WORDS];
+    FILE *ref_fp = tmpfile();
+    FILE *table_fp = tmpfile();
+    char *ref_text, *table_text, *end, *param;
+    long ref_size, table_size;
+    long i, j;
+    clock_t start;
+    double ref_time, table_time;
+
+    if (ref_fp == NULL || table_fp == NULL)
+    {
+        fprintf(stderr, "base4Bench: cannot create temporary files\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every 14 bit pattern shows up, in a scrambled order
+    for (i = 0; i < WORDS; i++)
+        words[i] = (unsigned int)(i * 2654435761UL) & 0x3FFF;
+
+    // Reference: one allocation, one fprintf and one free per word
+    start = clock();
+    for (j = 0; j < ROUNDS; j++)
+        for (i = 0; i < WORDS; i++)
+        {
+            param = convert_to_base_4(words[i]);
+            fprintf(ref_fp, "%ld\t%s\n", RESERVED_MEMORY + i, param);
+            free(param);
+        }
+    ref_time = seconds_since(start);
+
+    // Table encoder into a buffer flushed with large writes
+    start = clock();
+    end = buffer;
+    for (j = 0; j < ROUNDS; j++)
+        for (i = 0; i < WORDS; i++)
+        {
+            if (end - buffer > OB_BUFFER_SIZE - OB_LINE_MAX)
+            {
+                fwrite(buffer, 1, end - buffer, table_fp);
+                end = buffer;
+            }
+            end = encode_ob_line(end, RESERVED_MEMORY + i, words[i]);
+        }
+    fwrite(buffer, 1, end - buffer, table_fp);
+    table_time = seconds_since(start);
+
+    ref_text = read_back(ref_fp, &ref_size);
+    table_text = read_back(table_fp, &table_size);
+    if (ref_size != table_size || memcmp(ref_text, table_text, ref_size) != 0)
+    {
+        fprintf(stderr, "base4Bench: the encoders produced different output\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("words: %d, rounds: %d\n", WORDS, ROUNDS);
+    printf("%-28s %18s\n", "encoder", "words/sec");
+    printf("%-28s %18.0f\n", "convert_to_base_4 + fprintf", (double)WORDS * ROUNDS / ref_time);
+    printf("%-28s %18.0f\n", "lookup table + buffer", (double)WORDS * ROUNDS / table_time);
+
+    free(ref_text);
+    free(table_text);
+    fclose(ref_fp);
+    fclose(table_fp);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Batch emulator benchmark.
+# Usage: bench/batchBench.sh [tapes] [threads] [asm binary] [asmemu binary]
+# Assembles a program that reads its tape with red, sums the characters and
+# prints the sum and the count, then runs it on every tape of a generated list
+# with --batch --scaling and reports the instructions run per second on 1, 2,
+# 4... up to the given number of threads.
+
+TAPES=${1:-1000}
+THREADS=${2:-4}
+ASM=${3:-./asm}
+EMU=${4:-./asmemu}
+DIR=$(mktemp -d)
+
+cat > "$DIR/sum.as" <<END
+MAIN: red r1
+    cmp #-1, r1
+    bne BODY
+    prn SUM
+    prn COUNT
+    hlt
+BODY: add r1, SUM
+    inc COUNT
+    jmp MAIN
+SUM: .data 0
+COUNT: .data 0
+END
+
+i=1
+while [ $i -le "$TAPES" ]; do
+    awk -v n=$i 'BEGIN { for (j = 0; j < 200 + n % 300; j++) printf "%c", 33 + (j * n) % 90 }' > "$DIR/tape$i"
+    echo "$DIR/tape$i" >> "$DIR/tapes"
+    i=$((i + 1))
+done
+
+"$ASM" "$DIR/sum" > /dev/null || { rm -rf "$DIR"; exit 1; }
+"$EMU" --numbers --stats --scaling -j "$THREADS" --batch "$DIR/tapes" "$DIR/sum" > /dev/null
+status=$?
+rm -rf "$DIR"
+exit $status
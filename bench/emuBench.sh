@@ -0,0 +1,50 @@
+#!/bin/sh
+# Emulator speed benchmark.
+# Usage: bench/emuBench.sh [outer loops] [asm binary] [asmemu binary]
+# Assembles a program of nested counting loops whose body mixes register,
+# immediate, direct and index operands, runs it with --stats a basic block at a
+# time and then with --single-step, and reports the instructions run per second
+# of both and the speedup of the block cache. The program prints its checksum,
+# which must be the same on every run.
+
+LOOPS=${1:-20}
+ASM=${2:-./asm}
+EMU=${3:-./asmemu}
+DIR=$(mktemp -d)
+
+cat > "$DIR/loops.as" <<END
+.define outer = $LOOPS
+.define inner = 1000
+MAIN: mov #outer, r0
+OUTER: mov #inner, r1
+MIDDLE: mov #inner, r2
+INNER: add r2, r3
+    sub #3, r4
+    cmp r3, r4
+    mov r3, ACC
+    add ACC, r5
+    mov TABLE[2], r6
+    dec r2
+    bne INNER
+    dec r1
+    bne MIDDLE
+    dec r0
+    bne OUTER
+    prn r5
+    hlt
+ACC: .data 0
+TABLE: .data 1, 2, 3
+END
+
+"$ASM" "$DIR/loops" > /dev/null || { rm -rf "$DIR"; exit 1; }
+"$EMU" --numbers --stats "$DIR/loops" 2> "$DIR/blocks.txt" > "$DIR/blocks.out"
+status=$?
+"$EMU" --numbers --stats --single-step "$DIR/loops" 2> "$DIR/single.txt" > "$DIR/single.out" || status=1
+cat "$DIR/blocks.out" "$DIR/blocks.txt"
+echo "single-step: $(cat "$DIR/single.txt")"
+cmp -s "$DIR/blocks.out" "$DIR/single.out" || { echo "block and single-step output differ" >&2; status=1; }
+rate() { sed -n 's/.*(\([0-9.]*\) million instructions.*/\1/p' "$1"; }
+awk -v blocks="$(rate "$DIR/blocks.txt")" -v single="$(rate "$DIR/single.txt")" \
+    'BEGIN { if (single > 0) printf "block cache speedup: %.2fx\n", blocks / single }'
+rm -rf "$DIR"
+exit $status
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+
+/*
+ * Synthetic assembly program generator.
+ * Writes a program to stdout that is fully determined by the options, so the
+ * same options always produce the same program and results can be compared
+ * across changes. Generation stops at the requested number of lines or when
+ * the memory image (the word budget) is full, whichever comes first; a summary
+ * is printed to stderr.
+ *
+ * Options (all percentages are 0-100):
+ *   -n lines       number of source lines to generate          (default 1000)
+ *   -l percent     lines that carry a label                    (default 30)
+ *   -m count       number of macros defined                    (default 8)
+ *   -s lines       lines in each macro body                    (default 4)
+ *   -c percent     lines that call a macro                     (default 5)
+ *   -d percent     lines that are .data directives             (default 10)
+ *   -t percent     lines that are .string directives           (default 5)
+ *   -v count       values in each .data directive              (default 4)
+ *   -e percent     label operands that name an external        (default 10)
+ *   -E percent     labels that are also declared .entry        (default 10)
+ *   -f percent     label operands that reference a later label (default 50)
+ *   -w words       word budget of the memory image             (default MAX_MEMORY_SIZE - RESERVED_MEMORY)
+ *   -r seed        seed of the pseudo random sequence          (default 1)
+ */
+
+#define EXTERNALS 8       // Number of external symbols declared
+#define STRING_LENGTH 12  // Length of every generated .string
+#define MAX_LINE_WORDS 5  // Most words a generated source line can take
+#define FORWARD_WINDOW 48 // Furthest line a forward reference can reach
+
+typedef struct genOptions
+{
+    long lines;
+    int label_pct;
+    int macros;
+    int macro_size;
+    int call_pct;
+    int data_pct;
+    int string_pct;
+    int data_values;
+    int extern_pct;
+    int entry_pct;
+    int forward_pct;
+    long words;
+    unsigned long seed;
+} genOptions; // Definition of the generator's options
+
+static unsigned long state; // State of the pseudo random sequence
+
+/**
+ * Returns the next pseudo random number in [0, limit). The sequence is the same
+ * on every platform, unlike rand().
+ */
+static long next_random(long limit)
+{
+    state = (state * 6364136223846793005UL + 1442695040888963407UL) & 0xFFFFFFFFFFFFFFFFUL;
+    return (long)((state >> 33) % (unsigned long)limit);
+}
+
+/**
+ * Returns TRUE with the given probability, in percent.
+ */
+static int chance(int percent)
+{
+    return next_random(100) < percent;
+}
+
+/**
+ * Chooses the label an operand refers to: an external, a label defined later
+ * in the program or one defined earlier, according to the options.
+ * @param buf Receives the label name.
+ * @param line The line the operand is on.
+ * @param labeled Marks the lines that carry a label.
+ * @param opt The generator's options.
+ */
+static void pick_label(char *buf, long line, char *labeled, genOptions *opt)
+{
+    long i;
+
+    if (chance(opt->extern_pct))
+    {
+        sprintf(buf, "X%ld", next_random(EXTERNALS));
+        return;
+    }
+    if (chance(opt->forward_pct))
+    {
+        for (i = line + 1 + next_random(16); i < opt->lines && i <= line + FORWARD_WINDOW; i++)
+            if (labeled[i])
+                break;
+        if (i > line + FORWARD_WINDOW)
+            i = -1;
+    }
+    else
+    {
+        for (i = line - 1 - next_random(16); i >= 0; i--)
+            if (labeled[i])
+                break;
+    }
+    if (i < 0 || i >= opt->lines)
+        strcpy(buf, "START"); // No label in that direction, use the first line's label
+    else
+        sprintf(buf, "L%ld", i);
+}
+
+/**
+ * Writes one command line that refers to labels.
+ * @param line The line being written.
+ * @param labeled Marks the lines that carry a label.
+ * @param opt The generator's options.
+ * @return The number of words the command takes.
+ */
+static int write_command(long line, char *labeled, genOptions *opt)
+{
+    char a[SYMBOL_MAX_SIZE + 1], b[SYMBOL_MAX_SIZE + 1];
+
+    pick_label(a, line, labeled, opt);
+    switch (next_random(8))
+    {
+    case 0:
+        printf("mov %s, r%ld\n", a, next_random(8));
+        return 3;
+    case 1:
+        printf("cmp #%ld, %s\n", next_random(200) - 100, a);
+        return 3;
+    case 2:
+        printf("add r%ld, r%ld\n", next_random(8), next_random(8));
+        return 2;
+    case 3:
+        printf("lea %s, r%ld\n", a, next_random(8));
+        return 3;
+    case 4:
+        printf("%s %s\n", next_random(2) ? "jmp" : "bne", a);
+        return 2;
+    case 5:
+        printf("inc %s\n", a);
+        return 2;
+    case 6:
+        printf("mov %s[size], r%ld\n", a, next_random(8));
+        return 4;
+    default:
+        pick_label(b, line, labeled, opt);
+        printf("sub %s, %s\n", a, b);
+        return 3;
+    }
+}
+
+/**
+ * Reads the options from the command line.
+ * @return TRUE if every option was valid, FALSE otherwise.
+ */
+static int parse_options(int argc, char *argv[], genOptions *opt)
+{
+    int i;
+    long value;
+
+    opt->lines = 1000;
+    opt->label_pct = 30;
+    opt->macros = 8;
+    opt->macro_size = 4;
+    opt->call_pct = 5;
+    opt->data_pct = 10;
+    opt->string_pct = 5;
+    opt->data_values = 4;
+    opt->extern_pct = 10;
+    opt->entry_pct = 10;
+    opt->forward_pct = 50;
+    opt->words = MAX_MEMORY_SIZE - RESERVED_MEMORY;
+    opt->seed = 1;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+            return FALSE;
+        value = atol(argv[i + 1]);
+        if (value < 0)
+            return FALSE;
+        switch (argv[i][1])
+        {
+        case 'n': opt->lines = value; break;
+        case 'l': opt->label_pct = (int)value; break;
+        case 'm': opt->macros = (int)value; break;
+        case 's': opt->macro_size = (int)value; break;
+        case 'c': opt->call_pct = (int)value; break;
+        case 'd': opt->data_pct = (int)value; break;
+        case 't': opt->string_pct = (int)value; break;
+        case 'v': opt->data_values = value > 0 ? (int)value : 1; break;
+        case 'e': opt->extern_pct = (int)value; break;
+        case 'E': opt->entry_pct = (int)value; break;
+        case 'f': opt->forward_pct = (int)value; break;
+        case 'w': opt->words = value; break;
+        case 'r': opt->seed = (unsigned long)value; break;
+        default: return FALSE;
+        }
+    }
+    return i == argc;
+}
+
+int main(int argc, char *argv[])
+{
+    genOptions opt;
+    char *labeled;        // Marks the lines that carry a label
+    long line;            // Current line of the program body
+    long written = 0;     // Source lines written
+    long words = 0;       // Words used in the memory image
+    long calls = 0;       // Macro calls written
+    int i, k, kind;
+
+    if (!parse_options(argc, argv, &opt))
+    {
+        fprintf(stderr, "usage: %s [-n lines] [-l label%%] [-m macros] [-s macro lines] [-c call%%] [-d data%%] "
+                        "[-t string%%] [-v values] [-e extern%%] [-E entry%%] [-f forward%%] [-w words] [-r seed]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    state = opt.seed;
+    if (opt.macros == 0)
+        opt.call_pct = 0;
+
+    labeled = (char *)calloc(opt.lines + 1, 1);
+    if (labeled == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        return EXIT_FAILURE;
+    }
+    for (line = 0; line < opt.lines; line++)
+        labeled[line] = (char)chance(opt.label_pct);
+
+    // Declarations: externals, a constant and the macros, which only use registers and immediates
+    for (i = 0; i < EXTERNALS; i++)
+        printf(".extern X%d\n", i);
+    printf(".define size = 2\n");
+    written += EXTERNALS + 1;
+    for (k = 0; k < opt.macros; k++)
+    {
+        printf("mcr m%d\n", k);
+        for (i = 0; i < opt.macro_size; i++)
+        {
+            if (i % 2)
+                printf("    add r%d, r%d\n", (k + i) % 8, (k + i + 3) % 8);
+            else
+                printf("    prn #%d\n", k + i);
+        }
+        printf("endmcr\n");
+        written += opt.macro_size + 2;
+    }
+
+    // The program body, stopping before the memory image is full. Room is left for defining
+    // the labels that forward references past the last line may still reach.
+    printf("START: hlt\n");
+    words++;
+    written++;
+    for (line = 0; line < opt.lines && written < opt.lines; line++)
+    {
+        if (words + MAX_LINE_WORDS + opt.data_values + STRING_LENGTH + 1 + FORWARD_WINDOW > opt.words)
+            break;
+        if (labeled[line])
+            printf("L%ld: ", line);
+
+        kind = (int)next_random(100);
+        if (kind < opt.data_pct)
+        {
+            printf(".data %ld", next_random(1000) - 500);
+            for (i = 1; i < opt.data_values; i++)
+                printf(", %ld", next_random(1000) - 500);
+            printf("\n");
+            words += opt.data_values;
+        }
+        else if (kind < opt.data_pct + opt.string_pct)
+        {
+            printf(".string \"");
+            for (i = 0; i < STRING_LENGTH; i++)
+                putchar('a' + (int)next_random(26));
+            printf("\"\n");
+            words += STRING_LENGTH + 1;
+        }
+        else if (kind < opt.data_pct + opt.string_pct + opt.call_pct && !labeled[line])
+        {
+            printf("m%ld\n", next_random(opt.macros));
+            words += 2L * opt.macro_size;
+            calls++;
+        }
+        else
+            words += write_command(line, labeled, &opt);
+        written++;
+
+        if (labeled[line] && chance(opt.entry_pct))
+        {
+            printf(".entry L%ld\n", line);
+            written++;
+        }
+    }
+
+    // Labels that are referenced but past the end of the generated body still need a definition
+    for (k = 0; line < opt.lines && k <= FORWARD_WINDOW; line++, k++)
+    {
+        if (labeled[line])
+        {
+            printf("L%ld: .data 0\n", line);
+            words++;
+            written++;
+        }
+    }
+
+    fprintf(stderr, "generated %ld lines, %ld macro calls, about %ld words\n", written, calls, words);
+    free(labeled);
+    return EXIT_SUCCESS;
+}
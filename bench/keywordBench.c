@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+#include "vars.h"
+
+/*
+ * Keyword lookup benchmark.
+ * Classifies a token mix like the one the passes see in a typical program
+ * (operations, registers, labels, directives, macro names and constants) with
+ * the generated keyword hash and with the linear scans of the three lookup
+ * tables that is_reserved and the find_*_by_name functions used before, and
+ * checks that both give the same answers.
+ */
+
+#define ROUNDS 2000000 // Passes over the token mix
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+/* Tokens in roughly the proportions of a generated program: most lines are an
+ * operation with a label or register operand, some carry a label, a few are
+ * directives or macro calls. */
+static char *tokens[] = {
+    "mov", "L12", "r3", "cmp", "X4", "add", "r1", "r6", "L40", "lea", "START", "r0",
+    "jmp", "L7", "inc", "L311", "mov", "size", "r2", "sub", "L5", "L90", ".data",
+    "L77", "bne", "X0", ".string", "prn", "red", "r7", "m3", "L1024", ".entry",
+    "hlt", "clr", "r4", "dec", "LOOP", ".extern", "X7", "jsr", "FUNC", "rts", "not",
+    "r5", ".define", "sz", "mcr", "endmcr", "LENGTH", "r8", "movx", "a"};
+
+#define TOKEN_COUNT ((int)(sizeof(tokens) / sizeof(tokens[0])))
+
+static char *operation_names[] = {"mov", "cmp", "add", "sub", "not", "clr", "lea", "inc",
+                             "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "hlt", NULL};
+static char *directive_names[] = {".define", ".string", ".data", ".entry", ".extern", NULL};
+static char *register_names[] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", NULL};
+
+/**
+ * Returns the index of a name in a NULL terminated table, or -1.
+ */
+static int linear_find(char **table, char *name)
+{
+    int i;
+
+    for (i = 0; table[i] != NULL; i++)
+        if (strcmp(table[i], name) == 0)
+            return i;
+    return -1;
+}
+
+/**
+ * Classifies a token the way is_reserved did before the keyword hash.
+ * @return 1 for a directive, 2 for a register, 3 for an operation, 0 otherwise.
+ */
+static int linear_classify(char *name)
+{
+    if (linear_find(directive_names, name) != -1)
+        return 1;
+    if (linear_find(register_names, name) != -1)
+        return 2;
+    if (linear_find(operation_names, name) != -1)
+        return 3;
+    return 0;
+}
+
+/**
+ * Classifies a token with the keyword hash, with the same results as linear_classify.
+ */
+static int hash_classify(char *name)
+{
+    const keywordEntry *keyword = find_keyword(name);
+
+    if (keyword == NULL)
+        return 0;
+    return keyword->kind == INSTRUCTION_KW ? 1 : keyword->kind == REGISTER_KW ? 2 : 3;
+}
+
+/**
+ * Finds an operation with the keyword hash, as an index into operation_names.
+ */
+static int hash_find_operation(char *name)
+{
+    opcode operation = find_operation_by_name(name);
+    return operation == NONE_OP ? -1 : (int)operation;
+}
+
+/**
+ * Returns the elapsed CPU time in seconds since the given start.
+ */
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    long i, sum;
+    int t;
+    clock_t start;
+    double linear_time, hash_time, op_linear_time, op_hash_time;
+    double lookups = (double)ROUNDS * TOKEN_COUNT;
+
+    context = create_context(stdout, stderr);
+    if (context == NULL)
+        return EXIT_FAILURE;
+
+    for (t = 0; t < TOKEN_COUNT; t++)
+    {
+        if (linear_classify(tokens[t]) != hash_classify(tokens[t]) ||
+            linear_find(operation_names, tokens[t]) != hash_find_operation(tokens[t]))
+        {
+            printf("mismatch on \"%s\"\n", tokens[t]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    sum = 0;
+    start = clock();
+    for (i = 0; i < ROUNDS; i++)
+        for (t = 0; t < TOKEN_COUNT; t++)
+            sum += linear_classify(tokens[t]);
+    linear_time = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < ROUNDS; i++)
+        for (t = 0; t < TOKEN_COUNT; t++)
+            sum -= hash_classify(tokens[t]);
+    hash_time = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < ROUNDS; i++)
+        for (t = 0; t < TOKEN_COUNT; t++)
+            sum += linear_find(operation_names, tokens[t]);
+    op_linear_time = seconds_since(start);
+
+    start = clock();
+    for (i = 0; i < ROUNDS; i++)
+        for (t = 0; t < TOKEN_COUNT; t++)
+            sum -= hash_find_operation(tokens[t]);
+    op_hash_time = seconds_since(start);
+
+    printf("%d tokens x %d rounds\n", TOKEN_COUNT, ROUNDS);
+    printf("%-22s %12s %12s %8s\n", "lookup", "linear ns", "hash ns", "speedup");
+    printf("%-22s %12.2f %12.2f %7.1fx\n", "is_reserved", linear_time * 1e9 / lookups, hash_time * 1e9 / lookups,
+           linear_time / hash_time);
+    printf("%-22s %12.2f %12.2f %7.1fx\n", "find_operation_by_name", op_linear_time * 1e9 / lookups,
+           op_hash_time * 1e9 / lookups, op_linear_time / op_hash_time);
+
+    free_context(context);
+    return sum == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
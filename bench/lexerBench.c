@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "utils.h"
+#include "lineScanner.h"
+#include "vars.h"
+
+/*
+ * Lexer throughput benchmark.
+ * Reads a program (from bench/genProgram) from stdin and splits every line
+ * into word and comma tokens ROUNDS times: character by character with
+ * MOVE_TO_NOT_WHITE and find_next_token, the way the first pass parsers did,
+ * and with the line scanner. The token counts of both are compared. Reports
+ * lines and megabytes per second.
+ */
+
+#define ROUNDS 50 // Passes over the program
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+/**
+ * Returns the elapsed CPU time in seconds since the given start.
+ */
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Splits a line into tokens character by character.
+ * @return The number of tokens.
+ */
+static int char_tokens(char *line)
+{
+    char token[LINESIZE + 2];
+    int index = 0, count = 0;
+
+    MOVE_TO_NOT_WHITE(line, index);
+    while (!is_end_of_line(line[index]))
+    {
+        if (line[index] == ',')
+            index++;
+        else
+            index += find_next_token(&line[index], token, ',');
+        count++;
+        MOVE_TO_NOT_WHITE(line, index);
+    }
+    return count;
+}
+
+int main(void)
+{
+    char buffer[LINESIZE + 2];
+    char **lines = NULL;
+    long count = 0, capacity = 0, bytes = 0, i, r;
+    long char_count = 0, scan_count = 0;
+    lineScan scan;
+    clock_t start;
+    double char_time, scan_time;
+
+    context = create_context(stdout, stderr);
+    if (context == NULL)
+        return EXIT_FAILURE;
+
+    // Keep the program in memory, one line per string, cut like the pre-assembler does
+    while (fgets(buffer, sizeof(buffer), stdin) != NULL)
+    {
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            lines = (char **)realloc(lines, capacity * sizeof(char *));
+            if (lines == NULL)
+                return EXIT_FAILURE;
+        }
+        lines[count] = (char *)checkedAlloc(strlen(buffer) + 1 + SCAN_PADDING);
+        strcpy(lines[count++], buffer);
+        bytes += (long)strlen(buffer);
+    }
+    if (count == 0)
+    {
+        fprintf(stderr, "usage: bench/genProgram [options] | %s\n", "bench/lexerBench");
+        return EXIT_FAILURE;
+    }
+
+    start = clock();
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < count; i++)
+            char_count += char_tokens(lines[i]);
+    char_time = seconds_since(start);
+
+    start = clock();
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < count; i++)
+        {
+            scan_line(lines[i], &scan);
+            scan_count += scan.count;
+        }
+    scan_time = seconds_since(start);
+
+    if (char_count != scan_count)
+    {
+        printf("token counts differ: %ld by character, %ld scanned\n", char_count, scan_count);
+        return EXIT_FAILURE;
+    }
+
+    printf("%ld lines, %ld bytes, %ld tokens per pass, %d passes, scanner: %s\n", count, bytes,
+           scan_count / ROUNDS, ROUNDS, scanner_name());
+    printf("%-14s %14s %10s\n", "lexer", "lines/s", "MB/s");
+    printf("%-14s %14.0f %10.1f\n", "by character", count * ROUNDS / char_time, bytes * ROUNDS / char_time / 1e6);
+    printf("%-14s %14.0f %10.1f\n", "line scanner", count * ROUNDS / scan_time, bytes * ROUNDS / scan_time / 1e6);
+
+    for (i = 0; i < count; i++)
+        free(lines[i]);
+    free(lines);
+    free_context(context);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libasm.h"
+
+/*
+ * In-process assembly benchmark.
+ * Reads a program from stdin and assembles it from memory ROUNDS times with
+ * asm_assemble: once with a new session for every call, and once with one
+ * session (and one result) reused for all calls, the way a test harness
+ * assembling many snippets would use the library. Reports the latency of a
+ * call and checks that both ways give the same image.
+ */
+
+#define ROUNDS 2000 // Calls timed in each mode
+
+/**
+ * Returns the current time in seconds.
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Reads all of stdin.
+ * @return The text, or NULL if memory allocation failed.
+ */
+static char *read_stdin(long *length)
+{
+    long capacity = 65536;
+    char *text = (char *)malloc(capacity);
+    size_t count;
+
+    *length = 0;
+    while (text != NULL && (count = fread(text + *length, 1, capacity - *length, stdin)) > 0)
+    {
+        *length += (long)count;
+        if (*length == capacity)
+        {
+            capacity *= 2;
+            text = (char *)realloc(text, capacity);
+        }
+    }
+    return text;
+}
+
+int main(void)
+{
+    asmOptions options = {0, 0, 0, 0, 0, 0};
+    asmSession *session;
+    asmResult cold, warm;
+    double start, cold_time, warm_time;
+    long length;
+    char *text = read_stdin(&length);
+    int i, words;
+
+    if (text == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        return EXIT_FAILURE;
+    }
+    memset(&cold, 0, sizeof(cold));
+    memset(&warm, 0, sizeof(warm));
+
+    // A new session and result for every call
+    start = now();
+    for (i = 0; i < ROUNDS; i++)
+    {
+        session = asm_open();
+        if (session == NULL)
+            return EXIT_FAILURE;
+        asm_assemble(session, text, length, &options, &cold);
+        asm_close(session);
+        if (i + 1 < ROUNDS)
+            asm_free_result(&cold);
+    }
+    cold_time = now() - start;
+
+    // One session and result for all calls
+    session = asm_open();
+    if (session == NULL)
+        return EXIT_FAILURE;
+    start = now();
+    for (i = 0; i < ROUNDS; i++)
+        asm_assemble(session, text, length, &options, &warm);
+    warm_time = now() - start;
+
+    words = warm.code_words + warm.data_words;
+    if (cold.ok != warm.ok || cold.code_words != warm.code_words || cold.data_words != warm.data_words ||
+        (warm.ok && memcmp(cold.image, warm.image, words * sizeof(unsigned int)) != 0))
+    {
+        printf("the sessions disagree\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%ld bytes, %d words, %d diagnostics, %d calls\n", length, words, warm.diagnostic_count, ROUNDS);
+    printf("%-16s %12s %14s\n", "session", "us/call", "words/s");
+    printf("%-16s %12.1f %14.0f\n", "new per call", cold_time * 1e6 / ROUNDS, words * (double)ROUNDS / cold_time);
+    printf("%-16s %12.1f %14.0f\n", "reused", warm_time * 1e6 / ROUNDS, words * (double)ROUNDS / warm_time);
+
+    asm_free_result(&cold);
+    asm_free_result(&warm);
+    asm_close(session);
+    free(text);
+    return EXIT_SUCCESS;
+}
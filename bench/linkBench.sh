@@ -0,0 +1,59 @@
+#!/bin/sh
+# Linker benchmark over many generated modules.
+# Usage: bench/linkBench.sh [modules] [runs] [asm binary] [asmlink binary]
+# Module k exports a routine Fk and a data label Dk, and calls the routine of
+# module k+1 through an external, so every module has relocatable words, data,
+# entries and external use sites. The modules are assembled once with asm -j,
+# then linked RUNS times; the script reports the link time and checks that the
+# last module's call was patched with the address of the first module's routine.
+
+MODULES=${1:-10000}
+RUNS=${2:-5}
+ASM=${3:-./asm}
+LINK=${4:-./asmlink}
+DIR=$(mktemp -d)
+
+awk -v n="$MODULES" -v dir="$DIR" 'BEGIN {
+    for (k = 0; k < n; k++)
+    {
+        file = dir "/m" k ".as"
+        printf ".extern F%d\n.entry F%d\n.entry D%d\n", (k + 1) % n, k, k > file
+        printf "F%d: mov D%d, r1\n", k, k > file
+        printf "add #%d, r1\n", k % 100 > file
+        printf "cmp r1, D%d\n", k > file
+        printf "jsr F%d\n", (k + 1) % n > file
+        printf "rts\n" > file
+        printf "D%d: .data %d, 1, 2\n", k, k % 1000 > file
+        close(file)
+    }
+}'
+
+# The module names, in link order
+NAMES=$(awk -v n="$MODULES" -v dir="$DIR" 'BEGIN { for (k = 0; k < n; k++) print dir "/m" k }')
+
+"$ASM" -j 8 $NAMES > /dev/null 2>&1
+
+start=$(date +%s.%N)
+i=0
+while [ $i -lt "$RUNS" ]; do
+    "$LINK" --large-memory -o "$DIR/linked" $NAMES > "$DIR/link.out" 2>&1 || { cat "$DIR/link.out"; exit 1; }
+    i=$((i + 1))
+done
+end=$(date +%s.%N)
+
+cat "$DIR/link.out"
+awk -v s="$start" -v e="$end" -v n="$RUNS" -v m="$MODULES" \
+    'BEGIN { printf "%d modules: %.1f ms per link (%.2f us per module)\n", m, (e - s) * 1000 / n, (e - s) * 1e6 / n / m }'
+
+# The call of the last module must hold the address of F0, the first word of the image
+status=0
+words=$(head -1 "$DIR/m0.ob" | cut -f1)
+site=$(cut -f2 "$DIR/m0.ext")
+got=$(awk -v a=$((100 + (MODULES - 1) * words + site)) '$1 == a { print $2 }' "$DIR/linked.ob")
+want=$(awk 'BEGIN { split("* # % !", d, " "); w = 100 * 4 + 2; for (i = 0; i < 16; i++) { s = d[w % 4 + 1] s; w = int(w / 4) } print s }')
+if [ "$got" != "$want" ]; then
+    echo "the external use site holds $got instead of $want"
+    status=1
+fi
+rm -rf "$DIR"
+exit $status
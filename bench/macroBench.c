@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "globals.h"
+#include "hashTable.h"
+#include "context.h"
+
+/*
+ * Macro storage benchmark.
+ * Defines MACROS macros of BODY_LINES lines each and expands every macro
+ * EXPANSIONS times into a source buffer. The same work is done with the
+ * previous layout (one malloc'd node and one strdup'd line per body line)
+ * as a reference. Reports allocations and expanded lines per second.
+ */
+
+#define MACROS 2000     // Number of macros defined
+#define BODY_LINES 16   // Number of lines in each macro body
+#define EXPANSIONS 50   // Number of times each macro is expanded
+
+typedef struct refNode
+{
+    char *line;
+    struct refNode *next;
+} refNode; // Body line in the previous layout
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+static long ref_allocations = 0; // Allocations made by the reference layout
+
+/**
+ * Allocates memory for the reference layout and counts the allocation.
+ */
+static void *ref_alloc(size_t size)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+    {
+        fprintf(stderr, "Memory allocation error\n");
+        exit(EXIT_FAILURE);
+    }
+    ref_allocations++;
+    return ptr;
+}
+
+/**
+ * Returns the elapsed CPU time in seconds since the given start.
+ */
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+    static refNode *ref_bodies[MACROS];
+    static hashEntry *entries[MACROS];
+    char key[SYMBOL_MAX_SIZE + 1];
+    char line[LINESIZE + 2];
+    hashTable *table;
+    sourceBuffer out;
+    refNode *node;
+    long allocations = 0;
+    clock_t start;
+    double ref_time, arena_time;
+    int i, j;
+
+    // Macro entries are allocated from the context's arena
+    context = create_context(stdout, stderr);
+    if (context == NULL)
+        return EXIT_FAILURE;
+    table = context->macroTable;
+
+    // Define the macros in both layouts
+    for (i = 0; i < MACROS; i++)
+    {
+        sprintf(key, "m%d", i);
+        ref_bodies[i] = NULL;
+        ref_allocations++; // The reference layout also allocated one entry and one key per macro
+        ref_allocations++;
+        for (j = 0; j < BODY_LINES; j++)
+        {
+            sprintf(line, "    mov r%d, LABEL%d\n", j % 8, j);
+            insert(table, key, line, (int)strlen(line));
+
+            node = (refNode *)ref_alloc(sizeof(refNode));
+            node->line = (char *)ref_alloc(strlen(line) + 1);
+            strcpy(node->line, line);
+            node->next = ref_bodies[i];
+            ref_bodies[i] = node;
+        }
+        entries[i] = lookup(table, key); // Looking a macro up costs the same in both layouts
+        allocations += 2 + entries[i]->body.allocations; // Entry, key and body buffers
+    }
+
+    // Expand through the reference layout, one append per node
+    initSource(&out);
+    start = clock();
+    for (j = 0; j < EXPANSIONS; j++)
+        for (i = 0; i < MACROS; i++)
+            for (node = ref_bodies[i]; node != NULL; node = node->next)
+                append_line(&out, node->line, (int)strlen(node->line));
+    ref_time = seconds_since(start);
+    resetSource(&out);
+
+    // Expand through the arena layout, one append per macro
+    initSource(&out);
+    start = clock();
+    for (j = 0; j < EXPANSIONS; j++)
+        for (i = 0; i < MACROS; i++)
+            append_source(&out, &entries[i]->body);
+    arena_time = seconds_since(start);
+
+    printf("macros: %d, body lines: %d, expansions per macro: %d\n", MACROS, BODY_LINES, EXPANSIONS);
+    printf("%-22s %12s %18s\n", "layout", "allocations", "lines/sec");
+    printf("%-22s %12ld %18.0f\n", "node per line", ref_allocations,
+           (double)MACROS * BODY_LINES * EXPANSIONS / ref_time);
+    printf("%-22s %12ld %18.0f\n", "contiguous body", allocations,
+           (double)MACROS * BODY_LINES * EXPANSIONS / arena_time);
+
+    resetSource(&out);
+    free_context(context);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Compares the two-pass assembly with the single-pass (--one-pass) mode.
+# Usage: bench/passModes.sh [runs] [asm binary]
+# The generated program fills most of the memory image with commands that
+# reference labels defined later, .data labels and externals. Both modes must
+# produce identical .ob/.ent/.ext files; the script fails if they differ.
+
+RUNS=${1:-200}
+ASM=${2:-./asm}
+DIR=$(mktemp -d)
+
+# Generate a program of about 3600 words where most operands are forward references
+awk 'BEGIN {
+    print ".extern OUT"
+    print ".define step = 2"
+    n = 500
+    for (i = 0; i < n; i++)
+    {
+        printf "L%d: mov L%d, r%d\n", i, (i + 7) % n, i % 8
+        printf "cmp VALS[step], #step\n"
+        if (i % 10 == 0)
+            printf "jsr OUT\n"
+        if (i % 25 == 0)
+            printf ".entry L%d\n", i
+    }
+    print "hlt"
+    print "VALS: .data 1, 2, 3, 4"
+}' > "$DIR/prog.as"
+
+# Runs a binary with the given flags RUNS times and prints the elapsed wall time
+run()
+{
+    start=$(date +%s.%N)
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        "$@" "$DIR/prog" > /dev/null 2>&1
+        i=$((i + 1))
+    done
+    end=$(date +%s.%N)
+    awk -v s="$start" -v e="$end" -v n="$RUNS" 'BEGIN { printf "%.3f s (%.2f ms per run)", e - s, (e - s) * 1000 / n }'
+}
+
+echo "runs: $RUNS"
+echo "two-pass:    $(run "$ASM")"
+for ext in ob ent ext; do cp "$DIR/prog.$ext" "$DIR/two.$ext"; done
+echo "single-pass: $(run "$ASM" --one-pass)"
+
+status=0
+for ext in ob ent ext; do
+    if ! cmp -s "$DIR/prog.$ext" "$DIR/two.$ext"; then
+        echo "outputs differ: .$ext"
+        status=1
+    fi
+done
+[ $status -eq 0 ] && echo "outputs identical"
+
+rm -rf "$DIR"
+exit $status
@@ -0,0 +1,253 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/*
+ * Server mode latency benchmark.
+ * Assembles the same program JOBS times in three ways and reports the latency
+ * of one job: running the assembler once per job (fork/exec, like a build
+ * system does), sending "assemble" requests to an assembler started with
+ * --server, and sending the source itself with "source" requests.
+ *
+ * Usage: bench/serverBench [asm binary] [program, without .as] [jobs]
+ */
+
+#define DEFAULT_JOBS 200       // Jobs timed in each mode
+#define CONNECT_ATTEMPTS 200   // Tries to connect while the server starts
+#define CONNECT_WAIT_NS 10000000L // Time between the tries (10 ms)
+
+extern char **environ;
+
+/**
+ * Returns the current time in seconds.
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Compares two latencies, for qsort.
+ */
+static int compare_latency(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Prints the mean, median and 99th percentile of the latencies, in microseconds.
+ * @return The mean latency in seconds.
+ */
+static double report(char *mode, double *latency, int jobs)
+{
+    double total = 0;
+    int i;
+
+    for (i = 0; i < jobs; i++)
+        total += latency[i];
+    qsort(latency, jobs, sizeof(double), compare_latency);
+    printf("%-18s %10.1f %10.1f %10.1f\n", mode, total * 1e6 / jobs, latency[jobs / 2] * 1e6,
+           latency[(jobs * 99) / 100] * 1e6);
+    return total / jobs;
+}
+
+/**
+ * Starts a program with its standard output and error discarded.
+ * @return The process id, or -1 if it could not be started.
+ */
+static pid_t start_quiet(char **argv)
+{
+    posix_spawn_file_actions_t actions;
+    pid_t pid;
+    int status;
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+    status = posix_spawn(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    return status == 0 ? pid : -1;
+}
+
+/**
+ * Connects to the server's socket, waiting for the server to start listening.
+ * @return The connected socket, or -1.
+ */
+static int connect_server(char *path)
+{
+    struct sockaddr_un address;
+    struct timespec wait = {0, CONNECT_WAIT_NS};
+    int fd, attempt;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    for (attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++)
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+            return fd;
+        close(fd);
+        nanosleep(&wait, NULL);
+    }
+    return -1;
+}
+
+/**
+ * Sends one request and reads the reply up to its "done" line.
+ * @return 1 if every file of the reply has status ok, 0 otherwise.
+ */
+static int request(FILE *out, FILE *in, char *line, char *body, long body_length)
+{
+    char *reply = NULL;
+    size_t capacity = 0;
+    int ok = 1;
+
+    fputs(line, out);
+    if (body != NULL)
+        fwrite(body, 1, body_length, out);
+    fflush(out);
+    while (getline(&reply, &capacity, in) != -1 && strcmp(reply, "done\n") != 0)
+        if (strncmp(reply, "status ", 7) == 0 && strcmp(reply, "status ok\n") != 0)
+            ok = 0;
+    free(reply);
+    return ok;
+}
+
+/**
+ * Reads a whole file into memory.
+ * @return The contents, or NULL if the file cannot be read.
+ */
+static char *read_file(char *name, long *length)
+{
+    FILE *file = fopen(name, "rb");
+    char *text;
+
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    rewind(file);
+    text = (char *)malloc(*length + 1);
+    if (text != NULL && (long)fread(text, 1, *length, file) != *length)
+    {
+        free(text);
+        text = NULL;
+    }
+    fclose(file);
+    return text;
+}
+
+int main(int argc, char *argv[])
+{
+    char *asm_path = argc > 1 ? argv[1] : "./asm";
+    char *program = argc > 2 ? argv[2] : "./tests/ps";
+    int jobs = argc > 3 ? atoi(argv[3]) : DEFAULT_JOBS;
+    char socket_path[64], line[4200], source_name[4200];
+    char *run_argv[3], *server_argv[4];
+    double *latency, start, process_mean, server_mean, source_mean;
+    char *source;
+    long source_length;
+    pid_t pid, server;
+    int i, status, fd, ok = 1;
+    FILE *in, *out;
+
+    if (jobs < 1 || strlen(program) > 4000)
+    {
+        fprintf(stderr, "usage: %s [asm binary] [program, without .as] [jobs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    sprintf(source_name, "%s.as", program);
+    source = read_file(source_name, &source_length);
+    latency = (double *)malloc(jobs * sizeof(double));
+    if (source == NULL || latency == NULL)
+    {
+        fprintf(stderr, "cannot read %s\n", source_name);
+        return EXIT_FAILURE;
+    }
+
+    printf("%d jobs of %s (%ld bytes)\n", jobs, source_name, source_length);
+    printf("%-18s %10s %10s %10s\n", "mode", "mean us", "p50 us", "p99 us");
+
+    // One process per job
+    run_argv[0] = asm_path;
+    run_argv[1] = program;
+    run_argv[2] = NULL;
+    for (i = 0; i < jobs; i++)
+    {
+        start = now();
+        pid = start_quiet(run_argv);
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+        {
+            fprintf(stderr, "cannot run %s\n", asm_path);
+            return EXIT_FAILURE;
+        }
+        latency[i] = now() - start;
+    }
+    process_mean = report("fork/exec", latency, jobs);
+
+    // One long-running server for all jobs
+    sprintf(socket_path, "/tmp/asm-bench-%ld.sock", (long)getpid());
+    server_argv[0] = asm_path;
+    server_argv[1] = "--server";
+    server_argv[2] = socket_path;
+    server_argv[3] = NULL;
+    server = start_quiet(server_argv);
+    fd = server < 0 ? -1 : connect_server(socket_path);
+    in = fd < 0 ? NULL : fdopen(fd, "r");
+    out = fd < 0 ? NULL : fdopen(dup(fd), "w");
+    if (in == NULL || out == NULL)
+    {
+        fprintf(stderr, "cannot start the server\n");
+        if (server > 0)
+            kill(server, SIGTERM);
+        return EXIT_FAILURE;
+    }
+
+    sprintf(line, "assemble %s\n", program);
+    for (i = 0; i < jobs; i++)
+    {
+        start = now();
+        ok &= request(out, in, line, NULL, 0);
+        latency[i] = now() - start;
+    }
+    server_mean = report("server assemble", latency, jobs);
+
+    sprintf(line, "source %s %ld\n", program, source_length);
+    for (i = 0; i < jobs; i++)
+    {
+        start = now();
+        ok &= request(out, in, line, source, source_length);
+        latency[i] = now() - start;
+    }
+    source_mean = report("server source", latency, jobs);
+
+    fputs("quit\n", out);
+    fclose(out);
+    fclose(in);
+    kill(server, SIGTERM);
+    waitpid(server, &status, 0);
+    unlink(socket_path);
+
+    printf("speedup over fork/exec: %.1fx (assemble), %.1fx (source)\n", process_mean / server_mean,
+           process_mean / source_mean);
+    if (!ok)
+        printf("warning: some server jobs failed to assemble\n");
+    free(latency);
+    free(source);
+    return EXIT_SUCCESS;
+}
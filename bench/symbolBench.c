@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vars.h"
+
+/*
+ * Symbol table scaling benchmark.
+ * Adds n labels, then looks each of them up once and looks up n names that
+ * are not defined, for n from 1k to 1M. Up to LINEAR_LIMIT symbols the same
+ * lookups are also timed with a plain scan of the list, which is what every
+ * lookup cost before the hash index.
+ */
+
+#define LINEAR_LIMIT 10000 // Largest table that is also scanned linearly
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+/**
+ * Returns the elapsed CPU time in seconds since the given start.
+ */
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * Finds a symbol by scanning the list, the way lookups worked before the index.
+ */
+static Symbol *linear_find(Symbol *current, char *name)
+{
+    for (; current != NULL; current = current->next)
+    {
+        if (strcmp(current->name, name) == 0)
+            return current;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    char name[SYMBOL_MAX_SIZE + 1];
+    long n, i, found;
+    clock_t start;
+    double add_time, hit_time, miss_time, linear_time;
+
+    context = create_context(stdout, stderr);
+    if (context == NULL)
+        return EXIT_FAILURE;
+
+    printf("%10s %12s %12s %12s %14s\n", "symbols", "add ns/op", "hit ns/op", "miss ns/op", "linear ns/op");
+    for (n = 1000; n <= 1000000; n *= 10)
+    {
+        // Fill the table
+        start = clock();
+        for (i = 0; i < n; i++)
+        {
+            sprintf(name, "L%ld", i);
+            addSymbol(&symbols, name, (int)i, CODE);
+        }
+        add_time = seconds_since(start);
+
+        // Look up every defined label
+        found = 0;
+        start = clock();
+        for (i = 0; i < n; i++)
+        {
+            sprintf(name, "L%ld", i);
+            found += findSymbol(&symbols, name) != NULL;
+        }
+        hit_time = seconds_since(start);
+
+        // Look up names that are not defined
+        start = clock();
+        for (i = 0; i < n; i++)
+        {
+            sprintf(name, "M%ld", i);
+            found += findSymbol(&symbols, name) != NULL;
+        }
+        miss_time = seconds_since(start);
+
+        if (found != n)
+        {
+            fprintf(stderr, "symbolBench: expected %ld hits, got %ld\n", n, found);
+            return EXIT_FAILURE;
+        }
+
+        // Reference: scanning the list
+        linear_time = 0;
+        if (n <= LINEAR_LIMIT)
+        {
+            start = clock();
+            for (i = 0; i < n; i++)
+            {
+                sprintf(name, "L%ld", i);
+                linear_find(symbols, name);
+            }
+            linear_time = seconds_since(start);
+        }
+
+        printf("%10ld %12.1f %12.1f %12.1f", n, add_time * 1e9 / n, hit_time * 1e9 / n, miss_time * 1e9 / n);
+        if (n <= LINEAR_LIMIT)
+            printf(" %14.1f\n", linear_time * 1e9 / n);
+        else
+            printf(" %14s\n", "-");
+
+        resetSymbolTable(&symbols);
+    }
+    free_context(context);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Assembler throughput benchmark over generated programs.
+# Usage: bench/throughput.sh [runs] [asm binary] [generator binary]
+# Every scenario is a program made by bench/genProgram with fixed options, so
+# the inputs are the same on every run. Each program is assembled RUNS times
+# with --stats; the script reports, per phase, the source lines handled per
+# second (lines read / average wall time) and the peak RSS at the end of the phase.
+
+RUNS=${1:-20}
+ASM=${2:-./asm}
+GEN=${3:-./bench/genProgram}
+DIR=$(mktemp -d)
+
+# name, generator options and assembler flags of every scenario
+SCENARIOS="
+default|-n 1000
+label_heavy|-n 1000 -l 80 -f 80 -E 30
+macro_heavy|-n 1000 -m 40 -s 12 -c 40
+data_heavy|-n 1000 -d 40 -t 25 -v 10
+extern_heavy|-n 1000 -e 60 -E 40
+backward_refs|-n 1000 -f 0
+large_memory|-n 100000 -w 1000000|--large-memory
+"
+
+# Prints one table row from the .stats.json files of all runs
+report()
+{
+    awk -v name="$1" '
+        /"lines_read"/ { gsub(/[^0-9]/, "", $2); lines = $2 }
+        /"wall_ms"/ {
+            phase = $1; gsub(/[":]/, "", phase)
+            wall = $3; gsub(/,/, "", wall)
+            rss = $7; gsub(/[^0-9]/, "", rss)
+            total[phase] += wall
+            if (rss > peak[phase]) peak[phase] = rss
+            runs[phase]++
+        }
+        END {
+            printf "%-14s %7d", name, lines
+            n = split("preAssembler first_pass second_pass write_output_files", order, " ")
+            for (i = 1; i <= n; i++) {
+                p = order[i]
+                avg = total[p] / runs[p]
+                printf " %14.0f %8d", (avg > 0 ? lines * 1000 / avg : 0), peak[p]
+            }
+            printf "\n"
+        }' "$DIR"/stats.*
+}
+
+echo "runs: $RUNS (lines/s and peak RSS KB per phase)"
+printf "%-14s %7s %14s %8s %14s %8s %14s %8s %14s %8s\n" scenario lines \
+    pre-asm rss first-pass rss second-pass rss write rss
+
+echo "$SCENARIOS" | while IFS='|' read -r name options flags; do
+    [ -z "$name" ] && continue
+    # shellcheck disable=SC2086
+    "$GEN" $options > "$DIR/prog.as" 2> /dev/null || exit 1
+    rm -f "$DIR"/stats.*
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        # shellcheck disable=SC2086
+        "$ASM" --stats $flags "$DIR/prog" > /dev/null 2>&1
+        mv "$DIR/prog.stats.json" "$DIR/stats.$i" 2> /dev/null
+        i=$((i + 1))
+    done
+    if [ ! -f "$DIR/stats.0" ]; then
+        echo "$name: the assembler did not produce statistics"
+        rm -rf "$DIR"
+        exit 1
+    fi
+    report "$name"
+done
+status=$?
+
+rm -rf "$DIR"
+exit $status
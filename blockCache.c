@@ -0,0 +1,361 @@
+#include <stdlib.h>
+#include <string.h>
+#include "blockCache.h"
+
+/* GCC and Clang dispatch through a table of label addresses, marked __extension__ for -pedantic;
+   other compilers through a switch */
+#if defined(__GNUC__)
+#define EMU_THREADED
+#endif
+
+/**
+ * Prepares an empty cache for the code of an image.
+ * @param cache The cache.
+ * @param image The image.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+int init_block_cache(blockCache *cache, emuImage *image)
+{
+    memset(cache, 0, sizeof(blockCache));
+    cache->size = image->code_words + 1;
+    cache->blocks = (emuBlock **)calloc(cache->size, sizeof(emuBlock *));
+    return cache->blocks != NULL;
+}
+
+/**
+ * Drops every block, keeping the cache's memory for the blocks translated next.
+ * @param cache The cache.
+ */
+void flush_block_cache(blockCache *cache)
+{
+    memset(cache->blocks, 0, cache->size * sizeof(emuBlock *));
+    recycle_arena(&cache->memory);
+    cache->flushes++;
+}
+
+/**
+ * Frees the memory of a cache.
+ * @param cache The cache.
+ */
+void free_block_cache(blockCache *cache)
+{
+    free(cache->blocks);
+    reset_arena(&cache->memory);
+    cache->blocks = NULL;
+}
+
+/**
+ * Tells if an instruction ends a basic block.
+ * @param handler The instruction's handler.
+ * @return TRUE for jumps, rts, hlt and words that cannot run, FALSE otherwise.
+ */
+static int ends_block(int handler)
+{
+    return handler == JMP_OP || handler == BNE_OP || handler == JSR_OP || handler == RTS_OP || handler == HLT_OP ||
+           handler == ERROR_OP;
+}
+
+/**
+ * Translates the block starting at a code address and adds it to the cache.
+ * @param cache The cache.
+ * @param ops The machine's decoded code.
+ * @param index The address of the block's first instruction, less RESERVED_MEMORY.
+ * @return The block, or NULL if memory allocation failed.
+ */
+static emuBlock *translate_block(blockCache *cache, emuOp *ops, long index)
+{
+    emuMicroOp micro[EMU_BLOCK_MAX]; // The micro-ops, copied to the cache once the block is complete
+    emuMicroOp *m;
+    emuOp *op, *branch;
+    emuBlock *block;
+    int count = 0, instructions = 0, done = FALSE;
+
+    while (!done)
+    {
+        op = &ops[index];
+        m = &micro[count++];
+        memset(m, 0, sizeof(emuMicroOp));
+        m->before = (unsigned short)instructions;
+        m->address = (unsigned int)(RESERVED_MEMORY + index);
+        m->next = (unsigned int)(RESERVED_MEMORY + index + op->length);
+
+        // A word that cannot run is left to a block of its own, where it stops the machine
+        if (op->handler == ERROR_OP && instructions > 0)
+        {
+            m->handler = EMU_END_BLOCK;
+            m->next = m->address;
+            break;
+        }
+
+        m->handler = op->handler;
+        m->flags = op->flags;
+        m->src = op->src;
+        m->dst = op->dst;
+        instructions++;
+        index += op->length;
+        done = ends_block(op->handler) || (op->flags & EMU_WRITES_CODE);
+
+        // The test of a loop and its branch to a label run as one micro-op
+        branch = &ops[index];
+        if (!done && (op->handler == CMP_OP || op->handler == INC_OP || op->handler == DEC_OP) &&
+            branch->handler == BNE_OP && (branch->flags & EMU_TARGET_CONST))
+        {
+            m->handler = op->handler == CMP_OP ? EMU_CMP_BNE : op->handler == INC_OP ? EMU_INC_BNE : EMU_DEC_BNE;
+            m->jump = branch->dst;
+            m->next += branch->length;
+            instructions++;
+            cache->fused++;
+            done = TRUE;
+        }
+
+        // A long run is split, the next block starts where this one stops
+        if (!done && count == EMU_BLOCK_MAX - 1)
+        {
+            m = &micro[count++];
+            memset(m, 0, sizeof(emuMicroOp));
+            m->handler = EMU_END_BLOCK;
+            m->before = (unsigned short)instructions;
+            m->address = m->next = (unsigned int)(RESERVED_MEMORY + index);
+            done = TRUE;
+        }
+    }
+
+    block = (emuBlock *)arena_alloc(&cache->memory, sizeof(emuBlock));
+    if (block == NULL)
+        return NULL;
+    block->ops = (emuMicroOp *)arena_alloc(&cache->memory, count * (long)sizeof(emuMicroOp));
+    if (block->ops == NULL)
+        return NULL;
+    memcpy(block->ops, micro, count * sizeof(emuMicroOp));
+    block->count = count;
+    block->instructions = instructions;
+    cache->translated++;
+    return block;
+}
+
+/**
+ * Runs the program from the machine's program counter, a basic block at a time,
+ * until it halts, fails or reaches the step limit. The machine ends in the same
+ * state, with the same step count, as run_machine would leave it; near the step
+ * limit the last instructions are run one at a time by run_machine.
+ * @param machine The machine.
+ * @param cache The cache of the machine's blocks.
+ * @param max_steps Most instructions to run, or a negative number for no limit.
+ * @return Why the machine stopped, also kept in the machine.
+ */
+emuStatus run_blocks(emuMachine *machine, blockCache *cache, long max_steps)
+{
+    unsigned int *cells = machine->cells;     // R0-R7, then the memory
+    unsigned int mask = machine->image->mask; // The bits of a word
+    unsigned long code_words = (unsigned long)machine->image->code_words;
+    emuBlock **blocks = cache->blocks;        // The cached blocks, by address
+    emuBlock *block = NULL;                   // The block being run
+    emuMicroOp *op = NULL;                    // The micro-op being run
+    long steps = 0;                           // Instructions of the blocks entered by this call
+    unsigned int value, target;               // Result of an instruction, and the next block's address
+    unsigned int from = machine->pc;          // Address of the instruction that left the last block
+    int zero = machine->zero;                 // The zero flag
+    emuStatus status = EMU_RUNNING;
+#ifdef EMU_THREADED
+    __extension__ static void *handlers[] = {&&do_MOV_OP,    &&do_CMP_OP,     &&do_ADD_OP,     &&do_SUB_OP,     &&do_NOT_OP,
+                                             &&do_CLR_OP,    &&do_LEA_OP,     &&do_INC_OP,     &&do_DEC_OP,     &&do_JMP_OP,
+                                             &&do_BNE_OP,    &&do_RED_OP,     &&do_PRN_OP,     &&do_JSR_OP,     &&do_RTS_OP,
+                                             &&do_HLT_OP,    &&do_ERROR_OP,   &&do_ERROR_OP,   &&do_EMU_CMP_BNE, &&do_EMU_INC_BNE,
+                                             &&do_EMU_DEC_BNE, &&do_EMU_END_BLOCK};
+#define CASE(name) do_##name:
+#define THREAD() __extension__({ goto *handlers[op->handler]; })
+#else
+#define CASE(name) case name:
+#define THREAD() goto dispatch
+#endif
+#define SRC (op->flags & EMU_OPERAND_CONST ? op->src : cells[op->src])
+#define DST (op->flags & EMU_TARGET_CONST ? op->dst : cells[op->dst])
+#define NEXT()    \
+    do            \
+    {             \
+        op++;     \
+        THREAD(); \
+    } while (0)
+#define STORE(result)                    \
+    do                                   \
+    {                                    \
+        cells[op->dst] = (result);       \
+        if (op->flags & EMU_WRITES_CODE) \
+            goto code_written;           \
+        NEXT();                          \
+    } while (0)
+#define LEAVE(to)                \
+    do                           \
+    {                            \
+        target = (to);           \
+        from = op->address;      \
+        goto enter;              \
+    } while (0)
+
+    if (machine->status != EMU_RUNNING)
+        return machine->status;
+    target = machine->pc;
+
+enter:
+    // Find the block at the target, translating it the first time
+    if (target - RESERVED_MEMORY > code_words)
+    {
+        status = EMU_BAD_JUMP;
+        machine->pc = from;
+        goto stop;
+    }
+    block = blocks[target - RESERVED_MEMORY];
+    if (block == NULL)
+    {
+        block = translate_block(cache, machine->ops, (long)(target - RESERVED_MEMORY));
+        if (block == NULL)
+        {
+            status = EMU_OUT_OF_MEMORY;
+            machine->pc = target;
+            goto stop;
+        }
+        blocks[target - RESERVED_MEMORY] = block;
+    }
+
+    // Near the step limit, the rest is run an instruction at a time
+    if (max_steps >= 0 && steps + block->instructions > max_steps)
+    {
+        machine->pc = target;
+        machine->zero = zero;
+        machine->steps += steps;
+        return run_machine(machine, max_steps - steps);
+    }
+    steps += block->instructions;
+    cache->entered++;
+    op = block->ops;
+    THREAD();
+
+#ifndef EMU_THREADED
+dispatch:
+    switch (op->handler)
+    {
+#endif
+    CASE(MOV_OP)
+        STORE(SRC);
+    CASE(CMP_OP)
+        zero = ((SRC - DST) & mask) == 0;
+        NEXT();
+    CASE(ADD_OP)
+        value = (cells[op->dst] + SRC) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(SUB_OP)
+        value = (cells[op->dst] - SRC) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(NOT_OP)
+        value = ~cells[op->dst] & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(CLR_OP)
+        zero = TRUE;
+        STORE(0);
+    CASE(LEA_OP)
+        STORE(SRC);
+    CASE(INC_OP)
+        value = (cells[op->dst] + 1) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(DEC_OP)
+        value = (cells[op->dst] - 1) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(JMP_OP)
+        LEAVE(DST);
+    CASE(BNE_OP)
+        LEAVE(zero ? op->next : DST);
+    CASE(RED_OP)
+        if (machine->input_position < machine->input_length)
+            value = (unsigned char)machine->input[machine->input_position++];
+        else
+            value = mask; // -1 at the end of the tape
+        STORE(value);
+    CASE(PRN_OP)
+        if (!emu_print(machine, DST))
+        {
+            steps -= block->instructions - op->before; // The prn did not finish
+            status = EMU_OUT_OF_MEMORY;
+            machine->pc = op->address;
+            goto stop;
+        }
+        NEXT();
+    CASE(JSR_OP)
+        if (machine->depth == EMU_STACK_SIZE)
+        {
+            status = EMU_STACK_OVERFLOW;
+            machine->pc = op->address;
+            goto stop;
+        }
+        machine->stack[machine->depth++] = op->next;
+        LEAVE(DST);
+    CASE(RTS_OP)
+        if (machine->depth == 0)
+        {
+            status = EMU_STACK_UNDERFLOW;
+            machine->pc = op->address;
+            goto stop;
+        }
+        LEAVE(machine->stack[--machine->depth]);
+    CASE(HLT_OP)
+        status = EMU_HALTED;
+        machine->pc = op->address;
+        goto stop;
+    CASE(ERROR_OP)
+        steps -= block->instructions - op->before; // The word did not run
+        status = (emuStatus)op->src;
+        machine->pc = op->address;
+        goto stop;
+    CASE(EMU_CMP_BNE)
+        zero = ((SRC - DST) & mask) == 0;
+        LEAVE(zero ? op->next : op->jump);
+    CASE(EMU_INC_BNE)
+        value = (cells[op->dst] + 1) & mask;
+        cells[op->dst] = value;
+        zero = value == 0;
+        LEAVE(zero ? op->next : op->jump);
+    CASE(EMU_DEC_BNE)
+        value = (cells[op->dst] - 1) & mask;
+        cells[op->dst] = value;
+        zero = value == 0;
+        LEAVE(zero ? op->next : op->jump);
+    CASE(EMU_END_BLOCK)
+        LEAVE(op->next);
+#ifndef EMU_THREADED
+    default:
+        steps -= block->instructions - op->before;
+        status = EMU_BAD_INSTRUCTION;
+        machine->pc = op->address;
+        goto stop;
+    }
+#endif
+
+code_written:
+    // The blocks were translated from the old code, which is decoded again
+    if (emu_rewrite_code(machine) == NULL)
+    {
+        status = EMU_OUT_OF_MEMORY;
+        machine->pc = op->next;
+        goto stop;
+    }
+    flush_block_cache(cache);
+    LEAVE(op->next);
+
+stop:
+    machine->zero = zero;
+    machine->steps += steps;
+    machine->status = status;
+    return status;
+
+#undef CASE
+#undef THREAD
+#undef SRC
+#undef DST
+#undef NEXT
+#undef STORE
+#undef LEAVE
+}
@@ -4,27 +4,28 @@
 #include <string.h>
 #include "vars.h"
 #include "cmdHandlers.h"
+#include "expression.h"
 
 /**
- * Finds the operation opcode in a line of assembly code.
- * @param line The line of assembly code.
- * @param index Pointer to the index indicating the position in the line.
+ * Finds the operation opcode in a scanned line of assembly code.
+ * @param scan The scanned line.
+ * @param token Pointer to the index of the current token, moved past the operation.
  * @return The opcode of the operation found, or NONE_OP if not found.
  */
-opcode find_operation(char *line, int *index)
+opcode find_operation(lineScan *scan, int *token)
 {
-    char tmp_operation[LINESIZE + 1]; // Temporary buffer to hold the operation name
-    opcode result;                    // Variable to store the result
+    char *name;                  // Start of the operation's field
+    int length;                  // Length of the field
+    const keywordEntry *keyword; // The keyword the field names
 
-    MOVE_TO_NOT_WHITE(line, *index); // Move index to the first non-white space character
-
-    if (is_end_of_line(line[*index]))
+    if (*token == scan->count)
         return NONE_OP; // No operation found if end of line is reached
 
-    *index += find_next_token(&line[*index], tmp_operation, ' '); // Find the next token in the line
+    *token = field_span(scan, *token, &name, &length); // Move past the field holding the operation
 
-    if ((result = find_operation_by_name(tmp_operation)) != NONE_OP)
-        return result; // Return the operation opcode if found
+    keyword = find_keyword_span(name, length);
+    if (keyword != NULL && keyword->kind == OPERATION_KW)
+        return (opcode)keyword->code; // Return the operation opcode if found
 
     return NONE_OP; // Return NONE_OP if not a valid operation
 }
@@ -35,10 +36,15 @@ addressing_type get_addressing_type(char *operand)
     char *closing;
     int is_symbol;
     int is_valid;
+    long value; // Value of an expression, checked here and folded again when the word is encoded
     if (operand[0] == '\0')
     {
         return NONE_ADDR;
     }
+    if (operand[0] == '#' && is_expression(&operand[1], strlen(&operand[1])))
+    {
+        return fold_constant(&operand[1], &value) ? IMMEDIATE_ADDR : ERROR_ADDR;
+    }
     if (operand[0] == '#' && (is_int_str(&operand[1]) || (is_valid_symbol(&operand[1]) && locateSymbol_by_attribute(&symbols, &operand[1], MDEFINE))))
     {
         return IMMEDIATE_ADDR;
@@ -75,12 +81,24 @@ addressing_type get_addressing_type(char *operand)
     opening++;
     *closing = '\0';
 
-    is_valid = (is_int_str(opening) || (is_valid_symbol(opening) && locateSymbol_by_attribute(&symbols, opening, MDEFINE)));
-    *closing = ']';
-    if (!is_valid)
+    if (is_expression(opening, strlen(opening)))
     {
-        err = INDEX_INVALID_POSITION;
-        return ERROR_ADDR;
+        is_valid = fold_constant(opening, &value);
+        *closing = ']';
+        if (!is_valid)
+        {
+            return ERROR_ADDR;
+        }
+    }
+    else
+    {
+        is_valid = (is_int_str(opening) || (is_valid_symbol(opening) && locateSymbol_by_attribute(&symbols, opening, MDEFINE)));
+        *closing = ']';
+        if (!is_valid)
+        {
+            err = INDEX_INVALID_POSITION;
+            return ERROR_ADDR;
+        }
     }
     closing++;
 
@@ -95,63 +113,73 @@ addressing_type get_addressing_type(char *operand)
 }
 
 /**
- * Handles the operations and extracts operands from a line of assembly code.
- * @param line The line of assembly code.
- * @param first_operand Pointer to store the addressing type of the first operand.
- * @param second_operand Pointer to store the addressing type of the second operand.
+ * Copies an operand out of a scanned line and finds its addressing type.
+ * @param scan The scanned line.
+ * @param token Index of the operand's first token.
+ * @param operand Receives the location and addressing type of the operand.
+ * @return The index of the token after the operand.
+ */
+static int scan_operand(lineScan *scan, int token, operandSpan *operand)
+{
+    char text[LINESIZE + 1]; // The operand, null-terminated
+
+    token = word_span(scan, token, &operand->start, &operand->length);
+    if (operand->length > LINESIZE)
+        operand->length = LINESIZE;
+    memcpy(text, operand->start, operand->length);
+    text[operand->length] = '\0';
+    operand->type = get_addressing_type(text);
+    return token;
+}
+
+/**
+ * Handles the operations and extracts operands from a scanned line of assembly code.
+ * @param scan The scanned line.
+ * @param token Index of the first token after the operation.
+ * @param first_operand Pointer to store the location and addressing type of the first operand.
+ * @param second_operand Pointer to store the location and addressing type of the second operand.
  * @return TRUE if the operation is successfully handled and operands are extracted, FALSE otherwise.
  */
-int operationHandler(char *line, addressing_type *first_operand, addressing_type *second_operand)
+int operationHandler(lineScan *scan, int token, operandSpan *first_operand, operandSpan *second_operand)
 {
-    int index = 0;                                       // Initialize index to track position in the line
-    char operand1[LINESIZE + 1], operand2[LINESIZE + 1]; // Temporary buffers to hold operands
+    second_operand->type = NONE_ADDR; // No second operand until one is found
 
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the first non-white space character
-    if (line[index] == ',')
+    if (token < scan->count && scan->tokens[token].kind == COMMA_TOKEN)
     {
         err = COMMAND_UNEXPECTED_CHAR; // Error handling: set error if unexpected comma at the beginning
         return FALSE;                  // Return FALSE indicating unexpected comma at the beginning
     }
 
     // Find and extract the first operand
-    index += find_next_token(&line[index], operand1, ','); // Find and extract the first operand
-    *first_operand = get_addressing_type(operand1);        // Get addressing type of the first operand
-    if (*first_operand == ERROR_ADDR)
+    token = scan_operand(scan, token, first_operand);
+    if (first_operand->type == ERROR_ADDR)
     {
         return FALSE; // Return FALSE indicating an error in the first operand
     }
 
     // Check for a second operand
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white space character
-    if (line[index] == ',')
+    if (token < scan->count && scan->tokens[token].kind == COMMA_TOKEN)
     {
-        index++; // Move past the comma
+        token++; // Move past the comma
 
         // Check for trailing comma
-        MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white space character
-        if (is_end_of_line(line[index]))
+        if (token == scan->count)
         {
             err = COMMAND_UNEXPECTED_CHAR; // Error handling: set error if redundant comma at the end
             return FALSE;                  // Return FALSE indicating redundant comma at the end
         }
 
         // Find and extract the second operand
-        index += find_next_token(&line[index], operand2, ','); // Find and extract the second operand
-        *second_operand = get_addressing_type(operand2);       // Get addressing type of the second operand
+        token = scan_operand(scan, token, second_operand);
     }
-    else if (!is_end_of_line(line[index]))
+    else if (token < scan->count)
     {
         err = EXPECTED_COMMA_BETWEEN_OPERANDS; // Error handling: set error if unexpected characters after first operand
         return FALSE;                          // Return FALSE indicating unexpected characters after first operand
     }
-    else
-    {
-        *second_operand = NONE_ADDR; // Only one operand
-    }
 
     // Check for unexpected characters after the operands
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white space character
-    if (!is_end_of_line(line[index]))
+    if (token < scan->count)
     {
         err = COMMAND_UNEXPECTED_CHAR; // Error handling: set error if unexpected characters after the operands
         return FALSE;                  // Return FALSE indicating unexpected characters after the operands
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+#include "utils.h"
+
+_Thread_local AsmContext *context = NULL; // The context of the file the current thread is assembling
+
+/**
+ * Allocates and initializes a new context with empty tables.
+ * @param out Stream receiving progress messages.
+ * @param diag Stream receiving error and warning messages.
+ * @return A pointer to the new context, or NULL if memory allocation failed.
+ */
+AsmContext *create_context(FILE *out, FILE *diag)
+{
+    AsmContext *ctx = (AsmContext *)malloc(sizeof(AsmContext));
+    if (ctx == NULL)
+    {
+        fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(AsmContext)); // Zero counters, flags and empty tables
+    ctx->macroTable = initTable();
+    ctx->out = out;
+    ctx->diag = diag;
+    return ctx;
+}
+
+/**
+ * Frees a context and everything it holds.
+ * @param ctx The context to free.
+ */
+void free_context(AsmContext *ctx)
+{
+    AsmContext *previous = context;
+
+    // Reset the tables of the freed context, not of the current one
+    context = ctx;
+    reset_global_vars();
+    context = previous;
+
+    free(ctx->macroTable->table);
+    free(ctx->macroTable->bloom);
+    free(ctx->macroTable);
+    free(ctx);
+}
+
+/**
+ * Empties a context for the next file, keeping the memory its tables, names and
+ * arena have grown to. Long-running callers (the server) reuse one context this
+ * way instead of creating a new one for every file.
+ * @param ctx The context to recycle.
+ * @param out Stream receiving progress messages of the next file.
+ * @param diag Stream receiving error and warning messages of the next file.
+ */
+void recycle_context(AsmContext *ctx, FILE *out, FILE *diag)
+{
+    AsmContext *previous = context;
+
+    // Reset the tables of the recycled context, not of the current one
+    context = ctx;
+    recycle_global_vars();
+    context = previous;
+
+    ctx->ic = 0;
+    ctx->dc = 0;
+    ctx->large_memory = FALSE;
+    ctx->pool_strings = FALSE;
+    memset(&ctx->stats, 0, sizeof(asmStats));
+    ctx->out = out;
+    ctx->diag = diag;
+}
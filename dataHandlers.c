@@ -4,34 +4,32 @@
 #include <string.h>
 #include "vars.h"
 #include "dataHandlers.h"
+#include "expression.h"
 #include <stdlib.h>
 
 /**
- * Finds the instruction in a line of assembly code.
- * @param line The line of assembly code.
- * @param index Pointer to the index indicating the position in the line.
+ * Finds the instruction in a scanned line of assembly code.
+ * @param scan The scanned line.
+ * @param token Pointer to the index of the current token, moved past the instruction.
  * @return The instruction found, or NONE_IN if not found.
  */
-instruction find_instruction(char *line, int *index)
+instruction find_instruction(lineScan *scan, int *token)
 {
-    // Temporary buffer to store the instruction
-    char tmp_instruction[LINESIZE + 1];
-    // Resulting instruction
-    instruction result;
-
-    // Moves to the start of the line
-    MOVE_TO_NOT_WHITE(line, (*index));
+    char *name;                  // Start of the instruction's field
+    int length;                  // Length of the field
+    const keywordEntry *keyword; // The keyword the field names
 
     // Checks if the line is empty or if the first arg doesn't start with a (.)
-    if (is_end_of_line(line[*index]) || line[*index] != '.')
+    if (*token == scan->count || scan->tokens[*token].start[0] != '.')
         return NONE_IN; // Return NONE_IN if end of line or not starting with a (.)
 
-    // Moves to and saves the next token from the current position
-    *index += find_next_token(&line[*index], tmp_instruction, ' '); // Find and save the next token
+    // Moves past the field holding the instruction
+    *token = field_span(scan, *token, &name, &length);
 
-    // Checks if the current token is an instruction
-    if ((result = find_instruction_by_name(tmp_instruction)) != NONE_IN)
-        return result; // Return the instruction if found
+    // Checks if the field is an instruction
+    keyword = find_keyword_span(name, length);
+    if (keyword != NULL && keyword->kind == INSTRUCTION_KW)
+        return (instruction)keyword->code; // Return the instruction if found
 
     // If instruction not found, set error and return
     err = INSTRUCTION_NOT_FOUND; // Error handling: set error if instruction not found
@@ -98,6 +96,7 @@ int defineHandler(char *arg)
     int length = 0;                   // Initialize length to track length of symbol
     char symbol[SYMBOL_MAX_SIZE + 1]; // Buffer to store the symbol
     long num_value;                   // Variable to store the numeric value
+    int value_length;                 // Length of the value, without the blanks after it
 
     // Removes leading whitespace and finds the next symbol
     length += find_next_symbol(arg, symbol, '='); // Find and extract the symbol from the argument
@@ -144,19 +143,15 @@ int defineHandler(char *arg)
         return FALSE;              // Return FALSE indicating number expected
     }
 
-    // Converts string argument to a long integer
-    char *ptr;
-    num_value = strtol(&arg[index], &ptr, 10); // Convert string to long integer
-    index += ptr - &arg[index];                // Update index
-
-    // Moves to the next non-white space character
-    MOVE_TO_NOT_WHITE(arg, index);
-
-    // Check if there are any characters left on the line after the number
-    if (!is_end_of_line(arg[index]))
+    // The value is the rest of the line: a number, or an expression over constants defined earlier
+    value_length = (int)strlen(&arg[index]);
+    while (value_length > 0 && isspace((unsigned char)arg[index + value_length - 1]))
+        value_length--;
+    if (!evaluate_expression(&arg[index], value_length, &num_value))
     {
-        err = DEFINE_EXPECTED_NUM; // Error handling: set error if number is expected
-        return FALSE;              // Return FALSE indicating number expected
+        if (err == EXPRESSION_INVALID)
+            err = DEFINE_EXPECTED_NUM; // Error handling: set error if number is expected
+        return FALSE;                  // Return FALSE indicating the value is not valid
     }
 
     // Checks if the number is within the allowed range
@@ -173,46 +168,64 @@ int defineHandler(char *arg)
         return FALSE;               // Return FALSE indicating label already exists
     }
 
-    // Add symbol to the symbol table
-    addSymbol(&symbols, symbol, (int)num_value, MDEFINE); // Add symbol to symbol table with numeric value
-
-    return TRUE; // Return TRUE indicating constant successfully defined
+    // Add symbol to the symbol table, FALSE only if memory allocation failed
+    return addSymbol(&symbols, symbol, (int)num_value, MDEFINE); // Add symbol to symbol table with numeric value
 }
 
 /**
  * Handles the .data instruction.
- * @param args The argument string containing the data values.
+ * @param scan The scanned line.
+ * @param token Index of the first token of the data values.
  * @return TRUE if the data values are successfully processed, FALSE otherwise.
  */
-int dataHandler(char *args)
+int dataHandler(lineScan *scan, int token)
 {
-    int index = 0;                 // Initialize index to track position in the argument string
-    char arg[SYMBOL_MAX_SIZE + 1]; // Buffer to store symbols or numeric values
+    char arg[SYMBOL_MAX_SIZE + 1]; // Buffer to store symbols
+    char *start;                   // Start of the current value
+    int length;                    // Length of the current value
+    char *end;                     // Position after the part of the value that was used
     char *rest;                    // Pointer to the rest of the string after conversion
     long value;                    // Variable to store numeric value
     Symbol *symbol;                // Pointer to symbol information
 
-    // Move index to the next non-white space character
-    MOVE_TO_NOT_WHITE(args, index);
-
-    // Iterate through the arguments until end of line
-    while (!is_end_of_line(args[index]))
+    // Iterate through the values until end of line
+    while (token < scan->count)
     {
         // Check for unexpected comma
-        if (args[index] == ',')
+        if (scan->tokens[token].kind == COMMA_TOKEN)
         {
             err = DATA_UNEXPECTED_COMMA; // Error handling: set error if unexpected comma found
             return FALSE;                // Return FALSE indicating unexpected comma
         }
+        token = word_span(scan, token, &start, &length);
 
-        // Convert string to long integer
-        value = strtol(&args[index], &rest, 10);
+        // Convert string to long integer, the value ends at white space or a comma so the conversion stays inside it
+        value = strtol(start, &rest, 10);
 
-        // If rest points to the same location as index, it means no numeric value was found
-        if (rest == &args[index])
+        // An expression is folded into its value
+        if (is_expression(start, length))
         {
-            // Find next symbol
-            index += find_next_symbol(&args[index], arg, ',');
+            if (!evaluate_expression(start, length, &value))
+            {
+                return FALSE; // Return FALSE indicating the expression is not valid
+            }
+            if (!is_in_range(value))
+            {
+                err = NUM_OUT_OF_RANGE; // Error handling: set error if number out of range
+                return FALSE;           // Return FALSE indicating number out of range
+            }
+            insert_data((int)value);
+            end = start + length;
+        }
+        // If rest points to the start of the value, it means no numeric value was found
+        else if (rest == start)
+        {
+            // Copy the symbol, up to the longest symbol allowed
+            if (length > SYMBOL_MAX_SIZE)
+                length = SYMBOL_MAX_SIZE;
+            memcpy(arg, start, length);
+            arg[length] = '\0';
+            end = start + length;
 
             // Check if symbol is valid
             if (!is_valid_symbol(arg))
@@ -240,8 +253,7 @@ int dataHandler(char *args)
         }
         else
         {
-            // Move index by the difference between rest and the start of args
-            index += (rest - (args + index));
+            end = rest;
 
             // Check if the numeric value is within range
             if (!is_in_range(value))
@@ -254,36 +266,65 @@ int dataHandler(char *args)
             insert_data((int)value);
         }
 
-        // Move index to the next non-white space character
-        MOVE_TO_NOT_WHITE(args, index);
+        // Characters left in the value mean a comma is missing after the part that was used
+        if (end != start + length)
+        {
+            err = DATA_EXPECTED_COMMA_AFTER_NUM; // Error handling: set error if expected comma after numeric value
+            return FALSE;                        // Return FALSE indicating expected comma after numeric value
+        }
 
         // Check for a comma and handle accordingly
-        if (args[index] == ',')
+        if (token < scan->count && scan->tokens[token].kind == COMMA_TOKEN)
         {
-            index++; // Skip over the comma
-            MOVE_TO_NOT_WHITE(args, index);
+            token++; // Skip over the comma
 
             // Check for trailing comma at the end
-            if (is_end_of_line(args[index]))
+            if (token == scan->count)
             {
                 err = DATA_UNEXPECTED_COMMA; // Error handling: set error if trailing comma found
                 return FALSE;                // Return FALSE indicating trailing comma found
             }
         }
-        else
+        else if (token < scan->count)
         {
-            // If no comma is found, check if it's the end of the line
-            if (!is_end_of_line(args[index]))
-            {
-                err = DATA_EXPECTED_COMMA_AFTER_NUM; // Error handling: set error if expected comma after numeric value
-                return FALSE;                        // Return FALSE indicating expected comma after numeric value
-            }
+            // If no comma is found, it must be the end of the line
+            err = DATA_EXPECTED_COMMA_AFTER_NUM; // Error handling: set error if expected comma after numeric value
+            return FALSE;                        // Return FALSE indicating expected comma after numeric value
         }
     }
 
     return TRUE; // Return TRUE indicating successful handling of .data instruction
 }
 
+/**
+ * Lets the .string literals that equal or end another literal share its storage,
+ * once all of them are stored: the data image is compacted and the data labels
+ * move with it. Called at the end of the first pass, before the data labels are
+ * offset past the code.
+ */
+void merge_string_literals(void)
+{
+    int *moved = (int *)malloc((dc + 1) * sizeof(int)); // New position of every data word
+    Symbol *symbol;
+    int size;
+
+    if (moved == NULL)
+        return; // The literals keep their own storage
+    size = merge_strings(&context->strings, &data, dc, moved);
+    if (size >= 0)
+    {
+        for (symbol = symbols; symbol != NULL; symbol = symbol->next)
+        {
+            if (symbol->attribute == DATA)
+                symbol->value = moved[symbol->value];
+        }
+        dc = size;
+        context->stats.strings_pooled = context->strings.merged;
+        context->stats.data_words_pooled = context->strings.merged_words;
+    }
+    free(moved);
+}
+
 /**
  * Handles the .string instruction.
  * @param args The argument string containing the string value.
@@ -291,7 +332,8 @@ int dataHandler(char *args)
  */
 int stringHandler(char *args)
 {
-    int index = 0; // Initialize index to track position in the argument string
+    int index = 0;  // Initialize index to track position in the argument string
+    int start = dc; // Position of the string's first character in the data image
 
     // Move index to the next non-white space character
     MOVE_TO_NOT_WHITE(args, index);
@@ -335,6 +377,10 @@ int stringHandler(char *args)
         return FALSE; // Return FALSE indicating unexpected characters after string
     }
 
+    // In pooled mode the string is recorded, to share storage once all strings are read
+    if (context->pool_strings)
+        add_string(&context->strings, start, dc - start);
+
     return TRUE; // Return TRUE indicating successful parsing of string
 }
 
@@ -442,10 +488,8 @@ int externHandler(char *arg)
     // Set flag indicating that an external symbol exists
     has_external = TRUE;
 
-    // Add the symbol to the symbol table with attribute EXTERNAL and value 0
-    addSymbol(&symbols, symbol, 0, EXTERNAL);
-
-    return TRUE; // Return TRUE indicating successful handling of extern symbol
+    // Add the symbol to the symbol table with attribute EXTERNAL and value 0, FALSE only if memory allocation failed
+    return addSymbol(&symbols, symbol, 0, EXTERNAL);
 }
 
 // int externHandler(char *args)
@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "machine.h"
+#include "blockCache.h"
+#include "batch.h"
+#include "inputFile.h"
+
+/*
+ * asmemu: runs a program assembled by asm (or linked by asmlink).
+ * Usage: asmemu [-i tape|-] [--batch list [-j N] [--scaling]] [--numbers] [--max-steps N] [--single-step]
+ *               [--stats] program
+ * Loads program.ob and runs it from its first instruction until hlt. red reads
+ * the characters of the tape file (or stdin for -); what prn writes is printed
+ * when the program stops. The program runs a basic block at a time, or one
+ * instruction at a time with --single-step. With --batch, the program runs once
+ * for every tape named in the list file, on N threads, and the output of every
+ * run is printed in the order of the list; --scaling runs the batch on 1, 2,
+ * 4... up to N threads and compares their speed.
+ */
+
+/**
+ * Returns the current wall time in seconds.
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * Reads the tapes named in a list file, one name per line, into the runs of a batch.
+ * @param batch The batch, which receives the runs.
+ * @param list The name of the list file.
+ * @return TRUE if every tape was read, FALSE otherwise (after printing an error).
+ */
+static int read_tapes(emuBatch *batch, char *list)
+{
+    inputFile input;
+    lineView line;
+    emuRun *run;
+    FILE *file;
+    int capacity = 0, length;
+
+    file = fopen(list, "r");
+    if (file == NULL || !open_input(&input, file))
+    {
+        fprintf(stderr, "%s: Error: Cannot read the list of tapes.\n", list);
+        return FALSE;
+    }
+    fclose(file);
+
+    while (next_line(&input, &line))
+    {
+        length = line.length;
+        while (length > 0 && (line.start[length - 1] == '\n' || line.start[length - 1] == '\r'))
+            length--;
+        if (length == 0)
+            continue;
+        if (batch->count == capacity)
+        {
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            run = (emuRun *)realloc(batch->runs, capacity * sizeof(emuRun));
+            if (run == NULL)
+            {
+                fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+                close_input(&input);
+                return FALSE;
+            }
+            batch->runs = run;
+        }
+        run = &batch->runs[batch->count];
+        memset(run, 0, sizeof(emuRun));
+        open_buffer(&run->tape, NULL, 0);
+        run->tape_name = (char *)malloc(length + 1);
+        if (run->tape_name == NULL)
+        {
+            fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+            close_input(&input);
+            return FALSE;
+        }
+        memcpy(run->tape_name, line.start, length);
+        run->tape_name[length] = '\0';
+        batch->count++;
+
+        file = fopen(run->tape_name, "r");
+        if (file == NULL || !open_input(&run->tape, file))
+        {
+            fprintf(stderr, "%s: Error: Cannot read the input tape.\n", run->tape_name);
+            if (file != NULL)
+                fclose(file);
+            close_input(&input);
+            return FALSE;
+        }
+        fclose(file);
+    }
+    close_input(&input);
+    return TRUE;
+}
+
+/**
+ * Runs a batch and prints the output of every run in order, then the speed of
+ * the batch; with scaling, the batch is run on 1, 2, 4... up to threads threads
+ * first and the speed of each is compared with one thread.
+ * @param batch The batch.
+ * @param name The name of the object file.
+ * @param threads The number of worker threads.
+ * @param stats TRUE to print the speed of the batch.
+ * @param scaling TRUE to compare the speed on different numbers of threads.
+ * @return TRUE if every run halted, FALSE otherwise.
+ */
+static int run_batch_mode(emuBatch *batch, char *name, int threads, int stats, int scaling)
+{
+    double start, seconds, single = 0;
+    long steps;
+    int n, i, halted = TRUE;
+
+    for (n = scaling ? 1 : threads;; n = n * 2 < threads ? n * 2 : threads)
+    {
+        start = now();
+        if (!run_batch(batch, n))
+        {
+            fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+            return FALSE;
+        }
+        seconds = now() - start;
+        for (steps = 0, i = 0; i < batch->count; i++)
+            steps += batch->runs[i].steps;
+        if (n == 1)
+            single = seconds;
+        if (scaling)
+            fprintf(stderr, "%d threads: %.3f s (%.1f million instructions/s, %.2fx)\n", n, seconds,
+                    seconds > 0 ? steps / seconds / 1e6 : 0.0, seconds > 0 ? single / seconds : 0.0);
+        if (n == threads)
+            break;
+    }
+
+    for (i = 0; i < batch->count; i++)
+    {
+        printf("==> %s <==\n", batch->runs[i].tape_name);
+        fwrite(batch->runs[i].output, 1, batch->runs[i].output_length, stdout);
+        fflush(stdout);
+        if (batch->runs[i].status != EMU_HALTED)
+        {
+            fprintf(stderr, "%s: Error: %s at address %u with tape %s.\n", name,
+                    emu_status_text(batch->runs[i].status), batch->runs[i].pc, batch->runs[i].tape_name);
+            halted = FALSE;
+        }
+    }
+    if (stats)
+        fprintf(stderr, "%d runs, %ld instructions in %.3f s on %d threads (%.1f million instructions/s)\n",
+                batch->count, steps, seconds, threads, seconds > 0 ? steps / seconds / 1e6 : 0.0);
+    return halted;
+}
+
+int main(int argc, char *argv[])
+{
+    char *program = NULL, *tape = NULL, *list = NULL, *name;
+    long max_steps = -1;       // No limit unless --max-steps is given
+    int numbers = FALSE, stats = FALSE, single_step = FALSE, scaling = FALSE, threads = 1, i;
+    emuImage image;
+    emuBatch batch;
+    emuMachine machine;
+    blockCache cache;
+    inputFile input;
+    FILE *file;
+    double start, seconds;
+    emuStatus status;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            tape = argv[++i];
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+            list = argv[++i];
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--scaling") == 0)
+            scaling = TRUE;
+        else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc)
+            max_steps = atol(argv[++i]);
+        else if (strcmp(argv[i], "--numbers") == 0)
+            numbers = TRUE;
+        else if (strcmp(argv[i], "--single-step") == 0)
+            single_step = TRUE;
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = TRUE;
+        else if (argv[i][0] != '-')
+            program = argv[i];
+        else
+            break; // An unknown option, or an option without its value
+    }
+    if (i < argc || program == NULL || threads < 1)
+    {
+        if (i < argc)
+            fprintf(stderr, "%s: unknown option or missing value: %s\n", argv[0], argv[i]);
+        fprintf(stderr,
+                "usage: %s [-i tape|-] [--batch list [-j N] [--scaling]] [--numbers] [--max-steps N] [--single-step] "
+                "[--stats] program\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Load and decode the program
+    name = (char *)malloc(strlen(program) + sizeof(".ob"));
+    if (name == NULL)
+    {
+        fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+        return EXIT_FAILURE;
+    }
+    sprintf(name, "%s.ob", program);
+    file = fopen(name, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "%s: Error: Cannot open the object file.\n", name);
+        return EXIT_FAILURE;
+    }
+    i = load_image(&image, file);
+    fclose(file);
+    if (!i)
+    {
+        fprintf(stderr, "%s: Error: Invalid object file.\n", name);
+        return EXIT_FAILURE;
+    }
+
+    // A batch shares the image between the runs of every tape
+    if (list != NULL)
+    {
+        memset(&batch, 0, sizeof(emuBatch));
+        batch.image = &image;
+        batch.max_steps = max_steps;
+        batch.numbers = numbers;
+        batch.single_step = single_step;
+        i = read_tapes(&batch, list) && run_batch_mode(&batch, name, threads, stats, scaling);
+        free_batch_runs(&batch);
+        free_image(&image);
+        free(name);
+        return i ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (!init_machine(&machine, &image) || !init_block_cache(&cache, &image))
+    {
+        fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+        return EXIT_FAILURE;
+    }
+    machine.numbers = numbers;
+
+    // The input tape is read whole before the program starts
+    open_buffer(&input, NULL, 0);
+    if (tape != NULL)
+    {
+        file = strcmp(tape, "-") == 0 ? stdin : fopen(tape, "r");
+        if (file == NULL || !open_input(&input, file))
+        {
+            fprintf(stderr, "%s: Error: Cannot read the input tape.\n", tape);
+            return EXIT_FAILURE;
+        }
+        if (file != stdin)
+            fclose(file);
+        machine.input = input.text;
+        machine.input_length = input.length;
+    }
+
+    start = now();
+    status = single_step ? run_machine(&machine, max_steps) : run_blocks(&machine, &cache, max_steps);
+    seconds = now() - start;
+
+    fwrite(machine.output, 1, machine.output_length, stdout);
+    fflush(stdout);
+    if (status != EMU_HALTED)
+        fprintf(stderr, "%s: Error: %s at address %u.\n", name, emu_status_text(status), machine.pc);
+    if (stats)
+        fprintf(stderr, "%ld instructions in %.3f s (%.1f million instructions/s)\n", machine.steps, seconds,
+                seconds > 0 ? machine.steps / seconds / 1e6 : 0.0);
+    if (stats && !single_step)
+        fprintf(stderr, "%ld blocks run, %ld translated (%.2f%% hit rate), %ld fused, %ld code writes\n", cache.entered,
+                cache.translated, cache.entered > 0 ? 100.0 * (cache.entered - cache.translated) / cache.entered : 0.0,
+                cache.fused, cache.flushes);
+
+    close_input(&input);
+    free_block_cache(&cache);
+    free_machine(&machine);
+    free_image(&image);
+    free(name);
+    return status == EMU_HALTED ? EXIT_SUCCESS : EXIT_FAILURE;
+}
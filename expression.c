@@ -0,0 +1,317 @@
+#include <ctype.h>
+#include <string.h>
+#include "utils.h"
+#include "expression.h"
+#include "vars.h"
+
+typedef struct exprParser
+{
+    char *p;       // The next character to read
+    char *end;     // The end of the expression
+    error failure; // Why the expression is not valid, FALSE while it is
+} exprParser;      // Definition of the state of an expression being folded
+
+static int parse_or(exprParser *parser, long *value);
+
+/**
+ * Moves the parser past blanks.
+ * @param parser The parser.
+ */
+static void skip_blanks(exprParser *parser)
+{
+    while (parser->p < parser->end && isspace((unsigned char)*parser->p))
+        parser->p++;
+}
+
+/**
+ * Moves the parser past an operator if it is next.
+ * @param parser The parser.
+ * @param text The operator.
+ * @return TRUE if the operator was next, FALSE otherwise.
+ */
+static int accept(exprParser *parser, const char *text)
+{
+    int length = (int)strlen(text);
+
+    skip_blanks(parser);
+    if (parser->end - parser->p < length || strncmp(parser->p, text, length) != 0)
+        return FALSE;
+    parser->p += length;
+    return TRUE;
+}
+
+/**
+ * Records why the expression is not valid.
+ * @param parser The parser.
+ * @param code The error.
+ * @return FALSE, for the caller to return.
+ */
+static int fail(exprParser *parser, error code)
+{
+    if (!parser->failure)
+        parser->failure = code;
+    return FALSE;
+}
+
+/**
+ * Checks that a value folded so far stays inside EXPRESSION_LIMIT.
+ * @param parser The parser.
+ * @param value The value.
+ * @return TRUE if it does, FALSE otherwise.
+ */
+static int check_limit(exprParser *parser, long value)
+{
+    if (value > EXPRESSION_LIMIT || value < -EXPRESSION_LIMIT)
+        return fail(parser, NUM_OUT_OF_RANGE);
+    return TRUE;
+}
+
+/**
+ * Reads a number, a constant's name or an expression in parentheses.
+ * @param parser The parser.
+ * @param value Receives the value.
+ * @return TRUE if it was valid, FALSE otherwise.
+ */
+static int parse_primary(exprParser *parser, long *value)
+{
+    char name[SYMBOL_MAX_SIZE + 1]; // The constant's name
+    Symbol *symbol;
+    int length = 0;
+
+    skip_blanks(parser);
+    if (accept(parser, "("))
+        return parse_or(parser, value) && (accept(parser, ")") || fail(parser, EXPRESSION_INVALID));
+
+    if (parser->p < parser->end && isdigit((unsigned char)*parser->p))
+    {
+        for (*value = 0; parser->p < parser->end && isdigit((unsigned char)*parser->p); parser->p++)
+        {
+            *value = *value * 10 + (*parser->p - '0');
+            if (!check_limit(parser, *value))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    // A name must be a constant defined on an earlier line
+    while (parser->p + length < parser->end && isalnum((unsigned char)parser->p[length]))
+        length++;
+    if (length == 0 || !isalpha((unsigned char)*parser->p))
+        return fail(parser, EXPRESSION_INVALID);
+    if (length > SYMBOL_MAX_SIZE)
+        return fail(parser, EXPRESSION_NOT_CONSTANT);
+    memcpy(name, parser->p, length);
+    name[length] = '\0';
+    parser->p += length;
+    symbol = findSymbol(&symbols, name);
+    if (symbol == NULL || symbol->attribute != MDEFINE)
+        return fail(parser, EXPRESSION_NOT_CONSTANT);
+    *value = symbol->value;
+    return TRUE;
+}
+
+/**
+ * Reads a value with any number of unary + and - before it.
+ */
+static int parse_unary(exprParser *parser, long *value)
+{
+    if (accept(parser, "-"))
+    {
+        if (!parse_unary(parser, value))
+            return FALSE;
+        *value = -*value;
+        return TRUE;
+    }
+    if (accept(parser, "+"))
+        return parse_unary(parser, value);
+    return parse_primary(parser, value);
+}
+
+/**
+ * Reads products, quotients and remainders. Division truncates toward zero.
+ */
+static int parse_product(exprParser *parser, long *value)
+{
+    long right;
+    char op;
+
+    if (!parse_unary(parser, value))
+        return FALSE;
+    for (;;)
+    {
+        if (accept(parser, "*"))
+            op = '*';
+        else if (accept(parser, "/"))
+            op = '/';
+        else if (accept(parser, "%"))
+            op = '%';
+        else
+            return TRUE;
+        if (!parse_unary(parser, &right))
+            return FALSE;
+        if (op != '*' && right == 0)
+            return fail(parser, EXPRESSION_DIVISION_BY_ZERO);
+        *value = op == '*' ? *value * right : op == '/' ? *value / right : *value % right;
+        if (!check_limit(parser, *value))
+            return FALSE;
+    }
+}
+
+/**
+ * Reads sums and differences.
+ */
+static int parse_sum(exprParser *parser, long *value)
+{
+    long right;
+    int add;
+
+    if (!parse_product(parser, value))
+        return FALSE;
+    for (;;)
+    {
+        if (accept(parser, "+"))
+            add = TRUE;
+        else if (accept(parser, "-"))
+            add = FALSE;
+        else
+            return TRUE;
+        if (!parse_product(parser, &right))
+            return FALSE;
+        *value = add ? *value + right : *value - right;
+        if (!check_limit(parser, *value))
+            return FALSE;
+    }
+}
+
+/**
+ * Reads shifts. A shift count must be between 0 and 30; >> of a negative value rounds down.
+ */
+static int parse_shift(exprParser *parser, long *value)
+{
+    long right;
+    int left;
+
+    if (!parse_sum(parser, value))
+        return FALSE;
+    for (;;)
+    {
+        if (accept(parser, "<<"))
+            left = TRUE;
+        else if (accept(parser, ">>"))
+            left = FALSE;
+        else
+            return TRUE;
+        if (!parse_sum(parser, &right))
+            return FALSE;
+        if (right < 0 || right > 30)
+            return fail(parser, NUM_OUT_OF_RANGE);
+        if (left)
+            *value = *value * (1L << right);
+        else
+            *value = *value >= 0 ? *value >> right : -((-*value - 1) >> right) - 1;
+        if (!check_limit(parser, *value))
+            return FALSE;
+    }
+}
+
+/**
+ * Reads bitwise ands.
+ */
+static int parse_and(exprParser *parser, long *value)
+{
+    long right;
+
+    if (!parse_shift(parser, value))
+        return FALSE;
+    while (accept(parser, "&"))
+    {
+        if (!parse_shift(parser, &right))
+            return FALSE;
+        *value &= right;
+    }
+    return TRUE;
+}
+
+/**
+ * Reads bitwise ors, the operator that binds least.
+ */
+static int parse_or(exprParser *parser, long *value)
+{
+    long right;
+
+    if (!parse_and(parser, value))
+        return FALSE;
+    while (accept(parser, "|"))
+    {
+        if (!parse_and(parser, &right))
+            return FALSE;
+        *value |= right;
+    }
+    return TRUE;
+}
+
+/**
+ * Tells if a value has to be folded as an expression: it holds an operator or a
+ * parenthesis, or a sign that is not the sign of a number. Plain numbers and
+ * names keep being read as before, with their own error messages.
+ * @param start The first character of the value.
+ * @param length Number of characters of the value.
+ * @return TRUE if the value is an expression, FALSE otherwise.
+ */
+int is_expression(char *start, int length)
+{
+    int i;
+
+    if (length > 1 && (start[0] == '+' || start[0] == '-') && !isdigit((unsigned char)start[1]))
+        return TRUE;
+    for (i = 0; i < length; i++)
+    {
+        if (strchr("*/%<>&|()", start[i]) != NULL || (i > 0 && (start[i] == '+' || start[i] == '-')))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Folds an expression into its value. On failure err is set to the reason.
+ * @param start The first character of the expression.
+ * @param length Number of characters of the expression.
+ * @param value Receives the value.
+ * @return TRUE if the expression is valid, FALSE otherwise.
+ */
+int evaluate_expression(char *start, int length, long *value)
+{
+    exprParser parser;
+
+    parser.p = start;
+    parser.end = start + length;
+    parser.failure = FALSE;
+    if (parse_or(&parser, value))
+    {
+        skip_blanks(&parser);
+        if (parser.p == parser.end)
+            return TRUE;
+        fail(&parser, EXPRESSION_INVALID); // Characters left after the expression
+    }
+    err = parser.failure;
+    return FALSE;
+}
+
+/**
+ * Folds the expression of an immediate or index operand and checks that its value
+ * fits in an operand word. On failure err is set to the reason.
+ * @param text The expression, null-terminated.
+ * @param value Receives the value.
+ * @return TRUE if the expression is valid and in range, FALSE otherwise.
+ */
+int fold_constant(char *text, long *value)
+{
+    if (!evaluate_expression(text, (int)strlen(text), value))
+        return FALSE;
+    if (!is_in_range((int)*value))
+    {
+        err = NUM_OUT_OF_RANGE;
+        return FALSE;
+    }
+    return TRUE;
+}
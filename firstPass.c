@@ -6,29 +6,43 @@
 #include "cmdHandlers.h"
 #include "vars.h"
 #include "firstPass.h"
+#include "secondPass.h"
 
 /**
  * Performs the first pass of the assembler, processing each line in the input file.
- * @param fp Pointer to the input file.
+ * @param src The in-memory expanded source.
  */
-void first_pass(FILE *fp)
+void first_pass(sourceBuffer *src)
 {
-    char line[LINESIZE + 2]; // Buffer to hold each line read from the file
-    int line_num = 1;        // Line number counter
+    char *line;             // Pointer to the current line of the source buffer
+    int line_num = 1;       // Line number counter
+    int is_valid;           // Flag indicating the line was processed
+    int overflowed = FALSE; // Flag indicating the program was reported as larger than the memory
 
     ic = 0; // Initialize instruction counter
     dc = 0; // Initialize data counter
 
     has_error = FALSE; // Flag to indicate if an error has occurred
 
-    // Loop through each line in the file
-    while (fgets(line, sizeof(line), fp) != NULL)
+    // Loop through each line in the source buffer
+    while ((line = get_line(src, line_num - 1)) != NULL)
     {
         err = FALSE;  // Reset error flag for each line
         warn = FALSE; // Reset warning flag for each line
 
         // Process the current line
-        if (!process_line(line))
+        is_valid = process_line(line, line_num);
+
+        // A program larger than the memory is reported once, on the first line that does not fit.
+        // Words reserved for label operands are only counted, so the counters are checked too.
+        if (err == PROGRAM_TOO_LARGE || ic + dc + RESERVED_MEMORY > memory_size())
+        {
+            has_error = TRUE;
+            if (!overflowed)
+                print_error_message(PROGRAM_TOO_LARGE, line_num);
+            overflowed = TRUE;
+        }
+        if (!is_valid && err != PROGRAM_TOO_LARGE)
         {                                       // If an error occurred while processing the line
             has_error = TRUE;                   // Set error flag
             print_error_message(err, line_num); // Print error message
@@ -43,6 +57,10 @@ void first_pass(FILE *fp)
         line_num++; // Increment line number
     }
 
+    // In pooled mode the strings that equal or end another one share its storage
+    if (context->pool_strings && !has_error)
+        merge_string_literals();
+
     // Adjust the data offset in the symbol table
     offset_data(&symbols, ic + RESERVED_MEMORY);
 }
@@ -50,35 +68,34 @@ void first_pass(FILE *fp)
 /**
  * Processes a line of assembly code during the first pass of the assembler.
  * @param line The line of assembly code to process.
+ * @param line_num The line's number in the expanded source.
  * @return TRUE if the line was processed successfully, FALSE otherwise.
  */
-int process_line(char *line)
+int process_line(char *line, int line_num)
 {
     instruction instruction;          // Variable to hold the detected instruction
     char symbol[SYMBOL_MAX_SIZE + 1]; // Buffer to store symbols
-    int index = 0;                    // Index to track the position in the line
+    lineScan scan;                    // The line's tokens
+    int token = 0;                    // Index of the current token
+    char *args;                       // Start of a directive's arguments
 
-    // Move index to the next non-white space character
-    MOVE_TO_NOT_WHITE(line, index);
+    // Split the line into tokens
+    scan_line(line, &scan);
 
-    // Find and process label if present
-    if (find_label(line, symbol) && !is_valid_symbol(symbol))
+    // Find and process label if present, a label definition needs a colon
+    symbol[0] = '\0';
+    if (scan.colon >= 0 && find_label(line, symbol) && !is_valid_symbol(symbol))
     {
         return FALSE; // Invalid symbol
     }
     if (symbol[0])
     {
-        // Move index past the label
-        for (; line[index] != ':'; index++)
-            ;
-        index++;
+        // Move past the label
+        token = token_at(&scan, scan.colon + 1);
     }
 
-    // Move index to the next non-white space character
-    MOVE_TO_NOT_WHITE(line, index);
-
     // Check for an empty label
-    if (symbol[0] && is_end_of_line(line[index]))
+    if (symbol[0] && token == scan.count)
     {
         warn = WARNING_EMPTY_LABEL;
         return TRUE;
@@ -92,7 +109,7 @@ int process_line(char *line)
     }
 
     // Find the instruction in the line
-    instruction = find_instruction(line, &index);
+    instruction = find_instruction(&scan, &token);
 
     // Check for specific cases related to instructions and symbols
     if (instruction == DEFINE_IN && symbol[0] != '\0')
@@ -102,11 +119,12 @@ int process_line(char *line)
     }
     if ((instruction == STRING_IN || instruction == DATA_IN) && symbol[0] != '\0')
     {
-        addSymbol(&symbols, symbol, dc, DATA); // Add symbol to symbol table for data or string
+        if (!addSymbol(&symbols, symbol, dc, DATA)) // Add symbol to symbol table for data or string
+            return FALSE;
     }
 
-    // Move index to the next non-white space character
-    MOVE_TO_NOT_WHITE(line, index);
+    // The arguments start at the next token
+    args = token < scan.count ? scan.tokens[token].start : line + scan.length;
 
     // Process the instruction or directive
     if (instruction != NONE_IN)
@@ -114,44 +132,80 @@ int process_line(char *line)
         switch (instruction)
         {
         case DEFINE_IN:
-            return defineHandler(&line[index]); // Handle define directive
+            return defineHandler(args); // Handle define directive
         case STRING_IN:
-            return stringHandler(&line[index]); // Handle string directive
+            return stringHandler(args); // Handle string directive
         case DATA_IN:
-            return dataHandler(&line[index]); // Handle data directive
+            return dataHandler(&scan, token); // Handle data directive
         case EXTERN_IN:
-            return externHandler(&line[index]); // Handle extern directive
+            return externHandler(args); // Handle extern directive
         case ENTRY_IN:
-            return entryValidator(&line[index]); // Handle entry directive
+            return entryValidator(args) && record_entry(args, line_num); // Handle entry directive
         }
     }
 
     // If a label exists, add it to the symbol table
     if (symbol[0])
     {
-        addSymbol(&symbols, symbol, ic + RESERVED_MEMORY, CODE);
+        if (!addSymbol(&symbols, symbol, ic + RESERVED_MEMORY, CODE))
+            return FALSE;
     }
 
     // Process if code
-    return process_code(&line[index]);
+    return process_code(&scan, token, line_num);
+}
+
+/**
+ * Records an .entry statement so the second pass can mark its label without re-reading the line.
+ * @param arg The argument string containing the entry symbol.
+ * @param line_num The line's number in the expanded source.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+int record_entry(char *arg, int line_num)
+{
+    statement item;                   // The recorded statement
+    char symbol[SYMBOL_MAX_SIZE + 1]; // Buffer to store the entry symbol
+    int index = 0;                    // Index to track the position in the argument string
+
+    MOVE_TO_NOT_WHITE(arg, index);
+    find_next_symbol(&arg[index], symbol, ',');
+
+    item.line_num = line_num;
+    item.directive = ENTRY_IN;
+    item.operation = NONE_OP;
+    item.address = 0;
+    item.src.start = &arg[index];
+    item.src.length = strlen(symbol);
+    item.src.type = DIRECT_ADDR;
+    item.dst.type = NONE_ADDR;
+
+    // In single-pass mode the entry is marked together with the fixups
+    if (defer_labels)
+        return add_fixup(&fixups, 0, line_num, ENTRY_IN, symbol);
+    return add_statement(&statements, &item);
 }
 
 /**
  * Processes the code portion of a line of assembly during the first pass of the assembler.
- * @param line The line of assembly code to process.
+ * Operands that do not refer to labels are encoded right away; commands with label
+ * operands are recorded in the statement table for the second pass.
+ * @param scan The scanned line.
+ * @param token Index of the first token of the code portion.
+ * @param line_num The line's number in the expanded source.
  * @return TRUE if the code portion of the line was processed successfully, FALSE otherwise.
  */
-int process_code(char *line)
+int process_code(lineScan *scan, int token, int line_num)
 {
-    opcode operation;               // Variable to hold the detected operation
-    int index = 0;                  // Index to track the position in the line
-    addressing_type first_operand;  // Addressing type of the first operand
-    addressing_type second_operand; // Addressing type of the second operand
-    int count = 0;                  // Counter for the number of operands
+    opcode operation;           // Variable to hold the detected operation
+    operandSpan first_operand;  // Location and addressing type of the first operand
+    operandSpan second_operand; // Location and addressing type of the second operand
+    int count = 0;              // Counter for the number of operands
+    statement item;             // The statement recorded for the second pass
+    int first_fixup;            // Position of the first fixup recorded for this command
+    int is_valid;               // Flag indicating if the command was encoded successfully
 
-    // Find the operation in the line and update index
-    operation = find_operation(line, &index);
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white space character
+    // Find the operation in the line and move past it
+    operation = find_operation(scan, &token);
 
     // Check if operation is found
     if (operation == NONE_OP)
@@ -161,20 +215,20 @@ int process_code(char *line)
     }
 
     // Handle operation and extract operands
-    if (!operationHandler(&line[index], &first_operand, &second_operand))
+    if (!operationHandler(scan, token, &first_operand, &second_operand))
     {
         return FALSE; // Error handling operation, return false
     }
 
     // Check if any operand is invalid
-    if (first_operand == ERROR_ADDR || second_operand == ERROR_ADDR)
+    if (first_operand.type == ERROR_ADDR || second_operand.type == ERROR_ADDR)
     {
         return FALSE; // Invalid operand, return false
     }
 
     // Count the number of operands
-    count += first_operand != NONE_ADDR ? 1 : 0;
-    count += second_operand != NONE_ADDR ? 1 : 0;
+    count += first_operand.type != NONE_ADDR ? 1 : 0;
+    count += second_operand.type != NONE_ADDR ? 1 : 0;
 
     // Validate the number of operands for the operation
     if (!validate_operand_count_by_opcode(operation, count))
@@ -184,19 +238,51 @@ int process_code(char *line)
     }
 
     // Validate the addressing modes for the operands
-    if (!command_accept_methods(operation, first_operand, second_operand))
+    if (!command_accept_methods(operation, first_operand.type, second_operand.type))
     {
         err = COMMAND_INVALID_ADDRESSING;
         return FALSE; // Invalid addressing mode, return false
     }
 
     // Insert the first word into the instructions list
-    insert_instructions(build_first_word(operation, first_operand, second_operand));
+    insert_instructions(build_first_word(operation, first_operand.type, second_operand.type));
+
+    // A single operand is a destination operand
+    item.line_num = line_num;
+    item.directive = NONE_IN;
+    item.operation = operation;
+    item.address = ic;
+    item.src = count == 2 ? first_operand : second_operand;
+    item.dst = count == 2 ? second_operand : first_operand;
+
+    // Encode the additional words now unless an operand refers to a label
+    if (!has_label_operand(&item))
+        return encode_statement(&item);
+
+    // In single-pass mode label words are encoded as placeholders and recorded as fixups
+    if (defer_labels)
+    {
+        first_fixup = fixups.count;
+        is_valid = encode_statement(&item);
+        for (; first_fixup < fixups.count; first_fixup++)
+            fixups.items[first_fixup].line_num = line_num;
+        return is_valid;
+    }
 
-    // Update the instruction counter by the number of additional words required
-    ic += calculate_command_num_additional_words(first_operand, second_operand);
+    // Leave room for the additional words and let the second pass encode them
+    ic += calculate_command_num_additional_words(first_operand.type, second_operand.type);
+    return add_statement(&statements, &item); // FALSE only if memory allocation failed
+}
 
-    return TRUE; // operation processed successfully, return true
+/**
+ * Checks if any operand of a command refers to a label, whose address may not be known yet.
+ * @param item The command's statement.
+ * @return TRUE if an operand uses direct or index addressing, FALSE otherwise.
+ */
+int has_label_operand(statement *item)
+{
+    return item->src.type == DIRECT_ADDR || item->src.type == INDEX_ADDR ||
+           item->dst.type == DIRECT_ADDR || item->dst.type == INDEX_ADDR;
 }
 
 /**
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "fixupTable.h"
+#include "vars.h"
+
+/**
+ * Appends a fixup to the table, growing it when it is full.
+ * @param table Pointer to the fixup table.
+ * @param address Position in the instructions array of the word to patch.
+ * @param line_num Line number in the expanded source.
+ * @param directive ENTRY_IN for an .entry label, NONE_IN for an operand word.
+ * @param name Name of the label.
+ * @return TRUE if the fixup was added, FALSE if memory allocation failed.
+ */
+int add_fixup(fixupTable *table, int address, int line_num, instruction directive, char *name)
+{
+    fixup *items;
+    fixup *item;
+    int id = intern_name(&context->names, name);
+
+    if (id == NO_NAME)
+    {
+        err = FAILED_TO_ALLOCATE_MEMORY;
+        return FALSE;
+    }
+
+    // Double the table's size when it is full
+    if (table->count == table->capacity)
+    {
+        items = (fixup *)checkedAlloc((long)(table->capacity ? table->capacity * 2 : FIXUPS_INITIAL_SIZE) * sizeof(fixup));
+        if (items == NULL)
+        {
+            err = FAILED_TO_ALLOCATE_MEMORY;
+            return FALSE;
+        }
+        if (table->count)
+            memcpy(items, table->items, table->count * sizeof(fixup));
+        free(table->items);
+        table->items = items;
+        table->capacity = table->capacity ? table->capacity * 2 : FIXUPS_INITIAL_SIZE;
+    }
+
+    item = &table->items[table->count++];
+    item->address = address;
+    item->line_num = line_num;
+    item->directive = directive;
+    item->name = name_text(&context->names, id); // Share the pool's copy of the name
+    return TRUE;
+}
+
+/**
+ * Resets the fixup table by freeing its memory.
+ * @param table Pointer to the fixup table.
+ */
+void reset_fixups(fixupTable *table)
+{
+    free(table->items);
+    table->items = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
@@ -3,105 +3,189 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include "vars.h"
+#include "utils.h"
 
 /**
- * Computes the hash value for the given key.
- * @param key The input key.
- * @return The computed hash value.
+ * Computes the two bloom filter bit positions of a hash value.
+ * @param table The hash table.
+ * @param hashval The hash value of the key.
+ * @param first Pointer to store the first bit position.
+ * @param second Pointer to store the second bit position.
+ */
+static void bloom_bits(hashTable *table, unsigned int hashval, unsigned int *first, unsigned int *second)
+{
+    unsigned int bits = table->size * BLOOM_BITS_PER_BUCKET; // A power of 2 as well
+    *first = hashval & (bits - 1);
+    *second = (hashval * 2654435761u >> 7) & (bits - 1);
+}
+
+/**
+ * Marks a key in the first character bitmap and in the bloom filter.
+ * @param table The hash table.
+ * @param entry The entry of the key.
  */
-unsigned int hash(char *key)
+static void mark_key(hashTable *table, hashEntry *entry)
 {
-    unsigned int hashval = 0;
-    // Calculate the hash value for the given key
-    while (*key != '\0')
+    unsigned int first, second;
+    unsigned char chr = (unsigned char)entry->key[0];
+
+    table->first_chars[chr >> 3] |= 1 << (chr & 7);
+    bloom_bits(table, entry->hashval, &first, &second);
+    table->bloom[first >> 3] |= 1 << (first & 7);
+    table->bloom[second >> 3] |= 1 << (second & 7);
+}
+
+/**
+ * Allocates zeroed memory or exits on failure.
+ * @param count Number of elements.
+ * @param size Size of each element.
+ * @return Pointer to the allocated memory.
+ */
+static void *zero_alloc(size_t count, size_t size)
+{
+    void *ptr = calloc(count, size);
+    if (ptr == NULL)
     {
-        hashval = *key + 31 * hashval;
-        key++;
+        fprintf(stderr, "Memory allocation error\n");
+        exit(EXIT_FAILURE);
     }
-    return hashval % HASHSIZE; // Return the hash value within the range of the hash table size
+    return ptr;
 }
 
 /**
- * Looks up a key in the hash table and returns the corresponding node.
+ * Doubles the number of buckets, redistributes the entries and rebuilds the bloom filter.
+ * @param table The hash table.
+ */
+static void grow_table(hashTable *table)
+{
+    hashEntry **old = table->table;
+    unsigned int old_size = table->size;
+    unsigned int i;
+    hashEntry *entry, *next;
+
+    table->size *= 2;
+    table->table = (hashEntry **)zero_alloc(table->size, sizeof(hashEntry *));
+    free(table->bloom);
+    table->bloom = (unsigned char *)zero_alloc(table->size * BLOOM_BITS_PER_BUCKET / 8, 1);
+
+    // Move every entry to its bucket in the new table
+    for (i = 0; i < old_size; i++)
+    {
+        for (entry = old[i]; entry != NULL; entry = next)
+        {
+            next = entry->next;
+            entry->next = table->table[entry->hashval & (table->size - 1)];
+            table->table[entry->hashval & (table->size - 1)] = entry;
+            mark_key(table, entry);
+        }
+    }
+    free(old);
+}
+
+/**
+ * Looks up a key in the hash table and returns the corresponding entry.
+ * Most source lines do not start with a macro name, so negative lookups are
+ * answered by the first character bitmap or the bloom filter when possible.
  * @param table The hash table.
  * @param key The key to search for.
- * @return The node associated with the key, or NULL if the key is not found.
+ * @return The entry associated with the key, or NULL if the key is not found.
  */
-node *lookup(hashTable *table, char *key)
+hashEntry *lookup(hashTable *table, char *key)
 {
-    // Calculate the hash value for the key
-    unsigned int hash_index = hash(key);
+    unsigned char chr = (unsigned char)key[0];
+    unsigned int hashval, first, second;
+    int id;
+
+    table->lookups++;
+
+    // No key starts with this character
+    if (!(table->first_chars[chr >> 3] & (1 << (chr & 7))))
+    {
+        table->filtered++;
+        return NULL;
+    }
+
+    // A name that was never interned is not a macro
+    id = find_name(&context->names, key);
+    if (id == NO_NAME)
+    {
+        table->filtered++;
+        return NULL;
+    }
+
+    // Check the bloom filter with the name's cached hash value
+    hashval = name_hash(&context->names, id);
+    bloom_bits(table, hashval, &first, &second);
+    if (!(table->bloom[first >> 3] & (1 << (first & 7))) || !(table->bloom[second >> 3] & (1 << (second & 7))))
+    {
+        table->filtered++;
+        return NULL;
+    }
+
     // Iterate through the linked list of entries at the calculated hash index
-    for (hashEntry *entry = table->table[hash_index]; entry != NULL; entry = entry->next)
+    for (hashEntry *entry = table->table[hashval & (table->size - 1)]; entry != NULL; entry = entry->next)
     {
-        if (strcmp(entry->key, key) == 0)
-            return entry->lines; // Return the first node of the linked list of lines
+        table->probes++;
+        if (entry->key_id == id)
+            return entry; // Return the entry holding the macro's body
     }
     return NULL; // Key not found
 }
 
 /**
- * Inserts a new entry into the hash table.
+ * Appends a line to the body of a key, creating the entry if the key is new.
  * @param table The hash table.
  * @param key The key to insert.
  * @param line The line associated with the key.
+ * @param length The number of characters in the line.
+ * @return TRUE on success, FALSE if memory allocation failed (err is set).
  */
-void insert(hashTable *table, char *key, char *line)
+int insert(hashTable *table, char *key, char *line, int length)
 {
-    unsigned int hashval = hash(key);
-    hashEntry *entry = table->table[hashval];
+    int id = intern_name(&context->names, key);
+    unsigned int hashval;
+    hashEntry *entry;
+
+    if (id == NO_NAME)
+    {
+        err = FAILED_TO_ALLOCATE_MEMORY;
+        return FALSE;
+    }
+    hashval = name_hash(&context->names, id);
+    entry = table->table[hashval & (table->size - 1)];
     // Iterate through the linked list of entries at the calculated hash index
     while (entry != NULL)
     {
-        if (strcmp(entry->key, key) == 0)
+        if (entry->key_id == id)
         {
-            // Key already exists, add line to existing node
-            node *new_node = (node *)malloc(sizeof(node));
-            if (new_node == NULL)
-            {
-                fprintf(stderr, "Memory allocation error\n");
-                exit(EXIT_FAILURE);
-            }
-            new_node->line = strdup(line);
-            if (new_node->line == NULL)
-            {
-                fprintf(stderr, "Memory allocation error\n");
-                exit(EXIT_FAILURE);
-            }
-            new_node->next = entry->lines;
-            entry->lines = new_node;
-            return;
+            // Key already exists, add line to the end of its body
+            append_line(&entry->body, line, length);
+            return TRUE;
         }
         entry = entry->next;
     }
-    // Key doesn't exist, create new entry
-    entry = (hashEntry *)malloc(sizeof(hashEntry));
+    // Key doesn't exist, create new entry in the file's arena
+    entry = (hashEntry *)arenaAlloc(sizeof(hashEntry));
     if (entry == NULL)
     {
-        fprintf(stderr, "Memory allocation error\n");
-        exit(EXIT_FAILURE);
-    }
-    entry->key = strdup(key);
-    if (entry->key == NULL)
-    {
-        fprintf(stderr, "Memory allocation error\n");
-        exit(EXIT_FAILURE);
-    }
-    entry->lines = (node *)malloc(sizeof(node));
-    if (entry->lines == NULL)
-    {
-        fprintf(stderr, "Memory allocation error\n");
-        exit(EXIT_FAILURE);
-    }
-    entry->lines->line = strdup(line);
-    if (entry->lines->line == NULL)
-    {
-        fprintf(stderr, "Memory allocation error\n");
-        exit(EXIT_FAILURE);
+        err = FAILED_TO_ALLOCATE_MEMORY;
+        return FALSE;
     }
-    entry->lines->next = NULL;
-    entry->next = table->table[hashval];
-    table->table[hashval] = entry;
+    entry->key = name_text(&context->names, id); // Share the pool's copy of the name
+    entry->key_id = id;
+    entry->hashval = hashval;
+    initSource(&entry->body);
+    append_line(&entry->body, line, length);
+
+    // Grow the table before the chains get long
+    if ((table->count + 1) * HASH_MAX_LOAD_DEN > table->size * HASH_MAX_LOAD_NUM)
+        grow_table(table);
+
+    entry->next = table->table[hashval & (table->size - 1)];
+    table->table[hashval & (table->size - 1)] = entry;
+    table->count++;
+    mark_key(table, entry);
+    return TRUE;
 }
 
 /**
@@ -116,11 +200,13 @@ hashTable *initTable()
         fprintf(stderr, "Memory allocation error\n");
         exit(EXIT_FAILURE);
     }
-    // Initialize all entries of the hash table to NULL
-    for (int i = 0; i < HASHSIZE; i++)
-    {
-        table->table[i] = NULL;
-    }
+    // Initialize all buckets, the bitmap and the bloom filter to empty
+    table->size = HASHSIZE;
+    table->table = (hashEntry **)zero_alloc(HASHSIZE, sizeof(hashEntry *));
+    table->bloom = (unsigned char *)zero_alloc(HASHSIZE * BLOOM_BITS_PER_BUCKET / 8, 1);
+    table->count = 0;
+    memset(table->first_chars, 0, sizeof(table->first_chars));
+    table->lookups = table->filtered = table->probes = 0;
     return table;
 }
 
@@ -131,30 +217,58 @@ hashTable *initTable()
 void resetTable(hashTable *table)
 {
     hashEntry *entry;
-    node *current;
     // Iterate through all entries of the hash table
-    for (int i = 0; i < HASHSIZE; i++)
+    for (unsigned int i = 0; i < table->size; i++)
     {
         entry = table->table[i];
         // Iterate through the linked list of entries at each hash index
         while (entry != NULL)
         {
             hashEntry *tmp = entry->next;
-            // Free the key
-            free(entry->key);
-            // Free the linked list of nodes containing lines
-            current = entry->lines;
-            while (current != NULL)
-            {
-                node *tmpNode = current->next;
-                free(current->line);
-                free(current);
-                current = tmpNode;
-            }
-            free(entry);
+            // Free the macro's body, the entry and its key live in the file's arena
+            resetSource(&entry->body);
             entry = tmp;
         }
         // Set the table entry to NULL after freeing the linked list
         table->table[i] = NULL;
     }
+
+    // Forget all keys and statistics, the buckets are kept for the next file
+    table->count = 0;
+    memset(table->first_chars, 0, sizeof(table->first_chars));
+    memset(table->bloom, 0, table->size * BLOOM_BITS_PER_BUCKET / 8);
+    table->lookups = table->filtered = table->probes = 0;
+}
+
+/**
+ * Collects chain length and lookup statistics of the hash table.
+ * @param table The hash table.
+ * @param stats Pointer to the structure that receives the statistics.
+ */
+void table_stats(hashTable *table, hashStats *stats)
+{
+    unsigned int i, length;
+    hashEntry *entry;
+
+    stats->keys = table->count;
+    stats->buckets = table->size;
+    stats->used = 0;
+    stats->max_chain = 0;
+
+    // Measure every chain
+    for (i = 0; i < table->size; i++)
+    {
+        length = 0;
+        for (entry = table->table[i]; entry != NULL; entry = entry->next)
+            length++;
+        if (length > 0)
+            stats->used++;
+        if (length > stats->max_chain)
+            stats->max_chain = length;
+    }
+
+    stats->avg_chain = stats->used ? (double)table->count / stats->used : 0;
+    stats->lookups = table->lookups;
+    stats->filtered = table->filtered;
+    stats->avg_probes = table->lookups ? (double)table->probes / table->lookups : 0;
 }
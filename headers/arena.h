@@ -0,0 +1,28 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#define ARENA_BLOCK_SIZE 65536 // Size of a regular arena block, in bytes
+#define ARENA_ALIGNMENT 8      // Every allocation starts at a multiple of this
+#define ARENA_SPARE_BLOCKS 16  // Most regular blocks kept by recycle_arena for the next file
+
+typedef struct arenaBlock
+{
+    struct arenaBlock *next; // The block allocated before this one
+    long size;               // Number of bytes available in the block
+    long used;               // Number of bytes handed out from the block
+} arenaBlock;                // Definition of a block of arena memory, its bytes follow this header
+
+typedef struct arena
+{
+    arenaBlock *blocks; // The blocks, the current one first
+    arenaBlock *spare;  // Emptied regular blocks kept for reuse
+    long allocations;   // Number of allocations made from the arena
+    long bytes;         // Number of bytes handed out by the arena
+    long block_count;   // Number of blocks allocated from the system
+} arena;                // Definition of a bump-pointer allocator freed all at once
+
+void *arena_alloc(arena *pool, long size); // Allocates memory from the arena.
+void reset_arena(arena *pool);             // Frees everything allocated from the arena.
+void recycle_arena(arena *pool);           // Empties the arena, keeping some of its blocks for reuse.
+
+#endif // ARENA_H
@@ -0,0 +1,21 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+#include <stdio.h>
+#include "sourceBuffer.h"
+
+typedef struct asmOptions
+{
+    int emit_am;      // Flag indicating if the .am files should be written
+    int one_pass;     // Flag indicating single-pass assembly with a fixup table
+    int stats;        // Flag indicating if the statistics of every file should be reported
+    int large_memory; // Flag indicating the memory image may grow past MAX_MEMORY_SIZE
+    int optimize;     // Flag indicating the peephole optimizer runs before the output is written
+    int pool_strings; // Flag indicating equal and suffix-sharing .string literals share storage
+} asmOptions;         // Definition of the command-line options
+
+int assemble_passes(sourceBuffer *source, asmOptions *options);              // Runs both passes over an expanded source.
+int assemble_file(char *name, asmOptions *options);                          // Assembles name.as into its output files.
+void assemble_source(char *name, FILE *file, asmOptions *options);           // Assembles an open source as if it were name.as.
+int assemble_files(char **names, int count, int threads, asmOptions *options); // Assembles files, on worker threads if asked.
+
+#endif // ASSEMBLER_H
@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include "machine.h"
+#include "inputFile.h"
+
+/*
+ * Batch runs of the emulator: one program, many input tapes. The image is
+ * loaded and decoded once and shared read-only by worker threads; every
+ * worker keeps one machine and one block cache and runs tapes on them one
+ * after the other. Between runs the machine is reset instead of copied
+ * again: instructions write only to the cells their operands were resolved
+ * to, so only those cells are restored from the image (copy-on-write of the
+ * data memory, decided when the code is decoded). A run whose program wrote
+ * into its code gets the whole memory and the image's code back. What prn
+ * writes is kept per run, so the runs are printed in order afterwards.
+ */
+
+typedef struct emuRun
+{
+    char *tape_name;    // The tape file, as listed
+    inputFile tape;     // The tape read by red
+    char *output;       // Characters written by prn
+    long output_length; // Number of characters written
+    long steps;         // Number of instructions run
+    unsigned int pc;    // Address where the machine stopped
+    emuStatus status;   // Why the machine stopped
+} emuRun;               // Definition of one run of a batch
+
+typedef struct emuBatch
+{
+    emuImage *image;   // The program, shared by every run
+    emuRun *runs;      // The runs, in the order of the list
+    int count;         // Number of runs
+    long max_steps;    // Most instructions of a run, or a negative number for no limit
+    int numbers;       // TRUE if prn writes numbers
+    int single_step;   // TRUE to run one instruction at a time instead of by blocks
+} emuBatch;            // Definition of a program and the tapes it runs on
+
+int run_batch(emuBatch *batch, int threads); // Runs every tape of a batch on worker threads.
+void free_batch_runs(emuBatch *batch);       // Frees the tapes and outputs of the runs.
+
+#endif // BATCH_H
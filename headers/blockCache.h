@@ -0,0 +1,62 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+#include "machine.h"
+#include "arena.h"
+
+/*
+ * Basic-block execution for the emulator. A block is the run of instructions
+ * from an address up to the first jmp, bne, jsr, rts or hlt. The first time
+ * the program reaches an address, the block starting there is translated into
+ * micro-ops and cached; after that, entering the block is a table lookup and
+ * its micro-ops run back to back, with the step count updated once per block.
+ * A cmp, inc or dec followed by a bne to a label becomes one fused micro-op,
+ * the test and the branch of most loops. Writing into the code drops every
+ * block, since they were translated from the old code.
+ */
+
+#define EMU_BLOCK_MAX 64 // Most micro-ops in a block, longer runs are split
+
+typedef enum emuFusedOp
+{
+    EMU_CMP_BNE = ERROR_OP + 1, // cmp followed by bne
+    EMU_INC_BNE,                // inc followed by bne
+    EMU_DEC_BNE,                // dec followed by bne
+    EMU_END_BLOCK               // Goes on to the block at the next address
+} emuFusedOp;
+
+typedef struct emuMicroOp
+{
+    unsigned char handler; // The opcode, an emuFusedOp, or ERROR_OP
+    unsigned char flags;   // The flags of the emuOp
+    unsigned short before; // Number of instructions of the block before this one
+    unsigned int address;  // Address of the (first) instruction
+    unsigned int src;      // Cell or constant of the source operand, the status of an ERROR_OP
+    unsigned int dst;      // Cell or constant of the destination operand
+    unsigned int jump;     // Target of the bne of a fused micro-op
+    unsigned int next;     // Address after the instruction
+} emuMicroOp;              // Definition of an instruction of a block, or two fused ones
+
+typedef struct emuBlock
+{
+    emuMicroOp *ops;  // The micro-ops, the last one leaves the block
+    int count;        // Number of micro-ops
+    int instructions; // Number of instructions the micro-ops stand for
+} emuBlock;           // Definition of a translated basic block
+
+typedef struct blockCache
+{
+    emuBlock **blocks; // The block starting at every code address, NULL until it is reached
+    long size;         // Number of entries of blocks, one more than the code words
+    arena memory;      // Holds the blocks and their micro-ops
+    long entered;      // Number of blocks run
+    long translated;   // Number of blocks translated, the lookups that missed
+    long fused;        // Number of fused micro-ops translated
+    long flushes;      // Times the program wrote into its code
+} blockCache;          // Definition of the blocks of a machine's code
+
+int init_block_cache(blockCache *cache, emuImage *image);               // Prepares an empty cache for an image.
+void flush_block_cache(blockCache *cache);                              // Drops every block.
+void free_block_cache(blockCache *cache);                               // Frees the memory of a cache.
+emuStatus run_blocks(emuMachine *machine, blockCache *cache, long max_steps); // Runs the program block by block.
+
+#endif // BLOCKCACHE_H
@@ -1,8 +1,10 @@
 #ifndef _cmdHandlers_H
 #define _cmdHandlers_H
 #include "globals.h"
+#include "statementTable.h"
+#include "lineScanner.h"
 
-opcode find_operation(char *line, int *index);
+opcode find_operation(lineScan *scan, int *token);
 addressing_type get_addressing_type(char *operand);
-int operationHandler(char *line, addressing_type *first_operand, addressing_type *second_operand);
+int operationHandler(lineScan *scan, int token, operandSpan *first_operand, operandSpan *second_operand);
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+#include <stdio.h>
+#include "globals.h"
+#include "symbolTable.h"
+#include "extTable.h"
+#include "hashTable.h"
+#include "statementTable.h"
+#include "fixupTable.h"
+#include "stats.h"
+#include "segment.h"
+#include "arena.h"
+#include "namePool.h"
+#include "stringPool.h"
+
+typedef void (*diagnosticHook)(void *hook_data, error code, int line_num); // Called with every error and warning of a file
+
+/*
+ * All the state of one file's assembly. Every thread works on its own
+ * context, reached through the thread-local `context` pointer, so several
+ * files can be assembled at the same time. vars.h maps the familiar
+ * names (ic, dc, err, symbols, ...) onto the current context.
+ */
+typedef struct AsmContext
+{
+    int ic;                                                       // Instruction Counter
+    int dc;                                                       // Data Counter
+    int err;                                                      // Error flag
+    int warn;                                                     // Warning flag
+    int has_entry;                                                // Flag indicating if an entry point exists
+    int has_external;                                             // Flag indicating if there are any external symbols
+    int has_error;                                                // Flag indicating if there were any errors during processing
+    int defer_labels;                                             // Flag indicating label words are left in the fixup table (single-pass mode)
+    namePool names;                                               // Every identifier of the file, stored once
+    arena pool;                                                   // Memory of the file's symbols, externals, macros and file names
+    int large_memory;                                             // Flag indicating the memory image may grow past MAX_MEMORY_SIZE
+    int pool_strings;                                             // Flag indicating equal and suffix-sharing .string literals share storage
+    stringPool strings;                                           // The .string literals stored so far, in pooled mode
+    wordSegment data;                                             // Data image
+    wordSegment instructions;                                     // Instructions image
+    Symbol *symbols;                                              // The symbol table
+    symbolIndex symbol_index;                                     // Hash index over the symbol table
+    external *externals;                                          // The external symbols table
+    hashTable *macroTable;                                        // The macro table
+    statementTable statements;                                    // The statements recorded by the first pass
+    fixupTable fixups;                                            // The words left for patching in single-pass mode
+    asmStats stats;                                               // Timings and counters of the file, shown with --stats
+    FILE *out;                                                    // Stream receiving progress messages
+    FILE *diag;                                                   // Stream receiving error and warning messages
+    diagnosticHook on_diagnostic;                                 // Called with every error and warning, NULL if none
+    void *diagnostic_data;                                        // Passed to on_diagnostic
+} AsmContext;                                                     // Definition of a file's assembly state
+
+extern _Thread_local AsmContext *context; // The context of the file the current thread is assembling
+
+AsmContext *create_context(FILE *out, FILE *diag); // Allocates and initializes a new context.
+void free_context(AsmContext *ctx);                // Frees a context and everything it holds.
+void recycle_context(AsmContext *ctx, FILE *out, FILE *diag); // Empties a context for the next file, keeping its memory.
+
+#endif // CONTEXT_H
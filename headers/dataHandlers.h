@@ -1,10 +1,12 @@
 #include "globals.h"
+#include "lineScanner.h"
 
-instruction find_instruction(char *line, int *index);
+instruction find_instruction(lineScan *scan, int *token);
 int find_label(char *line, char *symbol);
 int defineHandler(char *arg);
 int stringHandler(char *args);
-int dataHandler(char *args);
+int dataHandler(lineScan *scan, int token);
 int externHandler(char *arg);
 int entryHandler(char *arg);
 int entryValidator(char *arg);
+void merge_string_literals(void);
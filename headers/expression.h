@@ -0,0 +1,22 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+#include "globals.h"
+
+#define EXPRESSION_LIMIT (1L << 30) // Largest magnitude of a value inside an expression
+
+/*
+ * Integer constant expressions, folded while the line is read: decimal
+ * numbers and names of constants defined earlier with .define, combined
+ * with + - * / % << >> & | and parentheses, with the precedence of C and
+ * unary + and -. The result is checked with is_in_range by the caller, or by
+ * fold_constant for immediate and index operands; values
+ * inside an expression may grow up to EXPRESSION_LIMIT. Inside operands
+ * and .data values an expression is written without blanks, since blanks
+ * separate them; a .define takes the rest of its line.
+ */
+
+int is_expression(char *start, int length);                  // Tells if a value is an expression rather than a number or a name.
+int evaluate_expression(char *start, int length, long *value); // Folds an expression into its value.
+int fold_constant(char *text, long *value);                    // Folds an operand's expression and checks its range.
+
+#endif // EXPRESSION_H
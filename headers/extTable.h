@@ -1,11 +1,16 @@
+#ifndef EXTTABLE_H
+#define EXTTABLE_H
 
 typedef struct external
 {
-    char *name;            // Name of the external symbol
+    char *name;            // Name of the external symbol, shared with the file's name pool
+    int id;                // Id of the name in the file's name pool
     int address;           // Address associated with the external symbol
     struct external *next; // Pointer to the next external symbol in the linked list
 } external;                // Definition of an external symbol structure
 
-void add_ext(external **head, char *name, int address); // Adds a new external entry to the external symbol table.
+int add_ext(external **head, char *name, int address); // Adds a new external entry to the external symbol table.
 
 void reset_ext(external **head); // Resets the external symbol table by freeing memory occupied by all entries.
+
+#endif // EXTTABLE_H
@@ -1,9 +1,14 @@
 #include "utils.h"
+#include "sourceBuffer.h"
+#include "statementTable.h"
+#include "lineScanner.h"
 
-void first_pass(FILE *fp);
+void first_pass(sourceBuffer *src);
 unsigned int build_first_word(opcode operation, addressing_type first_operand, addressing_type second_operand);
 int num_words(addressing_type operand);
-int process_line(char *line);
-int process_code(char *line);
+int process_line(char *line, int line_num);
+int process_code(lineScan *scan, int token, int line_num);
+int record_entry(char *arg, int line_num);
+int has_label_operand(statement *item);
 int calculate_command_num_additional_words(addressing_type first_operand, addressing_type second_operand);
 int command_accept_methods(opcode type, addressing_type first_operand, addressing_type second_operand);
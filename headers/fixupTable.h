@@ -0,0 +1,25 @@
+#ifndef FIXUPTABLE_H
+#define FIXUPTABLE_H
+#include "globals.h"
+
+#define FIXUPS_INITIAL_SIZE 64 // Initial number of fixups allocated
+
+typedef struct fixup
+{
+    int address;                     // Position in the instructions array of the word to patch
+    int line_num;                    // Line number in the expanded source, used for error messages
+    instruction directive;           // ENTRY_IN for an .entry label, NONE_IN for an operand word
+    char *name;                      // Name of the label the word refers to, shared with the file's name pool
+} fixup;                             // Definition of a word left for patching once all labels are known
+
+typedef struct fixupTable
+{
+    fixup *items; // The recorded fixups, in source order
+    int count;    // Number of fixups recorded
+    int capacity; // Number of fixups allocated
+} fixupTable;     // Definition of the list of fixups of a single-pass assembly
+
+int add_fixup(fixupTable *table, int address, int line_num, instruction directive, char *name); // Appends a fixup to the table.
+void reset_fixups(fixupTable *table);                                                          // Resets the table by freeing its memory.
+
+#endif // FIXUPTABLE_H
@@ -3,6 +3,7 @@
 #define _GLOBALS_H
 
 #define MAX_MEMORY_SIZE 4096 // Maximum memory size
+#define LARGE_MEMORY_SIZE (1L << 30) // Maximum memory size in large-memory mode (label words keep 30 bit addresses)
 #define LINESIZE 80          // Maximum line size
 #define SYMBOL_MAX_SIZE 31   // Maximum size of a symbol
 #define RESERVED_MEMORY 100  // Reserved memory space
@@ -111,7 +112,8 @@ typedef enum FILE_TYPE
     AM_FILE,  // Assembled machine code file
     OB_FILE,  // Object file
     ENT_FILE, // Entry file
-    EXT_FILE  // External file
+    EXT_FILE, // External file
+    STATS_FILE // Statistics file
 } FILE_TYPE;
 
 // Error codes for various errors encountered in the program for error handling.
@@ -167,6 +169,10 @@ typedef enum errors
     ENTRY_CANT_BE_EXTERN,
     CANNOT_OPEN_FILE,
     FAILED_TO_CREATE_FILE,
-    FAILED_TO_ALLOCATE_MEMORY
+    FAILED_TO_ALLOCATE_MEMORY,
+    PROGRAM_TOO_LARGE,
+    EXPRESSION_INVALID,
+    EXPRESSION_NOT_CONSTANT,
+    EXPRESSION_DIVISION_BY_ZERO
 } error;
 #endif
@@ -2,31 +2,50 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
-#define HASHSIZE 101
+#include "sourceBuffer.h"
 
-typedef struct _node
-{
-    char *line;
-    struct _node *next;
-} node;
+#define HASHSIZE 128            // Initial number of buckets (always a power of 2)
+#define HASH_MAX_LOAD_NUM 3     // The table grows once keys > buckets * 3 / 4
+#define HASH_MAX_LOAD_DEN 4
+#define BLOOM_BITS_PER_BUCKET 8 // Size of the bloom filter relative to the number of buckets
 
 typedef struct hashEntry
 {
     struct hashEntry *next;
-    char *key;
-    node *lines;
+    char *key;            // The macro's name, shared with the file's name pool
+    int key_id;           // Id of the name in the file's name pool
+    unsigned int hashval; // Full hash value of the key, kept for resizing
+    sourceBuffer body;    // The macro's lines, stored contiguously with a line offset index
 } hashEntry;
 
 typedef struct hashTable
 {
-    hashEntry *table[HASHSIZE];
+    hashEntry **table;                  // The buckets
+    unsigned int size;                  // Number of buckets
+    unsigned int count;                 // Number of keys stored
+    unsigned char first_chars[256 / 8]; // Bitmap of the first characters of all keys
+    unsigned char *bloom;               // Bloom filter over all keys
+    unsigned long lookups;              // Number of lookups made
+    unsigned long filtered;             // Lookups answered negatively by the bitmap or bloom filter
+    unsigned long probes;               // Key comparisons made by lookups
 } hashTable;
 
-unsigned int hash(char *); 
-node *lookup(hashTable *table, char *key);
-void insert(hashTable *table, char *key, char *line);
+typedef struct hashStats
+{
+    unsigned int keys;      // Number of keys stored
+    unsigned int buckets;   // Number of buckets
+    unsigned int used;      // Number of non-empty buckets
+    unsigned int max_chain; // Length of the longest chain
+    double avg_chain;       // Average length of the non-empty chains
+    unsigned long lookups;  // Number of lookups made
+    unsigned long filtered; // Lookups answered negatively without touching a chain
+    double avg_probes;      // Average key comparisons per lookup
+} hashStats;
+
+hashEntry *lookup(hashTable *table, char *key);
+int insert(hashTable *table, char *key, char *line, int length);
 hashTable *initTable();
 void resetTable(hashTable *table);
-// implement lookup, insert and reset
+void table_stats(hashTable *table, hashStats *stats);
 
 #endif // HASHTABLE_H
@@ -0,0 +1,27 @@
+#ifndef INPUTFILE_H
+#define INPUTFILE_H
+#include <stdio.h>
+
+#define INPUT_READ_SIZE 65536 // Bytes read at a time from inputs that cannot be mapped
+
+typedef struct inputFile
+{
+    char *text;    // The whole input
+    long length;   // Number of bytes in text
+    long position; // Offset of the next line
+    int mapped;    // TRUE if text maps the file, FALSE if it was read into memory
+    int borrowed;  // TRUE if text belongs to the caller and is not released
+} inputFile;       // Definition of an input file held in memory as a whole
+
+typedef struct lineView
+{
+    char *start; // First character of the line inside the input
+    int length;  // Number of characters, including the newline if there is one
+} lineView;      // Definition of a line of the input, without a copy or a null terminator
+
+int open_input(inputFile *input, FILE *file);     // Maps a file, or reads it whole if it cannot be mapped.
+void open_buffer(inputFile *input, char *text, long length); // Uses text already in memory as the input.
+int next_line(inputFile *input, lineView *line);  // Returns the next line of the input.
+void close_input(inputFile *input);               // Releases the input's memory.
+
+#endif // INPUTFILE_H
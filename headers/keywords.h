@@ -0,0 +1,29 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#define KEYWORD_SLOTS 64 // Number of slots in the keyword hash (a power of 2)
+
+/* The keyword hash: the length and three characters of the name, mixed with the
+ * multipliers tools/genKeywords picked so that no two keywords share a slot. */
+#define KEYWORD_HASH(name, length, a, b, c)                                                   \
+    ((((unsigned int)(unsigned char)(name)[0] * (a)) ^ ((unsigned int)(unsigned char)(name)[1] * (b)) ^ \
+      ((unsigned int)(unsigned char)(name)[(length) - 1] * (c)) ^ (unsigned int)(length)) &     \
+     (KEYWORD_SLOTS - 1))
+
+typedef enum keyword_kind
+{
+    NOT_KEYWORD,    // Empty slot
+    OPERATION_KW,   // Operation command
+    INSTRUCTION_KW, // Directive
+    REGISTER_KW     // Register
+} keyword_kind;
+
+typedef struct keywordEntry
+{
+    char *name;        // The keyword
+    int length;        // Length of the keyword
+    keyword_kind kind; // What the keyword names
+    int code;          // The keyword's opcode, instruction or register
+} keywordEntry;        // Definition of a slot of the keyword hash
+
+#endif // KEYWORDS_H
@@ -0,0 +1,64 @@
+#ifndef LIBASM_H
+#define LIBASM_H
+#include "globals.h"
+#include "arena.h"
+#include "assembler.h"
+#include "server.h"
+
+/*
+ * The assembler as a library (libasm.a / libasm.so). The asm executable is a
+ * thin wrapper around it: assemble_files and the server work on files, while
+ * asm_assemble works on a source buffer and never touches the filesystem.
+ *
+ *     asmSession *session = asm_open();
+ *     asmResult result = {0};
+ *     asm_assemble(session, text, length, &options, &result);
+ *     ... result.image, result.entries, result.extern_uses, result.diagnostics ...
+ *     asm_free_result(&result);
+ *     asm_close(session);
+ *
+ * A session keeps its tables and memory warm between sources, so it should be
+ * reused for many calls. A session belongs to one thread at a time; use one
+ * session per thread to assemble in parallel. Passing the same result to the
+ * next call reuses its memory.
+ */
+
+typedef struct asmDiagnostic
+{
+    int line;            // Line of the source, 0 for problems not tied to a line
+    error code;          // The error code
+    int warning;         // TRUE for a warning, FALSE for an error
+    const char *message; // The message, as the asm executable prints it after the line number
+} asmDiagnostic;         // Definition of an error or warning of a source
+
+typedef struct asmSymbolRef
+{
+    const char *name; // Name of the symbol
+    int address;      // Address of an entry, or of a word that uses an external
+} asmSymbolRef;       // Definition of an entry or an external use site, as in the .ent and .ext files
+
+typedef struct asmResult
+{
+    int ok;                     // TRUE if the source assembled without errors
+    int code_words;             // Number of instruction words
+    int data_words;             // Number of data words
+    unsigned int origin;        // Address of the first word of the image
+    unsigned int *image;        // The instruction words followed by the data words, as in the .ob file
+    asmSymbolRef *entries;      // The entries, in .ent file order
+    int entry_count;            // Number of entries
+    asmSymbolRef *extern_uses;  // The external use sites, in .ext file order
+    int extern_use_count;       // Number of external use sites
+    asmDiagnostic *diagnostics; // The errors and warnings, in the order they were found
+    int diagnostic_count;       // Number of errors and warnings
+    arena memory;               // Holds everything the result points to
+} asmResult;                    // Definition of the outcome of assembling a source
+
+typedef struct AsmContext asmSession; // An assembler kept warm between sources
+
+asmSession *asm_open(void);              // Creates a session.
+void asm_close(asmSession *session);     // Frees a session and everything it holds.
+int asm_assemble(asmSession *session, const char *text, long length, asmOptions *options,
+                 asmResult *result);     // Assembles a source buffer into a result.
+void asm_free_result(asmResult *result); // Frees the memory of a result.
+
+#endif // LIBASM_H
@@ -0,0 +1,46 @@
+#ifndef LINESCANNER_H
+#define LINESCANNER_H
+#include "globals.h"
+
+#define SCAN_CHUNK 64                    // Characters classified at a time, one bit each
+#define MAX_LINE_TOKENS (LINESIZE + 2)   // Most tokens a line of the expanded source can hold
+#define SCAN_PADDING 32                  // Bytes the scanner may read past a line's terminator
+
+/* Characters a word token contains */
+#define TOKEN_COLON 1     // ':'
+#define TOKEN_HASH 2      // '#'
+#define TOKEN_BRACKET 4   // '[' or ']'
+#define TOKEN_QUOTE 8     // '"'
+#define TOKEN_SEMICOLON 16 // ';'
+
+typedef enum token_kind
+{
+    WORD_TOKEN, // Run of characters that are neither white space nor commas
+    COMMA_TOKEN // A single comma
+} token_kind;
+
+typedef struct lineToken
+{
+    char *start;     // First character of the token inside the line
+    int length;      // Number of characters in the token
+    token_kind kind; // Word or comma
+    int flags;       // TOKEN_* flags of the characters a word contains
+    int joined;      // TRUE if no white space separates the token from the previous one
+} lineToken;         // Definition of a token of a line
+
+typedef struct lineScan
+{
+    char *line;                           // The scanned line
+    int length;                           // Length of the line
+    int colon;                            // Offset of the line's first ':', -1 if there is none
+    int count;                            // Number of tokens
+    lineToken tokens[MAX_LINE_TOKENS];    // The tokens, in order
+} lineScan;                               // Definition of a classified line
+
+void scan_line(char *line, lineScan *scan);                            // Splits a line into tokens in one pass.
+int token_at(lineScan *scan, int offset);                              // Returns the first token starting at or after an offset.
+int word_span(lineScan *scan, int token, char **start, int *length);   // Finds the word starting at a token.
+int field_span(lineScan *scan, int token, char **start, int *length);  // Finds the white space delimited field starting at a token.
+const char *scanner_name();                                            // Returns the instruction set the scanner was built for.
+
+#endif // LINESCANNER_H
@@ -0,0 +1,54 @@
+#ifndef LINKER_H
+#define LINKER_H
+#include "globals.h"
+
+/*
+ * The linker (asmlink) joins modules assembled separately into one image.
+ * Every module is its .ob file, with an optional .ent file (the symbols it
+ * exports) and .ext file (the words that use external symbols). The code of
+ * all modules comes first, in the order given, followed by their data, so
+ * every relocatable word (ARE = RELOCATABLE) is moved to its module's new
+ * place and every external use site is patched with the address of the
+ * entry of that name.
+ */
+
+#define LINK_INITIAL_USES 256   // Initial number of external use sites allocated
+#define LINK_NO_MODULE (-1)     // Module of a name no module exports
+
+typedef struct linkModule
+{
+    char *name;      // The module's file name, without extension
+    long code_start; // Index of the module's first instruction word in the linked code
+    long code_words; // Number of instruction words of the module
+    long data_start; // Index of the module's first data word in the linked data
+    long data_words; // Number of data words of the module
+} linkModule;        // Definition of a module read by the linker
+
+typedef struct externUse
+{
+    long site;  // Index of the word in the linked code
+    int id;     // Id of the external's name in the name pool
+    int module; // The module the word belongs to
+} externUse;    // Definition of a word that uses an external symbol
+
+typedef struct linkEntry
+{
+    long address; // Address of the entry, in its module until the image is laid out
+    int module;   // The module exporting the name, or LINK_NO_MODULE
+} linkEntry;      // Definition of an exported symbol, indexed by the id of its name
+
+typedef struct linker
+{
+    linkModule *modules;  // The modules, in command-line order
+    int module_count;     // Number of modules
+    externUse *uses;      // The external use sites of all modules
+    long use_count;       // Number of use sites
+    long use_capacity;    // Number of use sites allocated
+    linkEntry *entries;   // The exported symbols, indexed by name id
+    int entry_capacity;   // Number of entries allocated
+    long code_words;      // Number of instruction words linked so far
+    long data_words;      // Number of data words linked so far
+    int errors;           // Number of errors reported
+} linker;                 // Definition of the linker's state; the words and names live in the context
+
+#endif // LINKER_H
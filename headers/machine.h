@@ -0,0 +1,94 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+#include <stdio.h>
+#include "globals.h"
+
+/*
+ * The emulator of the target machine (asmemu). An image is loaded from an .ob
+ * file once and its code is pre-decoded: every instruction becomes an emuOp
+ * whose operands are already resolved to a register or memory cell, or to a
+ * constant, so running an instruction never looks at its encoded words again.
+ * The registers and the memory are one array of cells, R0-R7 first, so a
+ * register and a memory operand are read the same way.
+ *
+ * The machine follows the course's definition: cmp sets the zero flag of the
+ * PSW from src - dst, and the arithmetic instructions (add, sub, not, clr,
+ * inc, dec) set it from their result; bne jumps when it is clear. red reads a
+ * character from the input tape (-1 at its end) and prn writes its operand
+ * as a character. jsr and rts use a return stack outside the memory.
+ */
+
+#define EMU_REGISTERS 8       // Number of registers, the first cells of a machine
+#define EMU_STACK_SIZE 1024   // Depth of the return stack
+#define EMU_OUTPUT_SIZE 4096  // Initial size of the output buffer of a machine
+#define EMU_WIDE_BITS 32      // Width of a word of a large-memory image
+#define EMU_OPERAND_CONST 0x1 // emuOp flag: the source operand is a constant, not a cell
+#define EMU_TARGET_CONST 0x2  // emuOp flag: the destination operand is a constant, not a cell
+#define EMU_WRITES_CODE 0x4   // emuOp flag: the destination is a cell of the code
+
+typedef enum emuStatus
+{
+    EMU_RUNNING,          // The machine can go on
+    EMU_HALTED,           // The program ran hlt
+    EMU_STEP_LIMIT,       // The program ran the most instructions allowed
+    EMU_BAD_INSTRUCTION,  // The word at the program counter is not an instruction
+    EMU_UNRESOLVED,       // An operand refers to an external that was never linked
+    EMU_BAD_ADDRESS,      // An operand is outside the memory
+    EMU_BAD_JUMP,         // A jump leaves the code
+    EMU_END_OF_CODE,      // The program ran past its last instruction
+    EMU_STACK_OVERFLOW,   // jsr with a full return stack
+    EMU_STACK_UNDERFLOW,  // rts with an empty return stack
+    EMU_OUT_OF_MEMORY     // Memory allocation failed
+} emuStatus;
+
+typedef struct emuOp
+{
+    unsigned char handler; // The opcode, or ERROR_OP for a word that cannot run
+    unsigned char flags;   // EMU_OPERAND_CONST, EMU_TARGET_CONST and EMU_WRITES_CODE
+    unsigned short length; // Number of words of the instruction
+    unsigned int src;      // Cell or constant of the source operand, the status of an ERROR_OP
+    unsigned int dst;      // Cell or constant of the destination operand
+} emuOp;                   // Definition of a pre-decoded instruction
+
+typedef struct emuImage
+{
+    unsigned int *words; // The memory as loaded, indexed by address
+    long memory_words;   // Number of words of memory
+    long code_words;     // Number of instruction words, from RESERVED_MEMORY on
+    long data_words;     // Number of data words, after the instructions
+    unsigned int mask;   // The bits of a word
+    int bits;            // Number of bits of a word
+    emuOp *ops;          // The decoded instruction at every code address, one more for the end of the code
+} emuImage;              // Definition of a program loaded into memory
+
+typedef struct emuMachine
+{
+    emuImage *image;          // The program
+    emuOp *ops;               // The decoded code the machine runs
+    unsigned int *cells;      // R0-R7, then the memory
+    unsigned int pc;          // Address of the next instruction
+    int zero;                 // The zero flag of the PSW
+    unsigned int stack[EMU_STACK_SIZE]; // Return addresses of jsr
+    int depth;                // Number of return addresses on the stack
+    const char *input;        // The input tape read by red
+    long input_length;        // Number of characters on the tape
+    long input_position;      // Next character read from the tape
+    char *output;             // Characters written by prn
+    long output_length;       // Number of characters written
+    long output_capacity;     // Bytes allocated for the output
+    int numbers;              // TRUE if prn writes numbers, one per line, instead of characters
+    long steps;               // Number of instructions run
+    emuStatus status;         // Why the machine stopped
+} emuMachine;                 // Definition of the state of a running program
+
+int load_image(emuImage *image, FILE *file);                     // Loads an .ob file and decodes its code.
+void free_image(emuImage *image);                                // Frees the memory of an image.
+void decode_code(emuImage *image, emuOp *ops, unsigned int *memory); // Decodes the instructions in memory.
+int init_machine(emuMachine *machine, emuImage *image);          // Prepares a machine to run an image from the start.
+void free_machine(emuMachine *machine);                          // Frees the memory of a machine.
+emuStatus run_machine(emuMachine *machine, long max_steps);      // Runs the program until it stops.
+emuOp *emu_rewrite_code(emuMachine *machine);                    // Decodes the code again after the program wrote into it.
+int emu_print(emuMachine *machine, unsigned int value);          // Writes the operand of prn to the machine's output.
+const char *emu_status_text(emuStatus status);                   // Describes why a machine stopped.
+
+#endif // MACHINE_H
@@ -0,0 +1,35 @@
+#ifndef NAMEPOOL_H
+#define NAMEPOOL_H
+
+#define NAME_POOL_INITIAL_SIZE 64 // Initial number of names allocated (a power of 2)
+#define NO_NAME (-1)              // Id returned for a name that is not in the pool
+
+typedef struct internedName
+{
+    char *text;        // The name, stored once in the file's arena
+    int length;        // Length of the name
+    unsigned int hash; // Hash value of the name
+} internedName;        // Definition of a name stored in the pool
+
+typedef struct namePool
+{
+    internedName *names;        // The names, indexed by their id
+    int count;                  // Number of names stored
+    int capacity;               // Number of names allocated
+    int *slots;                 // Open-addressing slots holding name ids, NO_NAME marks an empty slot
+    unsigned int slot_capacity; // Number of slots (always a power of 2, twice the capacity)
+    long bytes;                 // Bytes used by the stored names
+    long shared;                // Times an existing name was reused instead of copied
+    long shared_bytes;          // Bytes those copies would have used
+} namePool;                     // Definition of the pool of identifiers of a file
+
+unsigned int symbol_hash(char *name);                       // Computes the hash value of a name.
+int intern_name(namePool *pool, char *name);                // Returns the id of a name, adding it to the pool if needed.
+int find_name(namePool *pool, char *name);                  // Returns the id of a name, or NO_NAME if it is not in the pool.
+void reset_name_pool(namePool *pool);                       // Frees the memory held by the pool.
+void clear_name_pool(namePool *pool);                       // Empties the pool, keeping its memory.
+
+#define name_text(pool, id) ((pool)->names[(id)].text) // The text of an interned name
+#define name_hash(pool, id) ((pool)->names[(id)].hash) // The hash value of an interned name
+
+#endif // NAMEPOOL_H
@@ -0,0 +1,40 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+#include "globals.h"
+
+/*
+ * The peephole optimizer (-O). It runs after the labels are resolved, over the
+ * encoded instructions read back into one codeOp per command, and removes the
+ * commands a rule of the rule table matches. The remaining commands are moved
+ * down, and every label, .entry address, relocatable operand and external use
+ * site is moved with them; a label of a removed command moves to the command
+ * after it. The optimizer assumes programs do not read or write their own code.
+ */
+
+typedef struct codeOp
+{
+    int address;          // Position in the instructions array of the first word
+    int length;           // Number of words
+    opcode operation;     // The opcode
+    addressing_type src;  // Addressing type of the source operand, NONE_ADDR if there is none
+    addressing_type dst;  // Addressing type of the destination operand, NONE_ADDR if there is none
+    int removed;          // Flag indicating a rule removed the command
+} codeOp;                 // Definition of an encoded command, as the rules see it
+
+typedef struct codeProgram
+{
+    codeOp *ops;          // The commands, in address order
+    int count;            // Number of commands
+} codeProgram;            // Definition of the instructions image read back into commands
+
+typedef int (*peepholeMatch)(codeProgram *program, int index); // Tells if a rule removes a command
+
+typedef struct peepholeRule
+{
+    const char *name;      // Name of the rule
+    peepholeMatch matches; // Tells if the rule removes a command
+} peepholeRule;            // Definition of a rule of the peephole optimizer
+
+int optimize_code(void); // Removes the commands matched by the rules, returning the number of words removed.
+
+#endif // OPTIMIZER_H
@@ -1,7 +1,11 @@
 #include <stdio.h>
+#include "sourceBuffer.h"
+#include "inputFile.h"
 
-void preAssembler(FILE *file, FILE *fp);
+void preAssembler(FILE *file, sourceBuffer *src);
 
-int pre_process_line(char *line, FILE *fp, char *macro);
+void pre_assemble_input(inputFile *input, sourceBuffer *src);
+
+int pre_process_line(char *line, int line_length, sourceBuffer *src, char *macro);
 
 
@@ -1,8 +1,10 @@
 #include "utils.h"
+#include "statementTable.h"
 
-void second_pass(FILE *fp);
-int process_line_second_pass(char *line);
-int process_operation(opcode operation, char *args);
+void second_pass();
+void patch_fixups();
+int process_statement(statement *item);
+int encode_statement(statement *item);
 int encode_additional_words(char *src_operand, char *dst_operand, addressing_type src_type, addressing_type dst_type);
 unsigned int build_register_word(int is_dst, char *reg);
 int encode_label(char *symbol);
@@ -0,0 +1,19 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#define SEGMENT_CHUNK_BITS 12                          // Log 2 of the number of words in a chunk
+#define SEGMENT_CHUNK_WORDS (1 << SEGMENT_CHUNK_BITS) // Number of words in a chunk
+#define SEGMENT_INITIAL_CHUNKS 4                       // Initial number of chunk pointers allocated
+
+typedef struct wordSegment
+{
+    unsigned int **chunks; // The chunks holding the words, allocated when first written
+    int chunk_count;       // Number of chunks allocated
+    int chunk_capacity;    // Number of chunk pointers allocated
+} wordSegment;             // Definition of a growable memory segment (code or data image)
+
+int segment_store(wordSegment *seg, unsigned int index, unsigned int word); // Stores a word at an index, growing the segment.
+unsigned int segment_load(wordSegment *seg, unsigned int index);           // Returns the word at an index.
+void reset_segment(wordSegment *seg);                                      // Frees the memory held by a segment.
+
+#endif // SEGMENT_H
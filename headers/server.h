@@ -0,0 +1,39 @@
+#ifndef SERVER_H
+#define SERVER_H
+#include <stdio.h>
+#include "assembler.h"
+
+/*
+ * Server mode: a long-running assembler that takes jobs over a line protocol,
+ * so a build that assembles many files pays process startup and table setup
+ * once. Every worker keeps one context for all its jobs and recycles it between
+ * them, so the macro table, name pool and arena stay warm.
+ *
+ * Requests, one per line:
+ *   assemble [flags] name...       assembles name.as, the outputs go next to it
+ *   source [flags] name length     followed by exactly length bytes, assembled as name.as
+ *   ping                           answered with "pong"
+ *   quit                           closes the connection
+ * The flags are the command-line flags --emit-am, --one-pass, --stats,
+ * --large-memory, -O and --pool-strings, added to the ones the server was
+ * started with. Every word starting with '-' is taken as a flag, so names
+ * and lengths cannot start with one; an unknown flag refuses the request.
+ *
+ * Every file of a request is answered with:
+ *   file name
+ *   diag message                   one line per error or warning
+ *   output path                    one line per file written
+ *   status ok|failed
+ * and every request ends with "done". A malformed request is answered with
+ * "error reason" followed by "done". The bytes of a refused "source" request
+ * are read and dropped; if its last word is not a length, the connection is
+ * closed after the error, since the end of the source cannot be found.
+ */
+
+#define SERVER_BACKLOG 64             // Connections waiting to be accepted
+#define SERVER_MAX_SOURCE (1L << 30) // Largest source accepted by a "source" request, in bytes
+
+int serve_stream(FILE *in, FILE *out, asmOptions *defaults);         // Answers the requests read from a stream.
+int serve_socket(char *path, int threads, asmOptions *defaults);     // Answers the connections to a Unix domain socket.
+
+#endif // SERVER_H
@@ -0,0 +1,26 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+#include <stdio.h>
+
+#define SOURCE_INITIAL_TEXT 256 // Initial size of the text buffer
+#define SOURCE_INITIAL_LINES 16 // Initial size of the line offsets array
+
+typedef struct sourceBuffer
+{
+    char *text;        // Expanded source, every line stored null-terminated
+    long length;       // Number of bytes used in text
+    long capacity;     // Number of bytes allocated for text
+    long *lines;       // Offset of each line's start inside text
+    int line_count;    // Number of lines stored
+    int line_capacity; // Number of line offsets allocated
+    int allocations;   // Number of times memory was (re)allocated for this buffer
+} sourceBuffer;        // Definition of the in-memory expanded source
+
+void initSource(sourceBuffer *src);                         // Initializes an empty source buffer.
+void append_line(sourceBuffer *src, char *line, int length); // Appends a copy of a line to the source buffer.
+void append_source(sourceBuffer *src, sourceBuffer *other); // Appends all lines of another source buffer.
+char *get_line(sourceBuffer *src, int line_num);            // Returns the line at the given (0 based) position.
+int write_source(sourceBuffer *src, FILE *fp);              // Writes the whole source buffer to a file.
+void resetSource(sourceBuffer *src);                        // Frees the memory held by the source buffer.
+
+#endif // SOURCEBUFFER_H
@@ -0,0 +1,35 @@
+#ifndef STATEMENTTABLE_H
+#define STATEMENTTABLE_H
+#include "globals.h"
+
+#define STATEMENTS_INITIAL_SIZE 64 // Initial number of statements allocated
+
+typedef struct operandSpan
+{
+    char *start;          // First character of the operand inside the expanded source
+    int length;           // Number of characters in the operand
+    addressing_type type; // Addressing type of the operand
+} operandSpan;            // Definition of an operand's location in the source
+
+typedef struct statement
+{
+    int line_num;          // Line number in the expanded source, used for error messages
+    instruction directive; // ENTRY_IN for an .entry statement, NONE_IN for a command
+    opcode operation;      // Opcode of the command
+    int address;           // Position in the instructions array of the command's first additional word
+    operandSpan src;       // Source operand (type NONE_ADDR if there is none), or the .entry label
+    operandSpan dst;       // Destination operand (type NONE_ADDR if there is none)
+} statement;               // Definition of a statement the second pass still has to resolve
+
+typedef struct statementTable
+{
+    statement *items; // The recorded statements, in source order
+    int count;        // Number of statements recorded
+    int capacity;     // Number of statements allocated
+} statementTable;     // Definition of the list of statements produced by the first pass
+
+int add_statement(statementTable *table, statement *item); // Appends a copy of a statement to the table.
+void span_copy(operandSpan *span, char *buffer);            // Copies an operand's text into a null-terminated buffer.
+void reset_statements(statementTable *table);               // Resets the table by freeing its memory.
+
+#endif // STATEMENTTABLE_H
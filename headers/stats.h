@@ -0,0 +1,54 @@
+#ifndef STATS_H
+#define STATS_H
+#include <stdio.h>
+
+typedef enum phase
+{
+    PRE_ASSEMBLER_PHASE,
+    FIRST_PASS_PHASE,
+    SECOND_PASS_PHASE,
+    WRITE_FILES_PHASE,
+    PHASE_COUNT
+} phase; // Definition of the timed phases of assembling a file
+
+typedef struct phaseTime
+{
+    double wall; // Wall time spent in the phase, in seconds
+    double cpu;  // CPU time of the assembling thread spent in the phase, in seconds
+} phaseTime;     // Definition of the time spent in a phase
+
+typedef struct asmStats
+{
+    phaseTime phases[PHASE_COUNT]; // Time spent in each phase
+    phaseTime started;             // Clock readings when the current phase started
+    long peak_rss[PHASE_COUNT];    // Peak resident set size of the process at the end of each phase, in KB
+    long lines_read;               // Lines read from the source file
+    long macro_expansions;         // Macro calls expanded by the pre-assembler
+    long symbol_lookups;           // Symbol table lookups
+    long symbol_probes;            // Symbols compared by the symbol table lookups
+    long macros;                   // Macros stored in the macro table
+    long macro_buckets;            // Buckets of the macro table
+    long macro_max_chain;          // Length of the macro table's longest chain
+    double macro_avg_chain;        // Average length of the macro table's non-empty chains
+    long macro_lookups;            // Macro table lookups
+    long macro_filtered;           // Macro table lookups answered by the first-character bitmap or bloom filter
+    double macro_avg_probes;       // Average keys compared per macro table lookup
+    long words_emitted;            // Instruction and data words written to the object file
+    long words_optimized;          // Instruction words removed by the peephole optimizer (-O)
+    long strings_pooled;           // .string literals that shared the storage of another (--pool-strings)
+    long data_words_pooled;        // Data words those literals would have used
+    long names;                    // Distinct identifiers stored in the name pool
+    long name_bytes;               // Bytes used by the stored identifiers
+    long shared_names;             // Identifier uses that shared a stored copy instead of making one
+    long shared_name_bytes;        // Bytes those copies would have used
+    long allocations;              // Allocations made from the file's arena
+    long allocated_bytes;          // Bytes handed out by the file's arena
+    long system_allocations;       // Blocks the file's arena took from the system
+} asmStats;                        // Definition of the statistics of assembling a file
+
+void start_phase(asmStats *stats);                           // Starts timing a phase.
+void end_phase(asmStats *stats, phase p);                    // Adds the time since start_phase to a phase.
+void print_stats(FILE *fp, char *filename, asmStats *stats); // Prints the statistics of a file as a table.
+void write_stats(FILE *fp, char *filename, asmStats *stats); // Writes the statistics of a file as JSON.
+
+#endif // STATS_H
@@ -0,0 +1,38 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+#include "segment.h"
+
+#define STRING_POOL_INITIAL_SIZE 64 // Initial number of literals the pool holds
+
+/*
+ * The .string literals of a file in pooled mode (--pool-strings). The first pass
+ * records where every literal is stored in the data image; once all of them are
+ * read, merge_strings sorts them by their reversed text, null terminator
+ * included, so a literal comes right before the literals it is the end of.
+ * Every literal that equals or ends another one, before or after it in the
+ * source, is dropped and shares the end of the longer one, and the data image
+ * is compacted.
+ */
+
+typedef struct pooledString
+{
+    int address; // Position in the data image of the literal's first word
+    int length;  // Number of words, the null terminator included
+    int shared;  // Position of the words the literal shares, -1 if it keeps its own
+} pooledString;  // Definition of a literal stored in the data image
+
+typedef struct stringPool
+{
+    pooledString *items; // The literals, in data image order
+    int count;           // Number of literals recorded
+    int capacity;        // Number of literals allocated
+    int merged;          // Number of literals the last merge dropped
+    int merged_words;    // Number of data words they used
+} stringPool;            // Definition of the literals of the data image
+
+int add_string(stringPool *pool, int address, int length);                  // Records a literal stored in the data image.
+int merge_strings(stringPool *pool, wordSegment *seg, int size, int *moved); // Drops the literals that end others, compacting the image.
+void clear_string_pool(stringPool *pool);                                   // Empties the pool, keeping its memory.
+void reset_string_pool(stringPool *pool);                                   // Frees the memory held by the pool.
+
+#endif // STRINGPOOL_H
@@ -1,18 +1,35 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
 #include "globals.h"
 #include <stdio.h>
 
+#define SYMBOL_INDEX_INITIAL_SIZE 64 // Initial number of slots in the symbol hash index (power of 2)
+
 typedef struct Symbol
 {
-    char *name;          // Name of the symbol
+    char *name;          // Name of the symbol, shared with the file's name pool
+    int id;              // Id of the name in the file's name pool
+    unsigned int hash;   // Hash value of the name, cached for the hash index
     int value;           // Value associated with the symbol
     attribute attribute; // Attribute associated with the symbol
     struct Symbol *next; // Pointer to the next symbol in the linked list
 } Symbol;                // Definition of a symbol structure
 
-void addSymbol(Symbol **head, char *name, int value, attribute attr);     // Adds a new symbol entry to the symbol table.
+typedef struct symbolIndex
+{
+    Symbol **head;         // The symbol table this index belongs to
+    Symbol **slots;        // Open-addressing slots, NULL marks an empty slot
+    unsigned int capacity; // Number of slots (always a power of 2)
+    unsigned int count;    // Number of used slots
+    int failed;            // Set when the index could not grow, lookups then scan the list
+} symbolIndex;             // Definition of the hash index over a symbol table
+
+int addSymbol(Symbol **head, char *name, int value, attribute attr);      // Adds a new symbol entry to the symbol table.
 Symbol *findSymbol(Symbol **head, char *name);                            // Finds a symbol with the given name in the symbol table.
 int locateSymbol_by_attribute(Symbol **head, char *name, attribute attr); // Locates a symbol with the given name and attribute in the symbol table.
 int locateSymbol(Symbol **head, char *name);                              // Locates a symbol with the given name in the symbol table.
 int change_to_entry(Symbol **head, char *name);                           // Changes the attribute of a symbol with the given name to ENTRY.
 void offset_data(Symbol **head, int offset);                              // Offsets the value of symbols of type DATA in the symbol table by the specified offset.
 void resetSymbolTable(Symbol **head);                                     // Resets the symbol table by freeing memory occupied by all entries.
+
+#endif // SYMBOLTABLE_H
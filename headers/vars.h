@@ -1,17 +1,25 @@
-#include "symbolTable.h"
-#include "extTable.h"
-#include "hashTable.h"
+#ifndef VARS_H
+#define VARS_H
+#include "context.h"
 
-extern unsigned int data[];         // Declaration for an array of unsigned integers holding data
-extern unsigned int instructions[]; // Declaration for an array of unsigned integers holding instructions
-extern const char base4[4];         // Declaration for a constant character array of size 4 for base 4 representation
-int ic;                             // Instruction Counter
-int dc;                             // Data Counter
-int err;                            // Error flag
-int warn;                           // Warning flag
-int has_entry;                      // Flag indicating if an entry point exists
-int has_external;                   // Flag indicating if there are any external symbols
-int has_error;                      // Flag indicating if there were any errors during processing
-extern Symbol *symbols;             // Declaration for a pointer to the symbol table
-extern external *externals;         // Declaration for a pointer to the external symbols table
-extern hashTable *macroTable;       // Declaration for a pointer to the macro table
+extern const char base4[4]; // Declaration for a constant character array of size 4 for base 4 representation
+
+/* The assembler's state lives in the current thread's context */
+#define ic (context->ic)                     // Instruction Counter
+#define dc (context->dc)                     // Data Counter
+#define err (context->err)                   // Error flag
+#define warn (context->warn)                 // Warning flag
+#define has_entry (context->has_entry)       // Flag indicating if an entry point exists
+#define has_external (context->has_external) // Flag indicating if there are any external symbols
+#define has_error (context->has_error)       // Flag indicating if there were any errors during processing
+#define defer_labels (context->defer_labels) // Flag indicating label words are left in the fixup table (single-pass mode)
+#define data (context->data)                 // Segment holding the data image
+#define instructions (context->instructions) // Segment holding the instructions image
+#define symbols (context->symbols)           // Pointer to the symbol table
+#define symbol_index (context->symbol_index) // Hash index over the symbol table
+#define externals (context->externals)       // Pointer to the external symbols table
+#define macroTable (context->macroTable)     // Pointer to the macro table
+#define statements (context->statements)     // The statements recorded by the first pass
+#define fixups (context->fixups)             // The words left for patching in single-pass mode
+
+#endif // VARS_H
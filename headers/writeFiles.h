@@ -1,8 +1,17 @@
 #include <stdio.h>
 #include "globals.h"
 
+#define OB_BUFFER_SIZE 65536 // Size of the object file output buffer
+#define OB_LINE_MAX 28       // Longest object file line: a 10 digit address, a tab, 16 digits and a newline
+
 void write_output_ob(FILE *fp);
 
+char *encode_ob_line(char *out, unsigned int address, unsigned int word);
+
+char *encode_wide_ob_line(char *out, unsigned int address, unsigned int word);
+
+char *decode_ob_word(char *text, char *end, unsigned int *word);
+
 void write_output_entry(FILE *fp);
 
 void write_output_external(FILE *fp);
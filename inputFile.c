@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "globals.h"
+#include "inputFile.h"
+
+/**
+ * Reads the rest of a file into memory, for inputs that cannot be mapped such as pipes.
+ * @param input The input to fill.
+ * @param file The file.
+ * @return TRUE if the whole file was read, FALSE on a read or allocation error.
+ */
+static int read_input(inputFile *input, FILE *file)
+{
+    long capacity = 0;
+    size_t count;
+    char *text;
+
+    do
+    {
+        if (input->length + INPUT_READ_SIZE > capacity)
+        {
+            capacity = capacity ? capacity * 2 : INPUT_READ_SIZE;
+            text = (char *)realloc(input->text, capacity);
+            if (text == NULL)
+                return FALSE;
+            input->text = text;
+        }
+        count = fread(input->text + input->length, 1, INPUT_READ_SIZE, file);
+        input->length += (long)count;
+    } while (count == INPUT_READ_SIZE);
+
+    return !ferror(file);
+}
+
+/**
+ * Makes a whole file available in memory. Regular files are mapped, so their
+ * lines are read straight from the page cache; anything else is read in large
+ * blocks.
+ * @param input Receives the input.
+ * @param file The file, open for reading.
+ * @return TRUE on success, FALSE if the file could not be read.
+ */
+int open_input(inputFile *input, FILE *file)
+{
+    struct stat info;
+    void *map;
+
+    input->text = NULL;
+    input->length = 0;
+    input->position = 0;
+    input->mapped = FALSE;
+    input->borrowed = FALSE;
+
+    if (fstat(fileno(file), &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (map != MAP_FAILED)
+        {
+            posix_madvise(map, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+            input->text = (char *)map;
+            input->length = (long)info.st_size;
+            input->mapped = TRUE;
+            return TRUE;
+        }
+    }
+
+    if (!read_input(input, file))
+    {
+        close_input(input);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Uses text that is already in memory as the input, without copying it.
+ * The text must stay valid until the input is closed, and is not released by it.
+ * @param input Receives the input.
+ * @param text The text.
+ * @param length Number of bytes in the text.
+ */
+void open_buffer(inputFile *input, char *text, long length)
+{
+    input->text = text;
+    input->length = length;
+    input->position = 0;
+    input->mapped = FALSE;
+    input->borrowed = TRUE;
+}
+
+/**
+ * Returns the next line of the input as a view into it.
+ * @param input The input.
+ * @param line Receives the line.
+ * @return TRUE if there was a line, FALSE at the end of the input.
+ */
+int next_line(inputFile *input, lineView *line)
+{
+    long rest = input->length - input->position; // Bytes left in the input
+    char *end;
+
+    if (rest <= 0)
+        return FALSE;
+
+    line->start = input->text + input->position;
+    end = (char *)memchr(line->start, '\n', (size_t)rest);
+    line->length = end != NULL ? (int)(end - line->start) + 1 : (int)rest;
+    input->position += line->length;
+    return TRUE;
+}
+
+/**
+ * Releases the memory holding the input.
+ * @param input The input.
+ */
+void close_input(inputFile *input)
+{
+    if (input->mapped)
+        munmap(input->text, (size_t)input->length);
+    else if (!input->borrowed)
+        free(input->text);
+    input->text = NULL;
+    input->length = input->position = 0;
+    input->mapped = FALSE;
+    input->borrowed = FALSE;
+}
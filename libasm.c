@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libasm.h"
+#include "firstPass.h"
+#include "secondPass.h"
+#include "optimizer.h"
+#include "preAssembler.h"
+#include "vars.h"
+#include "utils.h"
+
+const char base4[4] = {'*', '#', '%', '!'};
+
+typedef struct diagnosticNode
+{
+    asmDiagnostic diagnostic;    // The recorded error or warning
+    struct diagnosticNode *next; // The one recorded before it
+} diagnosticNode;                // Definition of a diagnostic recorded while assembling
+
+typedef struct diagnosticList
+{
+    arena *memory;        // The result's memory, holding the nodes
+    diagnosticNode *last; // The last diagnostic recorded
+    int count;            // Number of diagnostics recorded
+} diagnosticList;         // Definition of the diagnostics of a source, in reverse order
+
+/**
+ * Runs the first pass and then the second pass (or the fixup patching in single-pass
+ * mode) over an expanded source, with the current thread's context, and then the
+ * peephole optimizer if it was asked for.
+ * @param source The expanded source.
+ * @param options The options.
+ * @return TRUE if both passes finished without errors, FALSE otherwise.
+ */
+int assemble_passes(sourceBuffer *source, asmOptions *options)
+{
+    // Perform first pass of assembly process, leaving label words as fixups in single-pass mode
+    defer_labels = options->one_pass;
+    start_phase(&context->stats);
+    first_pass(source);
+    end_phase(&context->stats, FIRST_PASS_PHASE);
+
+    // Check if there were no errors in first pass
+    if (!has_error)
+    {
+        // Patch the fixups, or perform second pass of assembly process over the recorded statements
+        start_phase(&context->stats);
+        if (options->one_pass)
+            patch_fixups();
+        else
+            second_pass();
+        if (!has_error && options->optimize)
+            context->stats.words_optimized += optimize_code();
+        end_phase(&context->stats, SECOND_PASS_PHASE);
+    }
+    return !has_error;
+}
+
+/**
+ * Records an error or warning of the source being assembled (a diagnosticHook).
+ * @param list_data The diagnosticList.
+ * @param code The error code.
+ * @param line_num The line of the source.
+ */
+static void record_diagnostic(void *list_data, error code, int line_num)
+{
+    diagnosticList *list = (diagnosticList *)list_data;
+    diagnosticNode *node = (diagnosticNode *)arena_alloc(list->memory, sizeof(diagnosticNode));
+
+    if (node == NULL)
+        return;
+    node->diagnostic.line = line_num;
+    node->diagnostic.code = code;
+    node->diagnostic.warning = code == WARNING_LINE_TOO_LONG || code == WARNING_EMPTY_LABEL;
+    node->diagnostic.message = error_text(code);
+    node->next = list->last;
+    list->last = node;
+    list->count++;
+}
+
+/**
+ * Copies a name into the result's memory, so it outlives the session's tables.
+ * @param memory The result's memory.
+ * @param name The name.
+ * @return The copy, or NULL if memory allocation failed.
+ */
+static const char *copy_name(arena *memory, char *name)
+{
+    size_t size = strlen(name) + 1;
+    char *copy = (char *)arena_alloc(memory, (long)size);
+
+    if (copy != NULL)
+        memcpy(copy, name, size);
+    return copy;
+}
+
+/**
+ * Copies the image, the entries and the externals of the assembled source into the result.
+ * @param result The result.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+static int collect_output(asmResult *result)
+{
+    arena *memory = &result->memory;
+    Symbol *symbol;
+    external *use;
+    int i, count;
+
+    result->code_words = ic;
+    result->data_words = dc;
+    result->origin = RESERVED_MEMORY;
+    result->image = (unsigned int *)arena_alloc(memory, ((long)ic + dc + 1) * sizeof(unsigned int));
+    if (result->image == NULL)
+        return FALSE;
+    for (i = 0; i < ic; i++)
+        result->image[i] = segment_load(&instructions, i);
+    for (i = 0; i < dc; i++)
+        result->image[ic + i] = segment_load(&data, i);
+
+    // The entries, in the order write_output_entry writes them
+    for (count = 0, symbol = symbols; symbol != NULL; symbol = symbol->next)
+        count += symbol->attribute == ENTRY;
+    result->entries = (asmSymbolRef *)arena_alloc(memory, (count + 1) * (long)sizeof(asmSymbolRef));
+    if (result->entries == NULL)
+        return FALSE;
+    for (symbol = symbols; symbol != NULL; symbol = symbol->next)
+    {
+        if (symbol->attribute != ENTRY)
+            continue;
+        result->entries[result->entry_count].name = copy_name(memory, symbol->name);
+        result->entries[result->entry_count++].address = symbol->value;
+    }
+
+    // The external use sites, in the order write_output_external writes them
+    for (count = 0, use = externals; use != NULL; use = use->next)
+        count++;
+    result->extern_uses = (asmSymbolRef *)arena_alloc(memory, (count + 1) * (long)sizeof(asmSymbolRef));
+    if (result->extern_uses == NULL)
+        return FALSE;
+    for (use = externals; use != NULL; use = use->next)
+    {
+        result->extern_uses[result->extern_use_count].name = copy_name(memory, use->name);
+        result->extern_uses[result->extern_use_count++].address = use->address;
+    }
+    return TRUE;
+}
+
+/**
+ * Creates a session, an assembler whose tables and memory are kept between sources.
+ * @return The session, or NULL if memory allocation failed.
+ */
+asmSession *asm_open(void)
+{
+    return create_context(NULL, NULL);
+}
+
+/**
+ * Frees a session and everything it holds. Results it produced stay valid.
+ * @param session The session.
+ */
+void asm_close(asmSession *session)
+{
+    if (session != NULL)
+        free_context(session);
+}
+
+/**
+ * Assembles a source buffer. Only the one_pass, large_memory, optimize and pool_strings options apply, since
+ * nothing is written to files. The source is read in place and is not modified.
+ * @param session The session to assemble with.
+ * @param text The source, as it would be in a .as file.
+ * @param length Number of bytes in the source.
+ * @param options The options.
+ * @param result Receives the outcome. It must be zeroed before its first use; its memory
+ *               from an earlier call is reused.
+ * @return TRUE if the source assembled without errors, FALSE otherwise.
+ */
+int asm_assemble(asmSession *session, const char *text, long length, asmOptions *options, asmResult *result)
+{
+    AsmContext *previous = context; // The caller may be assembling a file of its own
+    arena memory = result->memory;
+    diagnosticList list;
+    diagnosticNode *node;
+    inputFile input;
+    sourceBuffer source;
+    int i;
+
+    // Start from an empty result, keeping its memory
+    recycle_arena(&memory);
+    memset(result, 0, sizeof(asmResult));
+    result->memory = memory;
+    list.memory = &result->memory;
+    list.last = NULL;
+    list.count = 0;
+
+    context = session;
+    recycle_context(session, NULL, NULL);
+    session->on_diagnostic = record_diagnostic;
+    session->diagnostic_data = &list;
+    context->large_memory = options->large_memory;
+    context->pool_strings = options->pool_strings;
+
+    open_buffer(&input, (char *)text, length);
+    initSource(&source);
+    start_phase(&context->stats);
+    pre_assemble_input(&input, &source);
+    end_phase(&context->stats, PRE_ASSEMBLER_PHASE);
+    close_input(&input);
+
+    if (!has_error)
+        assemble_passes(&source, options);
+    result->ok = !has_error && collect_output(result);
+    resetSource(&source);
+
+    // The diagnostics were recorded newest first
+    result->diagnostics = (asmDiagnostic *)arena_alloc(&result->memory, (list.count + 1) * (long)sizeof(asmDiagnostic));
+    if (result->diagnostics != NULL)
+    {
+        result->diagnostic_count = list.count;
+        for (i = list.count - 1, node = list.last; node != NULL; i--, node = node->next)
+            result->diagnostics[i] = node->diagnostic;
+    }
+
+    session->on_diagnostic = NULL;
+    session->diagnostic_data = NULL;
+    context = previous;
+    return result->ok;
+}
+
+/**
+ * Frees the memory of a result. The result can be used again afterwards.
+ * @param result The result.
+ */
+void asm_free_result(asmResult *result)
+{
+    reset_arena(&result->memory);
+    memset(result, 0, sizeof(asmResult));
+}
@@ -0,0 +1,347 @@
+#include <string.h>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "lineScanner.h"
+
+/*
+ * Line scanner.
+ * Every chunk of a line is classified at once into bit masks, one bit per
+ * character for white space, commas and the characters the parsers look for,
+ * with AVX2 or SSE2 when the compiler targets them and a byte loop otherwise.
+ * Token boundaries are then read off the masks a bit at a time, so the parsers
+ * get the tokens without going over the line character by character.
+ */
+
+typedef struct charMasks
+{
+    uint64_t space;   // White space, as isspace() in the C locale
+    uint64_t comma;   // ','
+    uint64_t colon;   // ':'
+    uint64_t special; // ':', '#', '[', ']', '"' and ';'
+} charMasks;          // Definition of the classes of the characters of a chunk, bit i for character i
+
+#if defined(__GNUC__)
+#define lowest_bit(mask) __builtin_ctzll(mask) // Position of the lowest set bit
+#else
+static int lowest_bit(uint64_t mask)
+{
+    int i = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+}
+#endif
+
+#if defined(__AVX2__)
+#define SCAN_WIDTH 32 // Characters classified by one vector
+typedef __m256i scanVector;
+#define load_vector(p) _mm256_loadu_si256((const __m256i *)(p))
+#define splat(c) _mm256_set1_epi8(c)
+#define equal(a, b) _mm256_cmpeq_epi8(a, b)
+#define either(a, b) _mm256_or_si256(a, b)
+#define subtract(a, b) _mm256_sub_epi8(a, b)
+#define unsigned_min(a, b) _mm256_min_epu8(a, b)
+#define bits(v) ((uint64_t)(uint32_t)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#define SCAN_WIDTH 16 // Characters classified by one vector
+typedef __m128i scanVector;
+#define load_vector(p) _mm_loadu_si128((const __m128i *)(p))
+#define splat(c) _mm_set1_epi8(c)
+#define equal(a, b) _mm_cmpeq_epi8(a, b)
+#define either(a, b) _mm_or_si128(a, b)
+#define subtract(a, b) _mm_sub_epi8(a, b)
+#define unsigned_min(a, b) _mm_min_epu8(a, b)
+#define bits(v) ((uint64_t)(uint16_t)_mm_movemask_epi8(v))
+#endif
+
+/**
+ * Returns a mask of the positions from one position up to (not including) another.
+ */
+static uint64_t range_mask(int from, int to)
+{
+    return (to == SCAN_CHUNK ? ~(uint64_t)0 : ((uint64_t)1 << to) - 1) & ~(((uint64_t)1 << from) - 1);
+}
+
+/**
+ * Classifies the characters of a chunk. The vector code reads whole vectors,
+ * up to SCAN_PADDING - 1 characters past the end of the chunk.
+ * @param chunk The chunk.
+ * @param length Number of characters in the chunk, at most SCAN_CHUNK.
+ * @param masks Receives the class masks, with no bits set past the chunk.
+ */
+static void classify_chunk(const char *chunk, int length, charMasks *masks)
+{
+#if defined(SCAN_WIDTH)
+    scanVector v, control, colon;
+    uint64_t valid = range_mask(0, length); // The positions inside the chunk
+    int i;
+
+    masks->space = masks->comma = masks->colon = masks->special = 0;
+    for (i = 0; i < length; i += SCAN_WIDTH)
+    {
+        v = load_vector(chunk + i);
+
+        // '\t' to '\r' are the characters c with (c - '\t') <= 4 as unsigned bytes
+        control = subtract(v, splat('\t'));
+        control = equal(unsigned_min(control, splat(4)), control);
+        masks->space |= bits(either(equal(v, splat(' ')), control)) << i;
+        masks->comma |= bits(equal(v, splat(','))) << i;
+        colon = equal(v, splat(':'));
+        masks->colon |= bits(colon) << i;
+        masks->special |= bits(either(either(either(colon, equal(v, splat('#'))), either(equal(v, splat('[')), equal(v, splat(']')))),
+                                      either(equal(v, splat('"')), equal(v, splat(';')))))
+                          << i;
+    }
+    masks->space &= valid;
+    masks->comma &= valid;
+    masks->colon &= valid;
+    masks->special &= valid;
+#else
+    uint64_t bit;
+    int i;
+
+    masks->space = masks->comma = masks->colon = masks->special = 0;
+    for (i = 0; i < length; i++)
+    {
+        bit = (uint64_t)1 << i;
+        switch (chunk[i])
+        {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\v':
+        case '\f':
+        case '\r':
+            masks->space |= bit;
+            break;
+        case ',':
+            masks->comma |= bit;
+            break;
+        case ':':
+            masks->colon |= bit;
+            masks->special |= bit;
+            break;
+        case '#':
+        case '[':
+        case ']':
+        case '"':
+        case ';':
+            masks->special |= bit;
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * Returns the TOKEN_* flags of a word. Only called for the few words the
+ * masks show to hold one of the characters.
+ */
+static int word_flags(char *word, int length)
+{
+    int flags = 0, i;
+
+    for (i = 0; i < length; i++)
+    {
+        switch (word[i])
+        {
+        case ':':
+            flags |= TOKEN_COLON;
+            break;
+        case '#':
+            flags |= TOKEN_HASH;
+            break;
+        case '[':
+        case ']':
+            flags |= TOKEN_BRACKET;
+            break;
+        case '"':
+            flags |= TOKEN_QUOTE;
+            break;
+        case ';':
+            flags |= TOKEN_SEMICOLON;
+            break;
+        }
+    }
+    return flags;
+}
+
+/**
+ * Adds a token to the scan. Lines of the expanded source never hold more than
+ * MAX_LINE_TOKENS tokens; the tokens of longer lines past that are dropped.
+ */
+static void add_token(lineScan *scan, int start, int length, token_kind kind, int flags, int joined)
+{
+    lineToken *token;
+
+    if (scan->count == MAX_LINE_TOKENS)
+        return;
+    token = &scan->tokens[scan->count++];
+
+    token->start = scan->line + start;
+    token->length = length;
+    token->kind = kind;
+    token->flags = flags;
+    token->joined = joined;
+}
+
+/**
+ * Splits a line into word and comma tokens in one pass over the line. A word
+ * also ends after the line's first ':', so a label definition is a token of its
+ * own even when no white space follows it.
+ * @param line The line, null-terminated and followed by SCAN_PADDING readable bytes.
+ * @param scan Receives the tokens.
+ */
+void scan_line(char *line, lineScan *scan)
+{
+    charMasks masks;          // Classes of the chunk's characters
+    uint64_t separator;       // Characters that end a word
+    uint64_t previous;        // Bit i set if character i - 1 ends a word
+    uint64_t cut = 0;         // The character after the first colon, where a word is cut
+    uint64_t starts, ends;    // Characters that start a word, and characters where one ends
+    uint64_t events, bit;
+    int offset, pos, rest;
+    int open = -1;              // Start of the word being read, -1 between words
+    int open_special = FALSE;   // Whether the part of that word in earlier chunks holds a special character
+    int open_joined = FALSE;    // Whether that word follows a token without white space
+    int after_separator = TRUE; // The character before the chunk ends a word (the line start does)
+    int after_space = TRUE;     // The character before the chunk is white space (the line start counts)
+
+    scan->line = line;
+    scan->length = (int)strlen(line);
+    scan->colon = -1;
+    scan->count = 0;
+
+    for (offset = 0; offset < scan->length; offset += SCAN_CHUNK)
+    {
+        rest = scan->length - offset;
+        classify_chunk(line + offset, rest < SCAN_CHUNK ? rest : SCAN_CHUNK, &masks);
+
+        separator = masks.space | masks.comma;
+        if (rest < SCAN_CHUNK)
+            separator |= ~range_mask(0, rest); // Past the end of the line
+        if (scan->colon < 0 && masks.colon)
+        {
+            pos = lowest_bit(masks.colon);
+            scan->colon = offset + pos;
+            cut |= pos + 1 < SCAN_CHUNK ? (uint64_t)1 << (pos + 1) : 0;
+        }
+        previous = (separator << 1) | (uint64_t)after_separator;
+        starts = ~separator & (previous | cut);
+        ends = (separator & ~previous) | (cut & ~separator);
+        cut = scan->colon == offset + SCAN_CHUNK - 1; // A colon ending the chunk cuts the next one's first word
+
+        events = starts | ends | masks.comma;
+        while (events)
+        {
+            pos = lowest_bit(events);
+            bit = (uint64_t)1 << pos;
+            events &= events - 1;
+
+            if ((bit & ends) && open >= 0)
+            {
+                open_special |= (masks.special & range_mask(open > offset ? open - offset : 0, pos)) != 0;
+                add_token(scan, open, offset + pos - open, WORD_TOKEN,
+                          open_special ? word_flags(line + open, offset + pos - open) : 0, open_joined);
+                open = -1;
+            }
+            if (bit & starts)
+            {
+                open = offset + pos;
+                open_special = FALSE;
+                open_joined = pos ? !((masks.space >> (pos - 1)) & 1) : !after_space;
+            }
+            if (bit & masks.comma)
+                add_token(scan, offset + pos, 1, COMMA_TOKEN, 0, pos ? !((masks.space >> (pos - 1)) & 1) : !after_space);
+        }
+        if (open >= 0)
+            open_special |= (masks.special & range_mask(open > offset ? open - offset : 0, SCAN_CHUNK)) != 0;
+
+        after_separator = (int)(separator >> (SCAN_CHUNK - 1));
+        after_space = (int)(masks.space >> (SCAN_CHUNK - 1));
+    }
+
+    // A word that runs to the end of a line filling its last chunk
+    if (open >= 0)
+        add_token(scan, open, scan->length - open, WORD_TOKEN, open_special ? word_flags(line + open, scan->length - open) : 0, open_joined);
+}
+
+/**
+ * Returns the first token that starts at or after an offset of the line.
+ * @param scan The scanned line.
+ * @param offset The offset.
+ * @return The token's index, or the number of tokens if there is none.
+ */
+int token_at(lineScan *scan, int offset)
+{
+    int i;
+
+    for (i = 0; i < scan->count && scan->tokens[i].start < scan->line + offset; i++)
+        ;
+    return i;
+}
+
+/**
+ * Finds the word starting at a token: the token and the word tokens joined to
+ * it, which is the run of characters up to the next white space or comma.
+ * @param scan The scanned line.
+ * @param token Index of the first token.
+ * @param start Receives the start of the word (the end of the line if there are no tokens left).
+ * @param length Receives the length of the word, 0 if the token is a comma or there are no tokens left.
+ * @return The index of the token after the word.
+ */
+int word_span(lineScan *scan, int token, char **start, int *length)
+{
+    *start = token < scan->count ? scan->tokens[token].start : scan->line + scan->length;
+    *length = 0;
+    if (token == scan->count || scan->tokens[token].kind != WORD_TOKEN)
+        return token;
+    do
+        token++;
+    while (token < scan->count && scan->tokens[token].joined && scan->tokens[token].kind == WORD_TOKEN);
+    *length = (int)(scan->tokens[token - 1].start + scan->tokens[token - 1].length - *start);
+    return token;
+}
+
+/**
+ * Finds the field starting at a token: the token and all the tokens joined to
+ * it, which is the run of characters up to the next white space.
+ * @param scan The scanned line.
+ * @param token Index of the first token.
+ * @param start Receives the start of the field (the end of the line if there are no tokens left).
+ * @param length Receives the length of the field, 0 if there are no tokens left.
+ * @return The index of the token after the field.
+ */
+int field_span(lineScan *scan, int token, char **start, int *length)
+{
+    *start = token < scan->count ? scan->tokens[token].start : scan->line + scan->length;
+    *length = 0;
+    if (token == scan->count)
+        return token;
+    do
+        token++;
+    while (token < scan->count && scan->tokens[token].joined);
+    *length = (int)(scan->tokens[token - 1].start + scan->tokens[token - 1].length - *start);
+    return token;
+}
+
+/**
+ * Returns the instruction set the scanner was built for.
+ */
+const char *scanner_name()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,495 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "context.h"
+#include "utils.h"
+#include "writeFiles.h"
+#include "inputFile.h"
+#include "linker.h"
+
+/*
+ * asmlink: links modules written by asm into one image.
+ * Usage: asmlink [-o name] [--large-memory] module...
+ * Reads module.ob, module.ent and module.ext for every module (the last two
+ * are optional) and writes name.ob, linked.ob by default.
+ */
+
+/**
+ * Reports an error of a module.
+ * @param link The linker.
+ * @param module The module's file name.
+ * @param message The error message.
+ * @param detail A name or number the message is about, or NULL.
+ */
+static void link_error(linker *link, char *module, char *message, char *detail)
+{
+    if (detail != NULL)
+        fprintf(context->diag, "%s: Error: %s %s.\n", module, message, detail);
+    else
+        fprintf(context->diag, "%s: Error: %s.\n", module, message);
+    link->errors++;
+}
+
+/**
+ * Reads a decimal number from a line.
+ * @param p The position in the line, moved past the number and the blanks after it.
+ * @param end The end of the line.
+ * @param value Receives the number.
+ * @return TRUE if there was a number, FALSE otherwise.
+ */
+static int read_number(char **p, char *end, long *value)
+{
+    char *s = *p;
+    long n = 0;
+
+    if (s == end || *s < '0' || *s > '9')
+        return FALSE;
+    while (s < end && *s >= '0' && *s <= '9')
+        n = n * 10 + (*s++ - '0');
+    while (s < end && (*s == ' ' || *s == '\t'))
+        s++;
+    *p = s;
+    *value = n;
+    return TRUE;
+}
+
+/**
+ * Reads a symbol name from a line into a buffer.
+ * @param p The position in the line, moved past the name and the blanks after it.
+ * @param end The end of the line.
+ * @param name Receives the name, SYMBOL_MAX_SIZE + 1 characters long.
+ * @return TRUE if there was a name that fits, FALSE otherwise.
+ */
+static int read_name(char **p, char *end, char *name)
+{
+    char *s = *p;
+    int length = 0;
+
+    while (s < end && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n')
+    {
+        if (length == SYMBOL_MAX_SIZE)
+            return FALSE;
+        name[length++] = *s++;
+    }
+    name[length] = '\0';
+    while (s < end && (*s == ' ' || *s == '\t'))
+        s++;
+    *p = s;
+    return length > 0;
+}
+
+/**
+ * Returns the end of a line without its newline.
+ */
+static char *line_end(lineView *line)
+{
+    char *end = line->start + line->length;
+
+    while (end > line->start && (end[-1] == '\n' || end[-1] == '\r'))
+        end--;
+    return end;
+}
+
+/**
+ * Reads one of a module's files. Module files are small and there are many of them,
+ * so they are read into one buffer kept for all of them instead of being mapped.
+ * @param input Receives the file's contents, valid until the next file is read.
+ * @param module The module's file name.
+ * @param type The kind of file.
+ * @return TRUE if the file was read, FALSE if it does not exist or cannot be read.
+ */
+static int open_module_file(inputFile *input, char *module, FILE_TYPE type)
+{
+    static char *text = NULL;  // The buffer shared by all module files
+    static long capacity = 0;  // Bytes allocated for the buffer
+    int fd = open(create_file_name(module, type), O_RDONLY);
+    struct stat info;
+    long length = 0;
+    ssize_t count = 0;
+    char *grown;
+
+    if (fd < 0)
+        return FALSE;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return FALSE;
+    }
+    if (info.st_size + 1 > capacity)
+    {
+        grown = (char *)realloc(text, info.st_size + INPUT_READ_SIZE);
+        if (grown == NULL)
+        {
+            close(fd);
+            return FALSE;
+        }
+        text = grown;
+        capacity = info.st_size + INPUT_READ_SIZE;
+    }
+    while (length < info.st_size && (count = read(fd, text + length, info.st_size - length)) > 0)
+        length += count;
+    close(fd);
+    if (count < 0)
+        return FALSE;
+    open_buffer(input, text, length);
+    return TRUE;
+}
+
+/**
+ * Reads a module's object file, appending its instruction and data words to the linked ones.
+ * @param link The linker.
+ * @param module The module.
+ * @return TRUE if the object file was read, FALSE otherwise.
+ */
+static int read_object(linker *link, linkModule *module)
+{
+    inputFile input;
+    lineView line;
+    char *p, *end;
+    long code_words, data_words, address, count = 0;
+    unsigned int word;
+    int ok = TRUE;
+
+    if (!open_module_file(&input, module->name, OB_FILE))
+    {
+        link_error(link, module->name, "Cannot read object file", NULL);
+        return FALSE;
+    }
+
+    // The first line holds the number of instruction and data words
+    if (next_line(&input, &line))
+    {
+        p = line.start;
+        end = line_end(&line);
+    }
+    else
+        p = end = NULL;
+    if (p == NULL || !read_number(&p, end, &code_words) || !read_number(&p, end, &data_words) || p != end)
+    {
+        link_error(link, module->name, "Invalid object file header", NULL);
+        close_input(&input);
+        return FALSE;
+    }
+    module->code_start = link->code_words;
+    module->code_words = code_words;
+    module->data_start = link->data_words;
+    module->data_words = data_words;
+
+    // Every other line is an address and a word in base-4
+    while (ok && next_line(&input, &line))
+    {
+        p = line.start;
+        end = line_end(&line);
+        if (p == end)
+            continue;
+        if (!read_number(&p, end, &address) || p == end || count == code_words + data_words)
+        {
+            ok = FALSE;
+            break;
+        }
+        if (decode_ob_word(p, end, &word) != end)
+            ok = FALSE;
+        else if (count < code_words)
+            ok = segment_store(&context->instructions, (unsigned int)(module->code_start + count), word);
+        else
+            ok = segment_store(&context->data, (unsigned int)(module->data_start + count - code_words), word);
+        count++;
+    }
+    close_input(&input);
+
+    if (!ok || count != code_words + data_words)
+    {
+        link_error(link, module->name, "Invalid object file", NULL);
+        return FALSE;
+    }
+    link->code_words += code_words;
+    link->data_words += data_words;
+    return TRUE;
+}
+
+/**
+ * Returns the entry of a name id, making room for it.
+ * @param link The linker.
+ * @param id The id of the name.
+ * @return The entry, or NULL if memory allocation failed.
+ */
+static linkEntry *entry_of(linker *link, int id)
+{
+    int capacity = link->entry_capacity;
+    linkEntry *entries;
+
+    if (id >= capacity)
+    {
+        while (id >= capacity)
+            capacity = capacity ? capacity * 2 : NAME_POOL_INITIAL_SIZE;
+        entries = (linkEntry *)realloc(link->entries, capacity * sizeof(linkEntry));
+        if (entries == NULL)
+            return NULL;
+        for (; link->entry_capacity < capacity; link->entry_capacity++)
+            entries[link->entry_capacity].module = LINK_NO_MODULE;
+        link->entries = entries;
+    }
+    return &link->entries[id];
+}
+
+/**
+ * Reads a module's entry file into the global symbol table.
+ * @param link The linker.
+ * @param index The index of the module.
+ */
+static void read_entries(linker *link, int index)
+{
+    linkModule *module = &link->modules[index];
+    inputFile input;
+    lineView line;
+    char name[SYMBOL_MAX_SIZE + 1];
+    char *p, *end;
+    long address;
+    linkEntry *entry;
+    int id;
+
+    if (!open_module_file(&input, module->name, ENT_FILE))
+        return; // A module without entries exports nothing
+
+    while (next_line(&input, &line))
+    {
+        p = line.start;
+        end = line_end(&line);
+        if (p == end)
+            continue;
+        if (!read_name(&p, end, name) || !read_number(&p, end, &address) || p != end)
+        {
+            link_error(link, module->name, "Invalid entry file", NULL);
+            break;
+        }
+        id = intern_name(&context->names, name);
+        entry = id == NO_NAME ? NULL : entry_of(link, id);
+        if (entry == NULL)
+        {
+            link_error(link, module->name, "Memory allocation failed", NULL);
+            break;
+        }
+        if (entry->module != LINK_NO_MODULE)
+        {
+            link_error(link, module->name, "Entry is already defined by", link->modules[entry->module].name);
+            continue;
+        }
+        entry->module = index;
+        entry->address = address;
+    }
+    close_input(&input);
+}
+
+/**
+ * Reads a module's external file, recording the words to patch.
+ * @param link The linker.
+ * @param index The index of the module.
+ */
+static void read_externals(linker *link, int index)
+{
+    linkModule *module = &link->modules[index];
+    inputFile input;
+    lineView line;
+    char name[SYMBOL_MAX_SIZE + 1];
+    char *p, *end;
+    long site;
+    externUse *uses;
+
+    if (!open_module_file(&input, module->name, EXT_FILE))
+        return; // A module without externals uses nothing
+
+    while (next_line(&input, &line))
+    {
+        p = line.start;
+        end = line_end(&line);
+        if (p == end)
+            continue;
+
+        // The address of a use site is the index of the word in the module's code
+        if (!read_name(&p, end, name) || !read_number(&p, end, &site) || p != end || site >= module->code_words ||
+            (segment_load(&context->instructions, (unsigned int)(module->code_start + site)) & 3) != EXTERN)
+        {
+            link_error(link, module->name, "Invalid external file", NULL);
+            break;
+        }
+
+        if (link->use_count == link->use_capacity)
+        {
+            link->use_capacity = link->use_capacity ? link->use_capacity * 2 : LINK_INITIAL_USES;
+            uses = (externUse *)realloc(link->uses, link->use_capacity * sizeof(externUse));
+            if (uses == NULL)
+            {
+                link_error(link, module->name, "Memory allocation failed", NULL);
+                break;
+            }
+            link->uses = uses;
+        }
+        link->uses[link->use_count].site = module->code_start + site;
+        link->uses[link->use_count].id = intern_name(&context->names, name);
+        link->uses[link->use_count++].module = index;
+    }
+    close_input(&input);
+}
+
+/**
+ * Moves an address of a module to its place in the linked image.
+ * @param link The linker.
+ * @param module The module.
+ * @param address The address in the module, where its code starts at RESERVED_MEMORY and its data follows.
+ * @return The address in the linked image.
+ */
+static long relocate(linker *link, linkModule *module, long address)
+{
+    long offset = address - RESERVED_MEMORY;
+
+    if (offset < module->code_words)
+        return RESERVED_MEMORY + module->code_start + offset;
+    return RESERVED_MEMORY + link->code_words + module->data_start + offset - module->code_words;
+}
+
+/**
+ * Lays out the image: relocates the words and entries of every module, then patches
+ * the external use sites with the addresses of their entries.
+ * @param link The linker.
+ */
+static void resolve(linker *link)
+{
+    linkModule *module;
+    linkEntry *entry;
+    externUse *use;
+    unsigned int word;
+    long i, site;
+    int m, id;
+
+    for (m = 0; m < link->module_count; m++)
+    {
+        module = &link->modules[m];
+        for (site = module->code_start; site < module->code_start + module->code_words; site++)
+        {
+            word = segment_load(&context->instructions, (unsigned int)site);
+            if ((word & 3) == RELOCATABLE)
+                segment_store(&context->instructions, (unsigned int)site,
+                              insert_are((unsigned int)relocate(link, module, (long)(word >> BITS_IN_ARE)), RELOCATABLE));
+        }
+    }
+
+    for (id = 0; id < link->entry_capacity; id++)
+    {
+        entry = &link->entries[id];
+        if (entry->module != LINK_NO_MODULE)
+            entry->address = relocate(link, &link->modules[entry->module], entry->address);
+    }
+
+    for (i = 0; i < link->use_count; i++)
+    {
+        use = &link->uses[i];
+        if (use->id == NO_NAME || use->id >= link->entry_capacity || link->entries[use->id].module == LINK_NO_MODULE)
+        {
+            link_error(link, link->modules[use->module].name, "Undefined external",
+                       use->id == NO_NAME ? "" : name_text(&context->names, use->id));
+            continue;
+        }
+        segment_store(&context->instructions, (unsigned int)use->site,
+                      insert_are((unsigned int)link->entries[use->id].address, RELOCATABLE));
+    }
+}
+
+/**
+ * Writes the linked image as an object file.
+ * @param link The linker.
+ * @param name The output name, without extension.
+ * @return TRUE if the file was written, FALSE otherwise.
+ */
+static int write_image(linker *link, char *name)
+{
+    char *(*encode)(char *, unsigned int, unsigned int) = context->large_memory ? encode_wide_ob_line : encode_ob_line;
+    static char buffer[OB_BUFFER_SIZE]; // Output buffer
+    char *end = buffer;
+    FILE *file = fopen(create_file_name(name, OB_FILE), "w");
+    unsigned int address = RESERVED_MEMORY;
+    long i;
+
+    if (file == NULL)
+        return FALSE;
+    fprintf(file, "%ld\t%ld\n", link->code_words, link->data_words);
+    for (i = 0; i < link->code_words + link->data_words; i++, address++)
+    {
+        if (end - buffer > OB_BUFFER_SIZE - OB_LINE_MAX)
+        {
+            fwrite(buffer, 1, end - buffer, file);
+            end = buffer;
+        }
+        if (i < link->code_words)
+            end = encode(end, address, segment_load(&context->instructions, (unsigned int)i));
+        else
+            end = encode(end, address, segment_load(&context->data, (unsigned int)(i - link->code_words)));
+    }
+    fwrite(buffer, 1, end - buffer, file);
+    return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    linker link;
+    char *output = "linked"; // Name of the linked object file, without extension
+    int i, m;
+
+    memset(&link, 0, sizeof(linker));
+
+    context = create_context(stdout, stderr);
+    link.modules = (linkModule *)malloc(argc * sizeof(linkModule));
+    if (context == NULL || link.modules == NULL)
+    {
+        fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (strcmp(argv[i], "--large-memory") == 0)
+            context->large_memory = TRUE;
+        else if (argv[i][0] != '-')
+            link.modules[link.module_count++].name = argv[i];
+        else
+            break; // An unknown option, or an option without its value
+    }
+    if (i < argc || link.module_count == 0)
+    {
+        if (i < argc)
+            fprintf(stderr, "%s: unknown option or missing value: %s\n", argv[0], argv[i]);
+        fprintf(stderr, "usage: %s [-o name] [--large-memory] module...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Read every module, then lay out the image once all sizes are known
+    for (m = 0; m < link.module_count; m++)
+    {
+        if (read_object(&link, &link.modules[m]))
+        {
+            read_entries(&link, m);
+            read_externals(&link, m);
+        }
+    }
+    if (RESERVED_MEMORY + link.code_words + link.data_words > memory_size())
+        link_error(&link, output, "Linked image is larger than the memory", NULL);
+    if (link.errors == 0)
+        resolve(&link);
+
+    if (link.errors == 0 && !write_image(&link, output))
+        link_error(&link, output, "Cannot write object file", NULL);
+    if (link.errors == 0)
+        printf("linked %d modules: %ld instruction words, %ld data words, %ld external uses\n", link.module_count,
+               link.code_words, link.data_words, link.use_count);
+
+    free(link.modules);
+    free(link.uses);
+    free(link.entries);
+    free_context(context);
+    return link.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
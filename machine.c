@@ -0,0 +1,642 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine.h"
+#include "inputFile.h"
+#include "writeFiles.h"
+
+/* GCC and Clang dispatch through a table of label addresses, marked __extension__ for -pedantic;
+   other compilers through a switch */
+#if defined(__GNUC__)
+#define EMU_THREADED
+#endif
+
+/**
+ * Reads a decimal number from a line.
+ * @param p The position in the line, moved past the number and the blanks after it.
+ * @param end The end of the line.
+ * @param value Receives the number.
+ * @return TRUE if there was a number, FALSE otherwise.
+ */
+static int read_number(char **p, char *end, long *value)
+{
+    char *s = *p;
+    long n = 0;
+
+    if (s == end || *s < '0' || *s > '9')
+        return FALSE;
+    while (s < end && *s >= '0' && *s <= '9')
+        n = n * 10 + (*s++ - '0');
+    while (s < end && (*s == ' ' || *s == '\t'))
+        s++;
+    *p = s;
+    *value = n;
+    return TRUE;
+}
+
+/**
+ * Returns the end of a line without its newline.
+ */
+static char *line_end(lineView *line)
+{
+    char *end = line->start + line->length;
+
+    while (end > line->start && (end[-1] == '\n' || end[-1] == '\r'))
+        end--;
+    return end;
+}
+
+/**
+ * Sign-extends the value of an operand word, the bits above its ARE bits.
+ * @param image The image.
+ * @param word The operand word.
+ * @return The value, as a word of the machine.
+ */
+static unsigned int operand_value(emuImage *image, unsigned int word)
+{
+    unsigned int value = (word & image->mask) >> BITS_IN_ARE;
+    unsigned int sign = 1u << (image->bits - BITS_IN_ARE - 1);
+
+    return ((value ^ sign) - sign) & image->mask;
+}
+
+/**
+ * Decodes an operand of an instruction.
+ * @param image The image.
+ * @param memory The memory holding the instruction.
+ * @param next The address of the operand's first word, moved past its words.
+ * @param end The first address after the code.
+ * @param type The addressing type of the operand.
+ * @param is_dst TRUE for the destination operand, which is encoded in the low bits of a register word.
+ * @param value Receives the operand's cell, or its constant for immediate operands.
+ * @return EMU_RUNNING if the operand was decoded, or the reason it cannot be.
+ */
+static emuStatus decode_operand(emuImage *image, unsigned int *memory, long *next, long end, int type, int is_dst,
+                                unsigned int *value)
+{
+    unsigned int word, address;
+
+    if (*next + (type == INDEX_ADDR ? 2 : 1) > end)
+        return EMU_BAD_INSTRUCTION;
+    word = memory[(*next)++];
+
+    switch (type)
+    {
+    case IMMEDIATE_ADDR:
+        *value = operand_value(image, word);
+        return EMU_RUNNING;
+    case REGISTER_ADDR:
+        *value = (word >> (is_dst ? BITS_IN_ARE : BITS_IN_ARE + BITS_IN_REGISTER)) & (EMU_REGISTERS - 1);
+        return EMU_RUNNING;
+    }
+
+    // Direct and index operands name a memory cell, the index is a constant added to the label's address
+    if ((word & 3) == EXTERN)
+        return EMU_UNRESOLVED;
+    address = (word & image->mask) >> BITS_IN_ARE;
+    if (type == INDEX_ADDR)
+        address += operand_value(image, memory[(*next)++]);
+    address &= image->mask;
+    if (address >= (unsigned int)image->memory_words)
+        return EMU_BAD_ADDRESS;
+    *value = EMU_REGISTERS + address;
+    return EMU_RUNNING;
+}
+
+/**
+ * Decodes the instruction at an address.
+ * @param image The image.
+ * @param memory The memory holding the instruction.
+ * @param address The address of the instruction's first word.
+ * @param op Receives the decoded instruction; an instruction that cannot run becomes an
+ *           ERROR_OP one word long, with its reason in src.
+ */
+static void decode_op(emuImage *image, unsigned int *memory, long address, emuOp *op)
+{
+    unsigned int word = memory[address];
+    long next = address + 1, end = RESERVED_MEMORY + image->code_words;
+    int operation = (word >> (BITS_IN_ARE + 2 * BITS_IN_ADDRESSING)) & 0xF;
+    int src_type = (word >> SRC_TYPE_START_POS) & 3, dst_type = (word >> DST_TYPE_START_POS) & 3;
+    int operands = operation <= SUB_OP || operation == LEA_OP ? 2 : operation <= JSR_OP ? 1 : 0;
+    emuStatus status = EMU_RUNNING;
+
+    memset(op, 0, sizeof(emuOp));
+    op->handler = (unsigned char)operation;
+
+    // The first word has no ARE bits, a single operand is in the destination field
+    if ((word & 3) != ABSOLUTE || (word >> (BITS_IN_ARE + 2 * BITS_IN_ADDRESSING + BITS_IN_OPCODE)) != 0 ||
+        (operands < 2 && src_type != IMMEDIATE_ADDR) || (operands == 0 && dst_type != IMMEDIATE_ADDR))
+        status = EMU_BAD_INSTRUCTION;
+    else if (operands == 2 && src_type == REGISTER_ADDR && dst_type == REGISTER_ADDR)
+    {
+        // Two registers share one word
+        status = decode_operand(image, memory, &next, end, REGISTER_ADDR, FALSE, &op->src);
+        next--;
+        if (status == EMU_RUNNING)
+            status = decode_operand(image, memory, &next, end, REGISTER_ADDR, TRUE, &op->dst);
+    }
+    else
+    {
+        if (operands == 2)
+            status = decode_operand(image, memory, &next, end, src_type, FALSE, &op->src);
+        if (status == EMU_RUNNING && operands >= 1)
+            status = decode_operand(image, memory, &next, end, dst_type, TRUE, &op->dst);
+    }
+
+    if (status == EMU_RUNNING && operands == 2 && src_type == IMMEDIATE_ADDR)
+        op->flags |= EMU_OPERAND_CONST;
+    if (status == EMU_RUNNING && operands >= 1 && dst_type == IMMEDIATE_ADDR)
+        op->flags |= EMU_TARGET_CONST;
+
+    // lea takes the address of its source, a jump the address of its target
+    if (operation == LEA_OP && src_type != REGISTER_ADDR)
+    {
+        op->src -= EMU_REGISTERS;
+        op->flags |= EMU_OPERAND_CONST;
+    }
+    if ((operation == JMP_OP || operation == BNE_OP || operation == JSR_OP) && dst_type != REGISTER_ADDR)
+    {
+        op->dst -= EMU_REGISTERS;
+        op->flags |= EMU_TARGET_CONST;
+    }
+
+    // Only cmp and prn read their destination without writing it
+    if (operands >= 1 && operation != CMP_OP && operation != PRN_OP && operation != JMP_OP &&
+        operation != BNE_OP && operation != JSR_OP)
+    {
+        if (op->flags & EMU_TARGET_CONST)
+            status = EMU_BAD_INSTRUCTION;
+        else if (op->dst >= EMU_REGISTERS + RESERVED_MEMORY && op->dst < (unsigned int)(EMU_REGISTERS + end))
+            op->flags |= EMU_WRITES_CODE;
+    }
+
+    if (status != EMU_RUNNING)
+    {
+        op->handler = ERROR_OP;
+        op->flags = 0;
+        op->src = status;
+        next = address + 1;
+    }
+    op->length = (unsigned short)(next - address);
+}
+
+/**
+ * Decodes the instructions in memory, from the first address of the code on.
+ * @param image The image.
+ * @param ops Receives the decoded instructions, indexed by address - RESERVED_MEMORY.
+ * @param memory The memory holding the code, indexed by address.
+ */
+void decode_code(emuImage *image, emuOp *ops, unsigned int *memory)
+{
+    long i;
+
+    // Words inside an instruction cannot be jumped to
+    for (i = 0; i < image->code_words; i++)
+    {
+        ops[i].handler = ERROR_OP;
+        ops[i].flags = 0;
+        ops[i].length = 1;
+        ops[i].src = EMU_BAD_INSTRUCTION;
+    }
+
+    // The address after the code ends the program
+    ops[image->code_words].handler = ERROR_OP;
+    ops[image->code_words].flags = 0;
+    ops[image->code_words].length = 1;
+    ops[image->code_words].src = EMU_END_OF_CODE;
+
+    for (i = 0; i < image->code_words; i += ops[i].length)
+        decode_op(image, memory, RESERVED_MEMORY + i, &ops[i]);
+}
+
+/**
+ * Loads an object file into a new image and decodes its code. Object files of
+ * large-memory mode, with 16 digit words, are loaded with 32 bit words.
+ * @param image Receives the image.
+ * @param file The object file, open for reading.
+ * @return TRUE if the image was loaded, FALSE if the file is not a valid object file
+ *         or memory allocation failed.
+ */
+int load_image(emuImage *image, FILE *file)
+{
+    inputFile input;
+    lineView line;
+    char *p, *end;
+    long address, count = 0;
+    unsigned int word;
+    int digits = 0, ok = TRUE;
+
+    memset(image, 0, sizeof(emuImage));
+    if (!open_input(&input, file))
+        return FALSE;
+
+    // The first line holds the number of instruction and data words
+    if (!next_line(&input, &line))
+        ok = FALSE;
+    else
+    {
+        p = line.start;
+        end = line_end(&line);
+        ok = read_number(&p, end, &image->code_words) && read_number(&p, end, &image->data_words) && p == end;
+    }
+
+    while (ok && next_line(&input, &line))
+    {
+        p = line.start;
+        end = line_end(&line);
+        if (p == end)
+            continue;
+        if (!read_number(&p, end, &address) || address != RESERVED_MEMORY + count ||
+            count == image->code_words + image->data_words)
+        {
+            ok = FALSE;
+            break;
+        }
+
+        // Every word has as many digits as the first one, 7 or 16 of them
+        if (digits == 0)
+        {
+            digits = (int)(end - p);
+            image->bits = digits == BASE4_SIZE - 1 ? BITS_IN_WORD : EMU_WIDE_BITS;
+            image->mask = image->bits == EMU_WIDE_BITS ? 0xFFFFFFFFu : (1u << BITS_IN_WORD) - 1;
+            image->memory_words = MAX_MEMORY_SIZE;
+            if (image->bits == EMU_WIDE_BITS && RESERVED_MEMORY + image->code_words + image->data_words > MAX_MEMORY_SIZE)
+                image->memory_words = RESERVED_MEMORY + image->code_words + image->data_words;
+            if ((digits != BASE4_SIZE - 1 && digits != 2 * BASE4_SIZE) ||
+                RESERVED_MEMORY + image->code_words + image->data_words > image->memory_words)
+            {
+                ok = FALSE;
+                break;
+            }
+            image->words = (unsigned int *)calloc(image->memory_words, sizeof(unsigned int));
+            if (image->words == NULL)
+            {
+                ok = FALSE;
+                break;
+            }
+        }
+        if (end - p != digits || decode_ob_word(p, end, &word) != end)
+        {
+            ok = FALSE;
+            break;
+        }
+        image->words[address] = word;
+        count++;
+    }
+    close_input(&input);
+
+    // An image without words still has a memory to run in
+    if (ok && count == 0 && image->code_words + image->data_words == 0)
+    {
+        image->bits = BITS_IN_WORD;
+        image->mask = (1u << BITS_IN_WORD) - 1;
+        image->memory_words = MAX_MEMORY_SIZE;
+        image->words = (unsigned int *)calloc(image->memory_words, sizeof(unsigned int));
+        ok = image->words != NULL;
+    }
+    if (ok && count == image->code_words + image->data_words)
+    {
+        image->ops = (emuOp *)malloc((image->code_words + 1) * sizeof(emuOp));
+        if (image->ops != NULL)
+        {
+            decode_code(image, image->ops, image->words);
+            return TRUE;
+        }
+    }
+    free_image(image);
+    return FALSE;
+}
+
+/**
+ * Frees the memory of an image.
+ * @param image The image.
+ */
+void free_image(emuImage *image)
+{
+    free(image->words);
+    free(image->ops);
+    memset(image, 0, sizeof(emuImage));
+}
+
+/**
+ * Prepares a machine to run an image from its first instruction, with empty
+ * registers, an empty input tape and the memory as loaded. The machine runs
+ * the image's decoded code until the program writes into its code.
+ * @param machine The machine.
+ * @param image The image, which must outlive the machine.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+int init_machine(emuMachine *machine, emuImage *image)
+{
+    memset(machine, 0, sizeof(emuMachine));
+    machine->image = image;
+    machine->ops = image->ops;
+    machine->pc = RESERVED_MEMORY;
+    machine->cells = (unsigned int *)calloc(EMU_REGISTERS + image->memory_words, sizeof(unsigned int));
+    machine->output = (char *)malloc(EMU_OUTPUT_SIZE);
+    if (machine->cells == NULL || machine->output == NULL)
+    {
+        free_machine(machine);
+        return FALSE;
+    }
+    memcpy(machine->cells + EMU_REGISTERS, image->words, image->memory_words * sizeof(unsigned int));
+    machine->output_capacity = EMU_OUTPUT_SIZE;
+    machine->status = EMU_RUNNING;
+    return TRUE;
+}
+
+/**
+ * Frees the memory of a machine. The image is not freed.
+ * @param machine The machine.
+ */
+void free_machine(emuMachine *machine)
+{
+    if (machine->ops != machine->image->ops)
+        free(machine->ops);
+    free(machine->cells);
+    free(machine->output);
+    machine->ops = NULL;
+    machine->cells = NULL;
+    machine->output = NULL;
+}
+
+/**
+ * Decodes the code again after the program wrote into it. The first time, the
+ * machine gets its own copy of the decoded code, so the image stays as loaded.
+ * @param machine The machine.
+ * @return The decoded code, or NULL if memory allocation failed.
+ */
+emuOp *emu_rewrite_code(emuMachine *machine)
+{
+    emuImage *image = machine->image;
+
+    if (machine->ops == image->ops)
+    {
+        machine->ops = (emuOp *)malloc((image->code_words + 1) * sizeof(emuOp));
+        if (machine->ops == NULL)
+        {
+            machine->ops = image->ops;
+            return NULL;
+        }
+    }
+    decode_code(image, machine->ops, machine->cells + EMU_REGISTERS);
+    return machine->ops;
+}
+
+/**
+ * Writes the operand of prn to the machine's output.
+ * @param machine The machine.
+ * @param value The operand.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+int emu_print(emuMachine *machine, unsigned int value)
+{
+    unsigned int sign = 1u << (machine->image->bits - 1);
+    long number = value & sign ? (long)value - (long)machine->image->mask - 1 : (long)value;
+    char *output;
+
+    if (machine->output_length + 16 > machine->output_capacity)
+    {
+        output = (char *)realloc(machine->output, machine->output_capacity * 2);
+        if (output == NULL)
+            return FALSE;
+        machine->output = output;
+        machine->output_capacity *= 2;
+    }
+    if (machine->numbers)
+        machine->output_length += sprintf(machine->output + machine->output_length, "%ld\n", number);
+    else
+        machine->output[machine->output_length++] = (char)value;
+    return TRUE;
+}
+
+/**
+ * Runs the program from the machine's program counter until it halts, fails or
+ * reaches the step limit. Every instruction jumps straight to the code of the
+ * next one through a table of handlers (threaded dispatch), reading operands
+ * that were resolved when the code was decoded.
+ * @param machine The machine.
+ * @param max_steps Most instructions to run, or a negative number for no limit.
+ * @return Why the machine stopped, also kept in the machine.
+ */
+emuStatus run_machine(emuMachine *machine, long max_steps)
+{
+    unsigned int *cells = machine->cells;        // R0-R7, then the memory
+    unsigned int mask = machine->image->mask;    // The bits of a word
+    unsigned long code_words = (unsigned long)machine->image->code_words;
+    emuOp *ops = machine->ops;                   // The decoded code
+    emuOp *op;                                   // The instruction being run
+    long steps = 0;                              // Instructions run by this call
+    unsigned int value, target;                  // Result and jump target of the instruction
+    int zero = machine->zero;                    // The zero flag
+    emuStatus status = EMU_RUNNING;
+#ifdef EMU_THREADED
+    __extension__ static void *handlers[] = {&&do_MOV_OP, &&do_CMP_OP, &&do_ADD_OP, &&do_SUB_OP, &&do_NOT_OP, &&do_CLR_OP,
+                                             &&do_LEA_OP, &&do_INC_OP, &&do_DEC_OP, &&do_JMP_OP, &&do_BNE_OP, &&do_RED_OP,
+                                             &&do_PRN_OP, &&do_JSR_OP, &&do_RTS_OP, &&do_HLT_OP, &&do_ERROR_OP, &&do_ERROR_OP};
+#define CASE(name) do_##name:
+#define THREAD() __extension__({ goto *handlers[op->handler]; })
+#else
+#define CASE(name) case name:
+#define THREAD() goto dispatch
+#endif
+#define DISPATCH()                 \
+    do                             \
+    {                              \
+        if (steps == max_steps)    \
+            goto step_limit;       \
+        steps++;                   \
+        THREAD();                  \
+    } while (0)
+#define SRC (op->flags & EMU_OPERAND_CONST ? op->src : cells[op->src])
+#define DST (op->flags & EMU_TARGET_CONST ? op->dst : cells[op->dst])
+#define NEXT()           \
+    do                   \
+    {                    \
+        op += op->length; \
+        DISPATCH();      \
+    } while (0)
+#define STORE(result)                      \
+    do                                     \
+    {                                      \
+        cells[op->dst] = (result);         \
+        if (op->flags & EMU_WRITES_CODE)   \
+            goto code_written;             \
+        NEXT();                            \
+    } while (0)
+#define JUMP(address)                                \
+    do                                               \
+    {                                                \
+        target = (address) - RESERVED_MEMORY;        \
+        if (target > code_words)                     \
+            goto bad_jump;                           \
+        op = ops + target;                           \
+        DISPATCH();                                  \
+    } while (0)
+
+    if (machine->status != EMU_RUNNING)
+        return machine->status;
+    if (machine->pc - RESERVED_MEMORY > code_words)
+    {
+        machine->status = EMU_BAD_JUMP;
+        return EMU_BAD_JUMP;
+    }
+    op = ops + (machine->pc - RESERVED_MEMORY);
+    DISPATCH();
+
+#ifndef EMU_THREADED
+dispatch:
+    switch (op->handler)
+    {
+#endif
+    CASE(MOV_OP)
+        STORE(SRC);
+    CASE(CMP_OP)
+        zero = ((SRC - DST) & mask) == 0;
+        NEXT();
+    CASE(ADD_OP)
+        value = (cells[op->dst] + SRC) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(SUB_OP)
+        value = (cells[op->dst] - SRC) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(NOT_OP)
+        value = ~cells[op->dst] & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(CLR_OP)
+        zero = TRUE;
+        STORE(0);
+    CASE(LEA_OP)
+        STORE(SRC);
+    CASE(INC_OP)
+        value = (cells[op->dst] + 1) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(DEC_OP)
+        value = (cells[op->dst] - 1) & mask;
+        zero = value == 0;
+        STORE(value);
+    CASE(JMP_OP)
+        JUMP(DST);
+    CASE(BNE_OP)
+        if (!zero)
+            JUMP(DST);
+        NEXT();
+    CASE(RED_OP)
+        if (machine->input_position < machine->input_length)
+            value = (unsigned char)machine->input[machine->input_position++];
+        else
+            value = mask; // -1 at the end of the tape
+        STORE(value);
+    CASE(PRN_OP)
+        if (!emu_print(machine, DST))
+        {
+            status = EMU_OUT_OF_MEMORY;
+            goto stop;
+        }
+        NEXT();
+    CASE(JSR_OP)
+        if (machine->depth == EMU_STACK_SIZE)
+        {
+            status = EMU_STACK_OVERFLOW;
+            goto stop;
+        }
+        machine->stack[machine->depth++] = (unsigned int)(op - ops) + RESERVED_MEMORY + op->length;
+        JUMP(DST);
+    CASE(RTS_OP)
+        if (machine->depth == 0)
+        {
+            status = EMU_STACK_UNDERFLOW;
+            goto stop;
+        }
+        JUMP(machine->stack[--machine->depth]);
+    CASE(HLT_OP)
+        status = EMU_HALTED;
+        goto stop;
+    CASE(ERROR_OP)
+        steps--; // The word did not run
+        status = (emuStatus)op->src;
+        goto stop;
+#ifndef EMU_THREADED
+    default:
+        steps--;
+        status = EMU_BAD_INSTRUCTION;
+        goto stop;
+    }
+#endif
+
+code_written:
+    // The instruction after the one that wrote into the code is decoded again too
+    target = (unsigned int)(op - ops) + op->length;
+    ops = emu_rewrite_code(machine);
+    if (ops == NULL)
+    {
+        ops = machine->ops;
+        op = ops + target;
+        status = EMU_OUT_OF_MEMORY;
+        goto stop;
+    }
+    op = ops + target;
+    DISPATCH();
+
+bad_jump:
+    status = EMU_BAD_JUMP;
+    goto stop;
+
+step_limit:
+    status = EMU_STEP_LIMIT;
+
+stop:
+    machine->pc = (unsigned int)(op - ops) + RESERVED_MEMORY;
+    machine->zero = zero;
+    machine->steps += steps;
+    machine->status = status == EMU_STEP_LIMIT ? EMU_RUNNING : status;
+    return status;
+
+#undef CASE
+#undef THREAD
+#undef DISPATCH
+#undef SRC
+#undef DST
+#undef NEXT
+#undef STORE
+#undef JUMP
+}
+
+/**
+ * Describes why a machine stopped.
+ * @param status The status.
+ * @return The description.
+ */
+const char *emu_status_text(emuStatus status)
+{
+    switch (status)
+    {
+    case EMU_RUNNING:
+        return "running";
+    case EMU_HALTED:
+        return "halted";
+    case EMU_STEP_LIMIT:
+        return "step limit reached";
+    case EMU_BAD_INSTRUCTION:
+        return "invalid instruction";
+    case EMU_UNRESOLVED:
+        return "unresolved external";
+    case EMU_BAD_ADDRESS:
+        return "operand outside the memory";
+    case EMU_BAD_JUMP:
+        return "jump outside the code";
+    case EMU_END_OF_CODE:
+        return "ran past the end of the code";
+    case EMU_STACK_OVERFLOW:
+        return "return stack overflow";
+    case EMU_STACK_UNDERFLOW:
+        return "rts with an empty return stack";
+    case EMU_OUT_OF_MEMORY:
+        return "memory allocation failed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "utils.h"
+#include "namePool.h"
+
+/**
+ * Computes the hash value of a name (FNV-1a).
+ * @param name The name.
+ * @return The computed hash value.
+ */
+unsigned int symbol_hash(char *name)
+{
+    unsigned int hashval = 2166136261u;
+    while (*name != '\0')
+    {
+        hashval ^= (unsigned char)*name++;
+        hashval *= 16777619u;
+    }
+    return hashval;
+}
+
+/**
+ * Finds the slot of a name: the slot holding its id, or the empty slot ending its probe sequence.
+ * @param pool The name pool.
+ * @param name The name.
+ * @param length The length of the name.
+ * @param hashval The hash value of the name.
+ * @return The index of the slot.
+ */
+static unsigned int find_slot(namePool *pool, char *name, int length, unsigned int hashval)
+{
+    unsigned int i = hashval & (pool->slot_capacity - 1);
+    internedName *entry;
+
+    while (pool->slots[i] != NO_NAME)
+    {
+        entry = &pool->names[pool->slots[i]];
+        if (entry->hash == hashval && entry->length == length && memcmp(entry->text, name, length) == 0)
+            break;
+        i = (i + 1) & (pool->slot_capacity - 1); // Linear probing
+    }
+    return i;
+}
+
+/**
+ * Doubles the pool's capacity and rebuilds its slots from the cached hashes.
+ * @param pool The name pool.
+ * @return TRUE if the pool grew, FALSE if memory allocation failed.
+ */
+static int grow_pool(namePool *pool)
+{
+    int capacity = pool->capacity ? pool->capacity * 2 : NAME_POOL_INITIAL_SIZE;
+    internedName *names = (internedName *)checkedAlloc((long)capacity * sizeof(internedName));
+    int *slots = (int *)checkedAlloc((long)capacity * 2 * sizeof(int));
+    unsigned int i;
+    int id;
+
+    if (names == NULL || slots == NULL)
+    {
+        free(names);
+        free(slots);
+        return FALSE;
+    }
+    if (pool->count)
+        memcpy(names, pool->names, pool->count * sizeof(internedName));
+    free(pool->names);
+    free(pool->slots);
+    pool->names = names;
+    pool->capacity = capacity;
+    pool->slots = slots;
+    pool->slot_capacity = (unsigned int)capacity * 2; // Keeps the load factor at most 1/2
+    memset(slots, 0xFF, pool->slot_capacity * sizeof(int)); // Every slot starts as NO_NAME
+
+    for (id = 0; id < pool->count; id++)
+    {
+        i = names[id].hash & (pool->slot_capacity - 1);
+        while (slots[i] != NO_NAME)
+            i = (i + 1) & (pool->slot_capacity - 1);
+        slots[i] = id;
+    }
+    return TRUE;
+}
+
+/**
+ * Returns the id of a name, adding it to the pool if it is new. A name is stored
+ * only once, so two ids are equal exactly when the names are.
+ * @param pool The name pool.
+ * @param name The name.
+ * @return The id of the name, or NO_NAME if memory allocation failed.
+ */
+int intern_name(namePool *pool, char *name)
+{
+    int length = (int)strlen(name);
+    unsigned int hashval = symbol_hash(name);
+    unsigned int i;
+    internedName *entry;
+
+    if (pool->count == pool->capacity && !grow_pool(pool))
+        return NO_NAME;
+
+    i = find_slot(pool, name, length, hashval);
+    if (pool->slots[i] != NO_NAME)
+    {
+        pool->shared++;
+        pool->shared_bytes += length + 1;
+        return pool->slots[i]; // Already stored
+    }
+
+    entry = &pool->names[pool->count];
+    entry->text = (char *)arenaAlloc(length + 1);
+    if (entry->text == NULL)
+        return NO_NAME;
+    memcpy(entry->text, name, length + 1);
+    entry->length = length;
+    entry->hash = hashval;
+    pool->bytes += length + 1;
+    pool->slots[i] = pool->count;
+    return pool->count++;
+}
+
+/**
+ * Returns the id of a name without adding it to the pool.
+ * @param pool The name pool.
+ * @param name The name.
+ * @return The id of the name, or NO_NAME if the name was never interned.
+ */
+int find_name(namePool *pool, char *name)
+{
+    if (pool->count == 0)
+        return NO_NAME;
+    return pool->slots[find_slot(pool, name, (int)strlen(name), symbol_hash(name))];
+}
+
+/**
+ * Frees the memory held by the pool. The names themselves live in the file's arena.
+ * @param pool The name pool to reset.
+ */
+void reset_name_pool(namePool *pool)
+{
+    free(pool->names);
+    free(pool->slots);
+    memset(pool, 0, sizeof(namePool));
+}
+
+/**
+ * Empties the pool but keeps its arrays, so the next file starts with the capacity
+ * this one needed.
+ * @param pool The name pool to clear.
+ */
+void clear_name_pool(namePool *pool)
+{
+    if (pool->slots != NULL)
+        memset(pool->slots, 0xFF, pool->slot_capacity * sizeof(int)); // Every slot becomes NO_NAME
+    pool->count = 0;
+    pool->bytes = 0;
+    pool->shared = 0;
+    pool->shared_bytes = 0;
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+#include "firstPass.h"
+#include "optimizer.h"
+#include "vars.h"
+
+static int self_move(codeProgram *program, int index);
+static int zero_add(codeProgram *program, int index);
+static int dead_compare(codeProgram *program, int index);
+static int jump_to_next(codeProgram *program, int index);
+
+/* The rules, tried in order on every command that is still there */
+static const peepholeRule rules[] = {
+    {"mov rX, rX", self_move},
+    {"add/sub #0 with an unused zero flag", zero_add},
+    {"cmp with an unused zero flag", dead_compare},
+    {"jmp to the next command", jump_to_next},
+};
+
+/**
+ * Returns the value of an operand word, without its A/R/E bits.
+ * @param word The word.
+ * @return The value, as many bits as a word of the output holds.
+ */
+static unsigned int word_value(unsigned int word)
+{
+    unsigned int bits = context->large_memory ? 30 : BITS_IN_WORD - BITS_IN_ARE;
+    return (word >> BITS_IN_ARE) & ((1u << bits) - 1);
+}
+
+/**
+ * Finds the first command at or after a position that no rule removed.
+ * @param program The commands.
+ * @param index The position.
+ * @return The command's position, or program->count if there is none.
+ */
+static int next_kept(codeProgram *program, int index)
+{
+    while (index < program->count && program->ops[index].removed)
+        index++;
+    return index;
+}
+
+/**
+ * Finds the command whose first word is at an address.
+ * @param program The commands.
+ * @param address The address, from RESERVED_MEMORY on.
+ * @return The command's position, or -1 if no command starts there.
+ */
+static int find_command(codeProgram *program, unsigned int address)
+{
+    int low = 0, high = program->count - 1, middle;
+
+    while (low <= high)
+    {
+        middle = (low + high) / 2;
+        if ((unsigned int)program->ops[middle].address + RESERVED_MEMORY == address)
+            return middle;
+        if ((unsigned int)program->ops[middle].address + RESERVED_MEMORY < address)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return -1;
+}
+
+/**
+ * Tells if the zero flag set by a command is never read. Only the commands that
+ * follow it in the code are looked at: the flag is unused if one of them sets it
+ * again or halts before a bne reads it; a jump, jsr or rts ends the search.
+ * @param program The commands.
+ * @param index The command's position.
+ * @return TRUE if the flag is overwritten or the program halts first, FALSE otherwise.
+ */
+static int zero_flag_unused(codeProgram *program, int index)
+{
+    for (index = next_kept(program, index + 1); index < program->count; index = next_kept(program, index + 1))
+    {
+        switch (program->ops[index].operation)
+        {
+        case CMP_OP:
+        case ADD_OP:
+        case SUB_OP:
+        case NOT_OP:
+        case CLR_OP:
+        case INC_OP:
+        case DEC_OP:
+        case HLT_OP:
+            return TRUE;
+        case BNE_OP:
+        case JMP_OP:
+        case JSR_OP:
+        case RTS_OP:
+            return FALSE;
+        default:
+            break;
+        }
+    }
+    return TRUE; // Running past the last command stops the program
+}
+
+/**
+ * Rule: mov rX, rX changes nothing, not even the zero flag.
+ */
+static int self_move(codeProgram *program, int index)
+{
+    codeOp *op = &program->ops[index];
+    unsigned int word;
+
+    if (op->operation != MOV_OP || op->src != REGISTER_ADDR || op->dst != REGISTER_ADDR)
+        return FALSE;
+    word = segment_load(&instructions, op->address + 1) >> BITS_IN_ARE;
+    return (word >> BITS_IN_REGISTER) == (word & ((1u << BITS_IN_REGISTER) - 1));
+}
+
+/**
+ * Rule: add #0 and sub #0 only set the zero flag, so they go when the flag is unused.
+ */
+static int zero_add(codeProgram *program, int index)
+{
+    codeOp *op = &program->ops[index];
+    unsigned int word;
+
+    if ((op->operation != ADD_OP && op->operation != SUB_OP) || op->src != IMMEDIATE_ADDR)
+        return FALSE;
+    word = segment_load(&instructions, op->address + 1);
+    return (word & ((1u << BITS_IN_ARE) - 1)) == ABSOLUTE && word_value(word) == 0 && zero_flag_unused(program, index);
+}
+
+/**
+ * Rule: cmp only sets the zero flag, so it goes when the flag is unused.
+ */
+static int dead_compare(codeProgram *program, int index)
+{
+    return program->ops[index].operation == CMP_OP && zero_flag_unused(program, index);
+}
+
+/**
+ * Rule: a jmp to a label of the command that runs after it anyway.
+ */
+static int jump_to_next(codeProgram *program, int index)
+{
+    codeOp *op = &program->ops[index];
+    unsigned int word;
+    int target;
+
+    if (op->operation != JMP_OP || op->dst != DIRECT_ADDR)
+        return FALSE;
+    word = segment_load(&instructions, op->address + 1);
+    if ((word & ((1u << BITS_IN_ARE) - 1)) != RELOCATABLE)
+        return FALSE;
+    target = find_command(program, word_value(word));
+    return target > index && next_kept(program, target) == next_kept(program, index + 1);
+}
+
+/**
+ * Reads the encoded instructions back into commands.
+ * @param program Receives the commands.
+ * @return TRUE on success, FALSE if memory allocation failed.
+ */
+static int read_commands(codeProgram *program)
+{
+    codeOp *op;
+    unsigned int word;
+    int address;
+
+    program->ops = (codeOp *)malloc((ic + 1) * sizeof(codeOp));
+    program->count = 0;
+    if (program->ops == NULL)
+        return FALSE;
+
+    for (address = 0; address < ic; address += op->length)
+    {
+        word = segment_load(&instructions, address);
+        op = &program->ops[program->count++];
+        op->address = address;
+        op->operation = (opcode)(word >> (SRC_TYPE_END_POS + 1));
+        op->src = (addressing_type)extract_bits(word, SRC_TYPE_START_POS, SRC_TYPE_END_POS);
+        op->dst = (addressing_type)extract_bits(word, DST_TYPE_START_POS, DST_TYPE_END_POS);
+        op->removed = FALSE;
+
+        // The first word has no source bits unless there are two operands
+        switch (get_operand_count_by_opcode(op->operation))
+        {
+        case 0:
+            op->src = op->dst = NONE_ADDR;
+            break;
+        case 1:
+            op->src = NONE_ADDR;
+            break;
+        }
+        op->length = 1 + calculate_command_num_additional_words(op->src, op->dst);
+    }
+    return TRUE;
+}
+
+/**
+ * Moves an address of the code or the data to where it is after the removal.
+ * @param moved New position of every word of the instructions array, and of its end.
+ * @param old_ic Number of instruction words before the removal.
+ * @param address The address, from RESERVED_MEMORY on.
+ * @return The new address.
+ */
+static int move_address(int *moved, int old_ic, int address)
+{
+    if (address < RESERVED_MEMORY)
+        return address;
+    if (address - RESERVED_MEMORY <= old_ic)
+        return moved[address - RESERVED_MEMORY] + RESERVED_MEMORY;
+    return address - (old_ic - moved[old_ic]); // The data follows the code
+}
+
+/**
+ * Moves the remaining commands down and everything that refers to the code with them.
+ * @param program The commands, with the removed ones marked.
+ * @param moved New position of every word of the instructions array, and of its end.
+ */
+static void move_commands(codeProgram *program, int *moved)
+{
+    codeOp *op;
+    Symbol *symbol;
+    external **use;
+    unsigned int word;
+    int i, j, position = 0, old_ic = ic;
+
+    // Find the new position of every word, a removed command's words go to the command after it
+    for (i = 0; i < program->count; i++)
+    {
+        op = &program->ops[i];
+        for (j = 0; j < op->length; j++)
+            moved[op->address + j] = op->removed ? -1 : position + j;
+        if (op->removed)
+            moved[op->address] = position;
+        else
+            position += op->length;
+    }
+    moved[old_ic] = position;
+
+    // Move the words, relocating the addresses they hold
+    for (i = 0; i < program->count; i++)
+    {
+        op = &program->ops[i];
+        if (op->removed)
+            continue;
+        for (j = 0; j < op->length; j++)
+        {
+            word = segment_load(&instructions, op->address + j);
+            if (j > 0 && (word & ((1u << BITS_IN_ARE) - 1)) == RELOCATABLE)
+                word = insert_are((unsigned int)move_address(moved, old_ic, (int)word_value(word)), RELOCATABLE);
+            segment_store(&instructions, moved[op->address + j], word);
+        }
+    }
+
+    // Labels and entries of the code and the data
+    for (symbol = symbols; symbol != NULL; symbol = symbol->next)
+    {
+        if (symbol->attribute == CODE || symbol->attribute == DATA || symbol->attribute == ENTRY)
+            symbol->value = move_address(moved, old_ic, symbol->value);
+    }
+
+    // External use sites, those of removed commands are dropped
+    for (use = &externals; *use != NULL;)
+    {
+        if ((*use)->address < old_ic && moved[(*use)->address] < 0)
+            *use = (*use)->next;
+        else
+        {
+            if ((*use)->address < old_ic)
+                (*use)->address = moved[(*use)->address];
+            use = &(*use)->next;
+        }
+    }
+
+    ic = position;
+}
+
+/**
+ * Removes the commands matched by the peephole rules from the instructions image.
+ * The rules are applied until none matches, since a removal can let another rule
+ * match (a jmp over a removed command, for example).
+ * @return The number of instruction words removed.
+ */
+int optimize_code(void)
+{
+    codeProgram program;
+    int *moved;
+    int i, r, changed, old_ic = ic;
+
+    moved = (int *)malloc((ic + 1) * sizeof(int));
+    if (moved == NULL || !read_commands(&program))
+    {
+        free(moved);
+        return 0; // The image is left as it is
+    }
+
+    do
+    {
+        changed = FALSE;
+        for (i = 0; i < program.count; i++)
+        {
+            for (r = 0; r < (int)(sizeof(rules) / sizeof(rules[0])) && !program.ops[i].removed; r++)
+            {
+                if (rules[r].matches(&program, i))
+                {
+                    program.ops[i].removed = TRUE;
+                    changed = TRUE;
+                }
+            }
+        }
+    } while (changed);
+
+    move_commands(&program, moved);
+    free(program.ops);
+    free(moved);
+    return old_ic - ic;
+}
@@ -4,43 +4,78 @@
 #include "utils.h"
 #include "preAssembler.h"
 #include "vars.h"
-#include "hashtable.h"
+#include "hashTable.h"
+#include "inputFile.h"
 
 /**
- * Pre-processes each line from the input file, preparing it for assembly.
- * Checks for line length and expands macro's.
+ * Pre-processes a source file, preparing it for assembly.
+ * The file is mapped (or read in one go) and handed to pre_assemble_input.
  * @param file Pointer to the input file.
- * @param fp Pointer to the output file.
+ * @param src The in-memory buffer that receives the expanded source.
  */
-void preAssembler(FILE *file, FILE *fp)
+void preAssembler(FILE *file, sourceBuffer *src)
 {
-    char line[LINESIZE + 2]; // Buffer to hold each line read from the file
+    inputFile input; // The whole input file
+
+    if (!open_input(&input, file))
+    {
+        has_error = TRUE;
+        print_error_message(CANNOT_OPEN_FILE, 0);
+        return;
+    }
+    pre_assemble_input(&input, src);
+    close_input(&input);
+}
+
+/**
+ * Pre-processes each line of an input, preparing it for assembly.
+ * Checks for line length and expands macro's. The lines are handled in place
+ * inside the input, so only lines that are too long, or a last line without a
+ * newline, are copied.
+ * @param input The input, positioned at its first line.
+ * @param src The in-memory buffer that receives the expanded source.
+ */
+void pre_assemble_input(inputFile *input, sourceBuffer *src)
+{
+    lineView view; // The current line
+    char line[LINESIZE + 2]; // Copy of a line that is too long or has no newline
+    int content; // Length of the line without its newline
     char macro[SYMBOL_MAX_SIZE + 1]; // Buffer to hold macro definitions
-    unsigned char index = 0; // Index for macro buffer
     int line_num = 1; // Line number counter
 
-    // Loop through each line in the file
-    while (fgets(line, sizeof(line), file) != NULL)
+    macro[0] = '\0'; // No macro is being defined at the start of the file
+
+    // Loop through each line in the input
+    while (next_line(input, &view))
     {
+        context->stats.lines_read++;
         err = FALSE; // Reset error flag for each line
         warn = FALSE; // Reset warning flag for each line
 
-        // Check if line length exceeds maximum and fix if necessary
-        if (strlen(line) == LINESIZE + 1 && line[LINESIZE] != '\n')
+        content = view.length - (view.start[view.length - 1] == '\n');
+
+        // Check if line length exceeds maximum and cut it if necessary
+        if (content > LINESIZE)
         {
             warn = WARNING_LINE_TOO_LONG; // Set warning flag for long lines
             print_error_message(warn, line_num); // Print warning message
 
-            // Flush the rest of the line to avoid processing remnants
-            int ch;
-            while ((ch = fgetc(file)) != '\n' && ch != EOF)
-                ;
+            memcpy(line, view.start, LINESIZE); // Keep the first LINESIZE characters
             line[LINESIZE] = '\n'; // Add newline character at correct position
-            line[LINESIZE + 1] = '\0'; // Truncate line to LINESIZE characters
+            line[LINESIZE + 1] = '\0';
+            view.start = line;
+            view.length = LINESIZE + 1;
+        }
+        // The last line may have no newline to stop the parsing, give it a terminator
+        else if (content == view.length)
+        {
+            memcpy(line, view.start, content);
+            line[content] = '\0';
+            view.start = line;
         }
 
         // Pre-process the current line and check for errors
-        if (!pre_process_line(line, fp, macro))
+        if (!pre_process_line(view.start, view.length, src, macro))
         {
             has_error = TRUE; // Set overall error flag if an error occurs
             print_error_message(err, line_num); // Print error message
@@ -53,17 +88,18 @@ void preAssembler(FILE *file, FILE *fp)
 
 /**
  * Pre_processes a single line of code, handling macros and checking for errors.
- * @param line Pointer to the line of code to be pre_processed.
- * @param fp Pointer to the output file.
+ * @param line Pointer to the line of code to be pre_processed, ended by a newline or a null terminator.
+ * @param line_length Number of characters in the line, including the newline.
+ * @param src The in-memory buffer that receives the expanded source.
  * @param macro Pointer to the buffer for macro definitions.
  * @return Returns TRUE if the line was processed successfully, FALSE otherwise.
  */
-int pre_process_line(char *line, FILE *fp, char *macro)
+int pre_process_line(char *line, int line_length, sourceBuffer *src, char *macro)
 {
     int index = 0; // Index for traversing the line
     char field[SYMBOL_MAX_SIZE + 1]; // Buffer for storing symbols
 
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the first non-white character
+    MOVE_TO_NOT_BLANK(line, index); // Move index to the first non-white character
 
     // Check for end of line or comment
     if (is_end_of_line(line[index]) || line[index] == ';')
@@ -78,9 +114,9 @@ int pre_process_line(char *line, FILE *fp, char *macro)
         field[0] = '\0'; // Empty the field to indicate an invalid symbol
 
     // Look up the symbol in the macro table
-    node *tmp = lookup(macroTable, field);
+    hashEntry *tmp = lookup(macroTable, field);
 
-    MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white character
+    MOVE_TO_NOT_BLANK(line, index); // Move index to the next non-white character
 
     // If the symbol is a macro, expand it
     if (tmp != NULL)
@@ -90,9 +126,9 @@ int pre_process_line(char *line, FILE *fp, char *macro)
             err = MACRO_UNEXPECTED_CHARS;
             return FALSE; // Return false to indicate error
         }
-        // Expand the macro by writing its lines to the output file
-        for (node *current = tmp; current != NULL; current = current->next)
-            fputs(current->line, fp);
+        // Expand the macro by appending its whole body to the source buffer at once
+        append_source(src, &tmp->body);
+        context->stats.macro_expansions++;
         return TRUE; // Return true to indicate successful processing
     }
 
@@ -107,7 +143,7 @@ int pre_process_line(char *line, FILE *fp, char *macro)
         if (length == SYMBOL_MAX_SIZE)
             field[0] = '\0'; // Empty the field to indicate an invalid macro name
 
-        MOVE_TO_NOT_WHITE(line, index); // Move index to the next non-white character
+        MOVE_TO_NOT_BLANK(line, index); // Move index to the next non-white character
 
         // Check for unexpected characters after the macro name or if the macro name is invalid
         if (!is_end_of_line(line[index]) || (macro[0] && !is_valid_macro(macro)))
@@ -131,10 +167,10 @@ int pre_process_line(char *line, FILE *fp, char *macro)
     {
         // If currently defining a macro, insert the line into the macro table
         if (macro[0])
-            insert(macroTable, macro, line);
+            return insert(macroTable, macro, line, line_length); // Fails only if memory allocation failed
         else
         {
-            fputs(line, fp); // Otherwise, write the line to the output file
+            append_line(src, line, line_length); // Otherwise, append the line to the source buffer
         }
     }
   
@@ -7,150 +7,131 @@
 #include "cmdHandlers.h"
 #include "vars.h"
 #include "secondPass.h"
+#include "expression.h"
 
 /**
  * Second pass of the assembler.
- * @param fp Pointer to the input file.
+ * Only the statements recorded by the first pass are visited: commands with label
+ * operands get their additional words encoded and .entry labels are marked.
  */
-void second_pass(FILE *fp)
+void second_pass()
 {
-    char line[LINESIZE + 2]; // Buffer to hold each line read from the file
-    int line_num = 1;        // Line number counter
+    int i;                 // Loop variable
+    int total_ic = ic;     // Number of instruction words counted by the first pass
+    statement *current;    // The statement being resolved
 
-    ic = 0;            // Initialize instruction counter
     has_error = FALSE; // Flag to indicate if an error has occurred
 
-    // Loop through each line in the file
-    while (fgets(line, sizeof(line), fp) != NULL)
+    // Loop through each recorded statement
+    for (i = 0; i < statements.count; i++)
     {
-        err = FALSE;  // Reset error flag for each line
-        warn = FALSE; // Reset warning flag for each line
+        current = &statements.items[i];
+        err = FALSE;  // Reset error flag for each statement
+        warn = FALSE; // Reset warning flag for each statement
 
-        // Process the current line in the second pass
-        if (!process_line_second_pass(line))
+        // Resolve the current statement
+        if (!process_statement(current))
         {
-            has_error = TRUE;                   // Set error flag
-            print_error_message(err, line_num); // Print error message
+            has_error = TRUE;                            // Set error flag
+            print_error_message(err, current->line_num); // Print error message
         }
 
         // Print warning message if there was a warning
         if (warn)
         {
-            print_error_message(warn, line_num);
+            print_error_message(warn, current->line_num);
         }
-
-        line_num++; // Increment line number
     }
+
+    ic = total_ic; // Restore the instruction counter for writing the output
 }
 
 /**
- * Processes a line in the second pass of the assembler.
- * @param line The line to be processed.
- * @return TRUE if the line is successfully processed, FALSE otherwise.
+ * Patches the words left by a single-pass assembly, once all labels are known.
+ * Fixups are patched in source order, so externals are listed as in the two-pass mode.
  */
-int process_line_second_pass(char *line)
+void patch_fixups()
 {
-    instruction instruction;
-    opcode operation;
-    char symbol[SYMBOL_MAX_SIZE + 1];
-    int index = 0;
-
-    // Move index to the first non-white space character
-    MOVE_TO_NOT_WHITE(line, index);
-
-    // Find label if present
-    find_label(line, symbol);
-
-    // Skip label if found
-    if (symbol[0])
-    {
-        for (; line[index] != ':'; index++)
-            ;
-        index++;
-    }
+    int i;                 // Loop variable
+    int total_ic = ic;     // Number of instruction words counted while reading
+    int error_line = 0;    // Line of the last error reported, errors are reported once per line
+    int is_valid;          // Flag indicating if the fixup was patched
+    fixup *current;        // The fixup being patched
 
-    // Move index to the first non-white space character after label
-    MOVE_TO_NOT_WHITE(line, index);
+    has_error = FALSE;     // Flag to indicate if an error has occurred
+    defer_labels = FALSE;  // Labels are resolved from now on
 
-    // Check for end of line
-    if (is_end_of_line(line[index]))
+    // Loop through each recorded fixup
+    for (i = 0; i < fixups.count; i++)
     {
-        return TRUE; // Return TRUE if end of line is reached
-    }
-
-    // Find instruction
-    instruction = find_instruction(line, &index);
+        current = &fixups.items[i];
+        err = FALSE; // Reset error flag for each fixup
 
-    // Move index to the first non-white space character after instruction
-    MOVE_TO_NOT_WHITE(line, index);
+        // Mark the entry, or encode the label's word at its reserved position
+        if (current->directive == ENTRY_IN)
+            is_valid = entryHandler(current->name);
+        else
+        {
+            ic = current->address;
+            is_valid = encode_label(current->name);
+        }
 
-    // Handle instruction if found
-    if (instruction != NONE_IN)
-    {
-        if (instruction == ENTRY_IN)
+        if (!is_valid)
         {
-            return entryHandler(&line[index]); // Handle entry instruction
+            has_error = TRUE; // Set error flag
+            if (current->line_num != error_line)
+                print_error_message(err, current->line_num); // Print error message
+            error_line = current->line_num;
         }
-        return TRUE; // Return TRUE if instruction is found and handled successfully
     }
 
-    // Find operation
-    operation = find_operation(line, &index);
+    ic = total_ic; // Restore the instruction counter for writing the output
+}
 
-    // Move index to the first non-white space character after operation
-    MOVE_TO_NOT_WHITE(line, index);
+/**
+ * Resolves a statement recorded by the first pass.
+ * @param item The statement to resolve.
+ * @return TRUE if the statement is successfully resolved, FALSE otherwise.
+ */
+int process_statement(statement *item)
+{
+    char symbol[LINESIZE + 1]; // Buffer to store the entry symbol
 
-    // Process operation if found
-    if (operation != NONE_OP)
+    if (item->directive == ENTRY_IN)
     {
-        return process_operation(operation, &line[index]); // Process operation
+        span_copy(&item->src, symbol);
+        return entryHandler(symbol); // Handle entry instruction
     }
+
+    return encode_statement(item); // Encode the command's additional words
 }
 
 /**
- * Processes an operation with its operands.
- * @param operation The opcode of the operation to be processed.
- * @param args The arguments string containing operands.
+ * Encodes the additional words of a command at the position the first pass reserved for them.
+ * @param item The command's statement.
  * @return TRUE if the operation is successfully processed, FALSE otherwise.
  */
-int process_operation(opcode operation, char *args)
+int encode_statement(statement *item)
 {
-    int index = 0;
-    char first_operand[LINESIZE], second_operand[LINESIZE];                     // Hold operands
-    char *src = NULL, *dst = NULL;                                              // Pointers to operands
-    int count = get_operand_count_by_opcode(operation);                         // Number of operands
-    addressing_type src_operand_type = NONE_ADDR, dst_operand_type = NONE_ADDR; // Operand types
-
-    // Extract operand types based on the count of operands
-    if (count == 1 || count == 2)
-    {
-        dst_operand_type = extract_bits(instructions[ic], DST_TYPE_START_POS, DST_TYPE_END_POS);
-    }
-    if (count == 2)
-    {
-        src_operand_type = extract_bits(instructions[ic], SRC_TYPE_START_POS, SRC_TYPE_END_POS);
-    }
-
-    // Extract operands from the argument string
-    index += find_next_symbol(args, first_operand, ',');
-    index++;
-    index += find_next_symbol(&args[index], second_operand, ',');
+    char first_operand[LINESIZE + 1], second_operand[LINESIZE + 1]; // Hold operands
+    char *src = NULL, *dst = NULL;                                  // Pointers to operands
 
-    // Set src and dst pointers based on the number of operands
-    if (count >= 1)
+    // Copy the operands out of the source
+    if (item->src.type != NONE_ADDR)
     {
-        dst = first_operand; // First operand is destination
+        span_copy(&item->src, first_operand);
+        src = first_operand;
     }
-    if (count == 2)
+    if (item->dst.type != NONE_ADDR)
     {
-        src = first_operand;  // Second operand is source
-        dst = second_operand; // First operand becomes destination
+        span_copy(&item->dst, second_operand);
+        dst = second_operand;
     }
 
-    ic++; // Increment instruction count
+    ic = item->address; // Move to the command's first additional word
 
     // Encode additional words based on operands and their types
-    return encode_additional_words(src, dst, src_operand_type, dst_operand_type);
+    return encode_additional_words(src, dst, item->src.type, item->dst.type);
 }
 
 /**
@@ -211,6 +192,19 @@ int encode_label(char *symbol)
 {
     unsigned int word = 0;                              // Initialize word to store encoded value
     Symbol *symbol_info = findSymbol(&symbols, symbol); // Find symbol information in the symbol table
+
+    // In single-pass mode only constants are known while reading, other labels are patched later
+    if (defer_labels && (symbol_info == NULL || symbol_info->attribute != MDEFINE))
+    {
+        if (!add_fixup(&fixups, ic, 0, NONE_IN, symbol)) // The line number is filled in by process_code
+        {
+            ic++;         // Skip the word, the file fails anyway
+            return FALSE; // add_fixup has set the error
+        }
+        insert_instructions(0); // Placeholder for the label's address
+        return TRUE;
+    }
+
     if (symbol_info == NULL)
     {
         ic++;                               // Increment instruction counter
@@ -224,7 +218,11 @@ int encode_label(char *symbol)
         word = insert_are(word, ABSOLUTE); // Insert Absolute relocation attribute for MDEFINE symbol
         break;
     case EXTERNAL:
-        add_ext(&externals, symbol, ic); // Add to external symbol table
+        if (!add_ext(&externals, symbol, ic)) // Add to external symbol table
+        {
+            ic++;         // Skip the word, the file fails anyway
+            return FALSE; // add_ext has set the error
+        }
         word = insert_are(word, EXTERN); // Insert External relocation attribute for EXTERNAL symbol
         break;
     default:
@@ -278,10 +276,23 @@ int encode_additional_word(int is_dst, addressing_type type, char *operand)
  */
 int handle_immediate_address(char *operand, unsigned int *word)
 {
+    long value; // Value of a constant expression
+
     if (is_int_str(&operand[1])) // Check if operand is a valid integer
     {
         *word = (unsigned int)atoi(&operand[1]); // Convert operand to integer
-        insert_are(*word, ABSOLUTE); // Insert Absolute relocation attribute
+        *word = insert_are(*word, ABSOLUTE); // Insert Absolute relocation attribute
+        insert_instructions(*word); // Insert encoded value into instructions
+        return TRUE; // Return TRUE indicating successful encoding
+    }
+    else if (is_expression(&operand[1], strlen(&operand[1]))) // Check if operand is a constant expression
+    {
+        if (!fold_constant(&operand[1], &value)) // Fold the expression into its value
+        {
+            ic++; // Leave the word's place
+            return FALSE;
+        }
+        *word = insert_are((unsigned int)value, ABSOLUTE); // Insert Absolute relocation attribute
         insert_instructions(*word); // Insert encoded value into instructions
         return TRUE; // Return TRUE indicating successful encoding
     }
@@ -310,7 +321,21 @@ int handle_index_address(char *operand, unsigned int *word)
     *opening_bracket = '['; // Restore opening bracket
     opening_bracket++; // Move to next character after opening bracket
     *closing_bracket = '\0'; // Replace closing bracket with null terminator
-    if (is_int_str(opening_bracket)) // Check if string after opening bracket is a valid integer
+    if (is_expression(opening_bracket, strlen(opening_bracket))) // Check if the index is a constant expression
+    {
+        long value; // Value of the expression
+        if (!fold_constant(opening_bracket, &value)) // Fold the expression into its value
+        {
+            ic++; // Leave the word's place, as for an immediate expression
+            is_valid = FALSE;
+        }
+        else
+        {
+            *word = insert_are((unsigned int)value, ABSOLUTE); // Insert Absolute relocation attribute
+            insert_instructions(*word); // Insert encoded value into instructions array
+        }
+    }
+    else if (is_int_str(opening_bracket)) // Check if string after opening bracket is a valid integer
     {
         *word = (unsigned int)atoi(opening_bracket); // Convert string to integer
         *word = insert_are(*word, ABSOLUTE); // Insert Absolute relocation attribute
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "utils.h"
+#include "segment.h"
+
+/**
+ * Stores a word at an index of the segment. The segment grows by whole chunks,
+ * so words already stored are never copied; only the small array of chunk
+ * pointers is reallocated.
+ * @param seg The segment.
+ * @param index The index of the word.
+ * @param word The word to store.
+ * @return TRUE if the word was stored, FALSE if memory allocation failed.
+ */
+int segment_store(wordSegment *seg, unsigned int index, unsigned int word)
+{
+    int chunk = (int)(index >> SEGMENT_CHUNK_BITS); // The chunk holding the word
+    unsigned int **chunks;
+    unsigned int *words;
+    int capacity;
+
+    while (chunk >= seg->chunk_count)
+    {
+        // Make room for more chunk pointers
+        if (seg->chunk_count == seg->chunk_capacity)
+        {
+            capacity = seg->chunk_capacity ? seg->chunk_capacity * 2 : SEGMENT_INITIAL_CHUNKS;
+            chunks = (unsigned int **)checkedAlloc((long)capacity * sizeof(unsigned int *));
+            if (chunks == NULL)
+                return FALSE;
+            if (seg->chunk_count)
+                memcpy(chunks, seg->chunks, seg->chunk_count * sizeof(unsigned int *));
+            free(seg->chunks);
+            seg->chunks = chunks;
+            seg->chunk_capacity = capacity;
+        }
+
+        // Words that are skipped over read as zero
+        words = (unsigned int *)checkedAlloc(SEGMENT_CHUNK_WORDS * sizeof(unsigned int));
+        if (words == NULL)
+            return FALSE;
+        memset(words, 0, SEGMENT_CHUNK_WORDS * sizeof(unsigned int));
+        seg->chunks[seg->chunk_count++] = words;
+    }
+
+    seg->chunks[chunk][index & (SEGMENT_CHUNK_WORDS - 1)] = word;
+    return TRUE;
+}
+
+/**
+ * Returns the word at an index of the segment.
+ * @param seg The segment.
+ * @param index The index of the word.
+ * @return The word, or 0 if nothing was stored that far.
+ */
+unsigned int segment_load(wordSegment *seg, unsigned int index)
+{
+    int chunk = (int)(index >> SEGMENT_CHUNK_BITS);
+
+    if (chunk >= seg->chunk_count)
+        return 0;
+    return seg->chunks[chunk][index & (SEGMENT_CHUNK_WORDS - 1)];
+}
+
+/**
+ * Frees the memory held by a segment.
+ * @param seg The segment to reset.
+ */
+void reset_segment(wordSegment *seg)
+{
+    int i;
+
+    for (i = 0; i < seg->chunk_count; i++)
+        free(seg->chunks[i]);
+    free(seg->chunks);
+    seg->chunks = NULL;
+    seg->chunk_count = 0;
+    seg->chunk_capacity = 0;
+}
@@ -0,0 +1,432 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "vars.h"
+#include "utils.h"
+#include "writeFiles.h"
+
+#define REQUEST_DELIMITERS " \t\r\n" // Characters separating the words of a request
+
+typedef struct serverWorker
+{
+    int listener;        // The listening socket, shared by all workers
+    asmOptions *options; // The options the server was started with
+} serverWorker;          // Definition of what a socket worker thread needs
+
+/**
+ * Reads a command-line flag of a request into the options.
+ * @param word The word of the request.
+ * @param options The options of the request.
+ * @return TRUE if the word is a known flag, FALSE otherwise.
+ */
+static int read_flag(char *word, asmOptions *options)
+{
+    if (strcmp(word, "--emit-am") == 0)
+        options->emit_am = TRUE;
+    else if (strcmp(word, "--one-pass") == 0)
+        options->one_pass = TRUE;
+    else if (strcmp(word, "--stats") == 0)
+        options->stats = TRUE;
+    else if (strcmp(word, "--large-memory") == 0)
+        options->large_memory = TRUE;
+    else if (strcmp(word, "-O") == 0)
+        options->optimize = TRUE;
+    else if (strcmp(word, "--pool-strings") == 0)
+        options->pool_strings = TRUE;
+    else
+        return FALSE;
+    return TRUE;
+}
+
+/**
+ * Writes collected text to the reply, one prefixed line per line of text.
+ * @param reply The reply stream.
+ * @param prefix The word starting every line.
+ * @param text The text.
+ * @param size The length of the text.
+ */
+static void reply_lines(FILE *reply, char *prefix, char *text, size_t size)
+{
+    char *end = text + size;
+    char *next;
+
+    while (text < end)
+    {
+        next = memchr(text, '\n', end - text);
+        if (next == NULL)
+            next = end;
+        fprintf(reply, "%s %.*s\n", prefix, (int)(next - text), text);
+        text = next + 1;
+    }
+}
+
+/**
+ * Assembles one file of a request with the current thread's context and answers it.
+ * The context is recycled first, so the tables and memory of the previous job are reused.
+ * @param name The name of the file, without extension.
+ * @param source The source to assemble, or NULL to read name.as.
+ * @param options The options of the request.
+ * @param reply The reply stream.
+ */
+static void run_job(char *name, FILE *source, asmOptions *options, FILE *reply)
+{
+    char *out_text = NULL, *diag_text = NULL; // Progress and error messages of the job
+    size_t out_size = 0, diag_size = 0;
+    FILE *out = open_memstream(&out_text, &out_size);
+    FILE *diag = open_memstream(&diag_text, &diag_size);
+    int opened = TRUE; // Flag indicating the source could be read
+    int ok;
+
+    fprintf(reply, "file %s\n", name);
+    if (out == NULL || diag == NULL)
+    {
+        fprintf(reply, "diag Fatal error: Memory allocation failed.\nstatus failed\n");
+        if (out != NULL)
+            fclose(out);
+        if (diag != NULL)
+            fclose(diag);
+        free(out_text);
+        free(diag_text);
+        return;
+    }
+
+    recycle_context(context, out, diag);
+    if (source == NULL)
+        opened = assemble_file(name, options);
+    else
+        assemble_source(name, source, options);
+    fclose(out);
+    fclose(diag);
+    ok = opened && !has_error;
+
+    // Report the messages and the files the job wrote, in the order they were written
+    reply_lines(reply, "diag", diag_text, diag_size);
+    if (opened && options->emit_am)
+        fprintf(reply, "output %s\n", create_file_name(name, AM_FILE));
+    if (ok)
+    {
+        fprintf(reply, "output %s\n", create_file_name(name, OB_FILE));
+        if (has_entry)
+            fprintf(reply, "output %s\n", create_file_name(name, ENT_FILE));
+        if (has_external)
+            fprintf(reply, "output %s\n", create_file_name(name, EXT_FILE));
+    }
+    if (opened && options->stats)
+        fprintf(reply, "output %s\n", create_file_name(name, STATS_FILE));
+    fprintf(reply, "status %s\n", ok ? "ok" : "failed");
+
+    free(out_text);
+    free(diag_text);
+}
+
+/**
+ * Reads and drops the source bytes of a "source" request that is refused, so they
+ * are not taken for requests.
+ * @param in The request stream.
+ * @param length The number of bytes.
+ * @return TRUE if the bytes were read, FALSE if the stream ended first.
+ */
+static int skip_source(FILE *in, long length)
+{
+    char buffer[4096];
+    size_t chunk;
+
+    while (length > 0)
+    {
+        chunk = length < (long)sizeof(buffer) ? (size_t)length : sizeof(buffer);
+        if (fread(buffer, 1, chunk, in) != chunk)
+            return FALSE;
+        length -= (long)chunk;
+    }
+    return TRUE;
+}
+
+/**
+ * Answers a "source" request: reads the source bytes that follow the request line
+ * and assembles them. The length is the request's last word; a request refused for
+ * another reason still has its bytes read, so the connection stays in step.
+ * @param in The request stream.
+ * @param reply The reply stream.
+ * @param words The words of the request after "source": the name and the length.
+ * @param count The number of words.
+ * @param options The options of the request.
+ * @param bad_flag Flag indicating the request has a flag that is not known.
+ * @return TRUE if the source was read, FALSE if the stream ended first or the
+ *         length cannot be read, in which case the connection is given up.
+ */
+static int source_request(FILE *in, FILE *reply, char **words, int count, asmOptions *options, int bad_flag)
+{
+    char *end;
+    long length;
+    char *text;
+    FILE *source;
+
+    // Without a length the end of the source cannot be found
+    errno = 0;
+    length = count > 0 ? strtol(words[count - 1], &end, 10) : -1;
+    if (count == 0 || *end != '\0' || errno == ERANGE || length < 0)
+    {
+        fprintf(reply, "error invalid source length\n");
+        return FALSE;
+    }
+
+    if (bad_flag)
+    {
+        fprintf(reply, "error unknown flag\n");
+        return skip_source(in, length);
+    }
+    if (count != 2)
+    {
+        fprintf(reply, "error source needs a name and a length\n");
+        return skip_source(in, length);
+    }
+    if (length > SERVER_MAX_SOURCE)
+    {
+        fprintf(reply, "error source too large\n");
+        return skip_source(in, length);
+    }
+
+    text = (char *)malloc(length + 1);
+    if (text == NULL)
+    {
+        fprintf(reply, "error source too large\n");
+        return skip_source(in, length); // The bytes are dropped without holding them
+    }
+    if ((long)fread(text, 1, length, in) != length)
+    {
+        free(text);
+        return FALSE;
+    }
+
+    source = length > 0 ? fmemopen(text, length, "r") : fopen("/dev/null", "r");
+    if (source == NULL)
+        fprintf(reply, "error cannot read source\n");
+    else
+    {
+        run_job(words[0], source, options, reply);
+        fclose(source);
+    }
+    free(text);
+    return TRUE;
+}
+
+/**
+ * Answers the requests read from a stream until it ends or a "quit" request,
+ * with the current thread's context.
+ * @param in The request stream.
+ * @param reply The reply stream.
+ * @param defaults The options the server was started with.
+ */
+static void serve_requests(FILE *in, FILE *reply, asmOptions *defaults)
+{
+    char *line = NULL;
+    size_t capacity = 0;
+    char **words = NULL;  // The words of the request that are not flags
+    int words_capacity = 0;
+    int count, i;
+    char *word, *state;
+    char *command;
+    asmOptions options;
+    int bad_flag;
+
+    while (getline(&line, &capacity, in) != -1)
+    {
+        command = strtok_r(line, REQUEST_DELIMITERS, &state);
+        if (command == NULL)
+            continue;
+        if (strcmp(command, "quit") == 0)
+            break;
+        if (strcmp(command, "ping") == 0)
+        {
+            fprintf(reply, "pong\n");
+            fflush(reply);
+            continue;
+        }
+
+        // Separate the flags from the other words
+        options = *defaults;
+        bad_flag = FALSE;
+        count = 0;
+        while ((word = strtok_r(NULL, REQUEST_DELIMITERS, &state)) != NULL)
+        {
+            if (word[0] == '-') // Flags are spelled as on the command line, -O included
+            {
+                bad_flag |= !read_flag(word, &options);
+                continue;
+            }
+            if (count == words_capacity)
+            {
+                words_capacity = words_capacity ? words_capacity * 2 : 16;
+                words = (char **)realloc(words, words_capacity * sizeof(char *));
+                if (words == NULL)
+                {
+                    fprintf(stderr, "Fatal error: Memory allocation failed.\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            words[count++] = word;
+        }
+
+        if (strcmp(command, "source") == 0)
+        {
+            if (!source_request(in, reply, words, count, &options, bad_flag))
+                break;
+        }
+        else if (bad_flag)
+            fprintf(reply, "error unknown flag\n");
+        else if (strcmp(command, "assemble") == 0)
+        {
+            if (count == 0)
+                fprintf(reply, "error assemble needs at least one name\n");
+            for (i = 0; i < count; i++)
+                run_job(words[i], NULL, &options, reply);
+        }
+        else
+            fprintf(reply, "error unknown request\n");
+        fprintf(reply, "done\n");
+        fflush(reply);
+    }
+
+    free(words);
+    free(line);
+}
+
+/**
+ * Answers the requests read from a stream, for example a pipe from a build tool,
+ * until it ends or a "quit" request.
+ * @param in The request stream.
+ * @param out The reply stream.
+ * @param defaults The options the server was started with.
+ * @return TRUE if the requests were served, FALSE if memory allocation failed.
+ */
+int serve_stream(FILE *in, FILE *out, asmOptions *defaults)
+{
+    context = create_context(NULL, NULL);
+    if (context == NULL)
+        return FALSE;
+    serve_requests(in, out, defaults);
+    free_context(context);
+    context = NULL;
+    return TRUE;
+}
+
+/**
+ * Socket worker: accepts connections one at a time and answers their requests,
+ * keeping one context for all of them.
+ * @param arg The worker's serverWorker.
+ * @return Always NULL.
+ */
+static void *socket_worker(void *arg)
+{
+    serverWorker *worker = (serverWorker *)arg;
+    FILE *in, *out;
+    int fd, copy;
+
+    context = create_context(NULL, NULL);
+    if (context == NULL)
+        return NULL;
+
+    for (;;)
+    {
+        fd = accept(worker->listener, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror("accept");
+            break;
+        }
+
+        // Separate streams for reading and writing the same socket
+        copy = dup(fd);
+        in = fdopen(fd, "r");
+        out = copy < 0 ? NULL : fdopen(copy, "w");
+        if (in == NULL || out == NULL)
+        {
+            if (in != NULL)
+                fclose(in);
+            else
+                close(fd);
+            if (copy >= 0)
+                close(copy);
+            continue;
+        }
+
+        serve_requests(in, out, worker->options);
+        fclose(in);
+        fclose(out);
+    }
+
+    free_context(context);
+    context = NULL;
+    return NULL;
+}
+
+/**
+ * Listens on a Unix domain socket and answers its connections on a number of worker
+ * threads, each with its own context. A socket file left at the path is replaced.
+ * Returns only if the socket cannot be set up or stops accepting connections.
+ * @param path The path of the socket.
+ * @param threads The number of worker threads.
+ * @param defaults The options the server was started with.
+ * @return FALSE, after printing the reason.
+ */
+int serve_socket(char *path, int threads, asmOptions *defaults)
+{
+    struct sockaddr_un address;
+    serverWorker worker;
+    pthread_t *workers;
+    int i, started;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Error: Socket path is too long.\n");
+        return FALSE;
+    }
+
+    worker.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (worker.listener < 0)
+    {
+        perror("socket");
+        return FALSE;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (bind(worker.listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(worker.listener, SERVER_BACKLOG) != 0)
+    {
+        perror(path);
+        close(worker.listener);
+        return FALSE;
+    }
+    worker.options = defaults;
+    signal(SIGPIPE, SIG_IGN); // A client that goes away must not stop the server
+
+    // The calling thread is one of the workers
+    workers = (pthread_t *)malloc((threads > 1 ? threads - 1 : 1) * sizeof(pthread_t));
+    started = 0;
+    if (workers != NULL)
+        for (; started < threads - 1; started++)
+            if (pthread_create(&workers[started], NULL, socket_worker, &worker) != 0)
+                break;
+    socket_worker(&worker);
+
+    // Wake the workers still waiting in accept
+    shutdown(worker.listener, SHUT_RDWR);
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    free(workers);
+    close(worker.listener);
+    unlink(path);
+    return FALSE;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#include "sourceBuffer.h"
+#include "lineScanner.h"
+
+/**
+ * Initializes an empty source buffer. Memory is only allocated once lines are appended.
+ * @param src The source buffer to initialize.
+ */
+void initSource(sourceBuffer *src)
+{
+    src->text = NULL;
+    src->lines = NULL;
+    src->length = src->capacity = 0;
+    src->line_count = src->line_capacity = 0;
+    src->allocations = 0;
+}
+
+/**
+ * Makes room for more text and line offsets in the source buffer.
+ * The buffers grow geometrically so appending is amortized O(length of the text).
+ * SCAN_PADDING bytes are kept free after the text for the line scanner.
+ * @param src The source buffer.
+ * @param text_size The number of bytes that are about to be appended.
+ * @param line_count The number of lines that are about to be appended.
+ */
+static void reserve_source(sourceBuffer *src, long text_size, int line_count)
+{
+    // Grow the text buffer if the text does not fit
+    if (src->length + text_size + SCAN_PADDING > src->capacity)
+    {
+        if (src->capacity == 0)
+            src->capacity = SOURCE_INITIAL_TEXT;
+        while (src->length + text_size + SCAN_PADDING > src->capacity)
+            src->capacity *= 2;
+        src->text = (char *)realloc(src->text, src->capacity);
+        src->allocations++;
+        if (src->text == NULL)
+        {
+            fprintf(stderr, "Memory allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Grow the line offsets array if the lines do not fit
+    if (src->line_count + line_count > src->line_capacity)
+    {
+        if (src->line_capacity == 0)
+            src->line_capacity = SOURCE_INITIAL_LINES;
+        while (src->line_count + line_count > src->line_capacity)
+            src->line_capacity *= 2;
+        src->lines = (long *)realloc(src->lines, src->line_capacity * sizeof(long));
+        src->allocations++;
+        if (src->lines == NULL)
+        {
+            fprintf(stderr, "Memory allocation error\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+/**
+ * Appends a copy of a line to the source buffer.
+ * @param src The source buffer.
+ * @param line The line to append, which need not be null-terminated.
+ * @param length The number of characters in the line.
+ */
+void append_line(sourceBuffer *src, char *line, int length)
+{
+    reserve_source(src, length + 1, 1);
+
+    src->lines[src->line_count++] = src->length;   // Remember where the line starts
+    memcpy(&src->text[src->length], line, length); // Copy the line and terminate it
+    src->text[src->length + length] = '\0';
+    src->length += length + 1;
+}
+
+/**
+ * Appends all lines of one source buffer to another with a single copy of the text.
+ * @param src The source buffer to append to.
+ * @param other The source buffer whose lines are appended.
+ */
+void append_source(sourceBuffer *src, sourceBuffer *other)
+{
+    int i;
+
+    if (other->line_count == 0)
+        return; // Nothing to append
+
+    reserve_source(src, other->length, other->line_count);
+
+    // Copy the line offsets, moved to where the text is placed
+    for (i = 0; i < other->line_count; i++)
+        src->lines[src->line_count++] = src->length + other->lines[i];
+
+    memcpy(&src->text[src->length], other->text, other->length); // Copy all the text at once
+    src->length += other->length;
+}
+
+/**
+ * Returns the line at the given position.
+ * @param src The source buffer.
+ * @param line_num The 0 based line position.
+ * @return A pointer to the null-terminated line, or NULL if out of range.
+ */
+char *get_line(sourceBuffer *src, int line_num)
+{
+    if (line_num < 0 || line_num >= src->line_count)
+        return NULL;
+    return &src->text[src->lines[line_num]];
+}
+
+/**
+ * Writes the whole source buffer to a file.
+ * @param src The source buffer.
+ * @param fp Pointer to the output file.
+ * @return TRUE if every line was written, FALSE otherwise.
+ */
+int write_source(sourceBuffer *src, FILE *fp)
+{
+    int i;
+    for (i = 0; i < src->line_count; i++)
+    {
+        if (fputs(get_line(src, i), fp) == EOF)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Frees the memory held by the source buffer.
+ * @param src The source buffer to reset.
+ */
+void resetSource(sourceBuffer *src)
+{
+    free(src->text);
+    free(src->lines);
+    initSource(src);
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "statementTable.h"
+#include "vars.h"
+
+/**
+ * Appends a copy of a statement to the table, growing it when it is full.
+ * @param table Pointer to the statement table.
+ * @param item The statement to append.
+ * @return TRUE if the statement was appended, FALSE if memory allocation failed.
+ */
+int add_statement(statementTable *table, statement *item)
+{
+    statement *items;
+
+    // Double the table's size when it is full
+    if (table->count == table->capacity)
+    {
+        items = (statement *)checkedAlloc((long)(table->capacity ? table->capacity * 2 : STATEMENTS_INITIAL_SIZE) * sizeof(statement));
+        if (items == NULL)
+        {
+            err = FAILED_TO_ALLOCATE_MEMORY;
+            return FALSE;
+        }
+        if (table->count)
+            memcpy(items, table->items, table->count * sizeof(statement));
+        free(table->items);
+        table->items = items;
+        table->capacity = table->capacity ? table->capacity * 2 : STATEMENTS_INITIAL_SIZE;
+    }
+
+    table->items[table->count++] = *item; // Copy the statement to the end of the table
+    return TRUE;
+}
+
+/**
+ * Copies an operand's text into a null-terminated buffer.
+ * @param span The operand to copy.
+ * @param buffer The buffer to copy into, at least LINESIZE + 1 characters long.
+ */
+void span_copy(operandSpan *span, char *buffer)
+{
+    memcpy(buffer, span->start, span->length);
+    buffer[span->length] = '\0';
+}
+
+/**
+ * Resets the statement table by freeing its memory.
+ * @param table Pointer to the statement table.
+ */
+void reset_statements(statementTable *table)
+{
+    free(table->items);
+    table->items = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "stats.h"
+
+static const char *phase_names[PHASE_COUNT] = {"preAssembler", "first_pass", "second_pass", "write_output_files"};
+
+/**
+ * Reads the wall clock and the CPU clock of the calling thread.
+ * @param now Receives the clock readings, in seconds.
+ */
+static void read_clocks(phaseTime *now)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now->wall = ts.tv_sec + ts.tv_nsec / 1e9;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    now->cpu = ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Starts timing a phase.
+ * @param stats The statistics of the file being assembled.
+ */
+void start_phase(asmStats *stats)
+{
+    read_clocks(&stats->started);
+}
+
+/**
+ * Adds the time passed since start_phase to a phase.
+ * @param stats The statistics of the file being assembled.
+ * @param p The phase that ended.
+ */
+void end_phase(asmStats *stats, phase p)
+{
+    phaseTime now;
+    struct rusage usage;
+
+    read_clocks(&now);
+    stats->phases[p].wall += now.wall - stats->started.wall;
+    stats->phases[p].cpu += now.cpu - stats->started.cpu;
+
+    // The peak is of the whole process, so with -j it includes the other files
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        stats->peak_rss[p] = usage.ru_maxrss;
+}
+
+/**
+ * Writes a string as a JSON string literal.
+ * @param fp The stream to write to.
+ * @param str The string to write.
+ */
+static void print_json_string(FILE *fp, char *str)
+{
+    fputc('"', fp);
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            fprintf(fp, "\\%c", *str);
+        else if ((unsigned char)*str < ' ')
+            fprintf(fp, "\\u%04x", (unsigned char)*str);
+        else
+            fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+/**
+ * Prints the statistics of a file as a table.
+ * @param fp The stream to write to.
+ * @param filename The name of the assembled file.
+ * @param stats The statistics of the file.
+ */
+void print_stats(FILE *fp, char *filename, asmStats *stats)
+{
+    double avg_probes = stats->symbol_lookups ? (double)stats->symbol_probes / stats->symbol_lookups : 0;
+    int i;
+
+    fprintf(fp, "************* Statistics for %s *************\n\n", filename);
+    fprintf(fp, "%-20s %12s %12s %14s\n", "phase", "wall ms", "cpu ms", "peak rss KB");
+    for (i = 0; i < PHASE_COUNT; i++)
+        fprintf(fp, "%-20s %12.3f %12.3f %14ld\n", phase_names[i], stats->phases[i].wall * 1e3, stats->phases[i].cpu * 1e3,
+                stats->peak_rss[i]);
+    fprintf(fp, "lines read:          %ld\n", stats->lines_read);
+    fprintf(fp, "macro expansions:    %ld\n", stats->macro_expansions);
+    fprintf(fp, "symbol lookups:      %ld (average probe length %.2f)\n", stats->symbol_lookups, avg_probes);
+    fprintf(fp, "macro lookups:       %ld (%ld filtered, average probe length %.2f)\n", stats->macro_lookups,
+            stats->macro_filtered, stats->macro_avg_probes);
+    fprintf(fp, "macro table:         %ld macros in %ld buckets (longest chain %ld, average %.2f)\n", stats->macros,
+            stats->macro_buckets, stats->macro_max_chain, stats->macro_avg_chain);
+    fprintf(fp, "words emitted:       %ld\n", stats->words_emitted);
+    fprintf(fp, "words optimized out: %ld\n", stats->words_optimized);
+    fprintf(fp, "pooled strings:      %ld (%ld data words saved)\n", stats->strings_pooled, stats->data_words_pooled);
+    fprintf(fp, "interned names:      %ld (%ld bytes), %ld uses shared a copy (%ld bytes saved)\n", stats->names,
+            stats->name_bytes, stats->shared_names, stats->shared_name_bytes);
+    fprintf(fp, "arena allocations:   %ld (%ld bytes in %ld blocks)\n\n", stats->allocations, stats->allocated_bytes,
+            stats->system_allocations);
+}
+
+/**
+ * Writes the statistics of a file as a JSON object, for tools that collect them.
+ * @param fp The stream to write to.
+ * @param filename The name of the assembled file.
+ * @param stats The statistics of the file.
+ */
+void write_stats(FILE *fp, char *filename, asmStats *stats)
+{
+    double avg_probes = stats->symbol_lookups ? (double)stats->symbol_probes / stats->symbol_lookups : 0;
+    int i;
+
+    fprintf(fp, "{\n  \"file\": ");
+    print_json_string(fp, filename);
+    fprintf(fp, ",\n  \"phases\": {\n");
+    for (i = 0; i < PHASE_COUNT; i++)
+        fprintf(fp, "    \"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_kb\": %ld}%s\n", phase_names[i],
+                stats->phases[i].wall * 1e3, stats->phases[i].cpu * 1e3, stats->peak_rss[i], i < PHASE_COUNT - 1 ? "," : "");
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"lines_read\": %ld,\n", stats->lines_read);
+    fprintf(fp, "  \"macro_expansions\": %ld,\n", stats->macro_expansions);
+    fprintf(fp, "  \"symbol_lookups\": %ld,\n", stats->symbol_lookups);
+    fprintf(fp, "  \"avg_probe_length\": %.3f,\n", avg_probes);
+    fprintf(fp, "  \"macro_lookups\": %ld,\n", stats->macro_lookups);
+    fprintf(fp, "  \"macro_lookups_filtered\": %ld,\n", stats->macro_filtered);
+    fprintf(fp, "  \"macro_avg_probe_length\": %.3f,\n", stats->macro_avg_probes);
+    fprintf(fp, "  \"macros\": %ld,\n", stats->macros);
+    fprintf(fp, "  \"macro_buckets\": %ld,\n", stats->macro_buckets);
+    fprintf(fp, "  \"macro_max_chain\": %ld,\n", stats->macro_max_chain);
+    fprintf(fp, "  \"macro_avg_chain\": %.3f,\n", stats->macro_avg_chain);
+    fprintf(fp, "  \"words_emitted\": %ld,\n", stats->words_emitted);
+    fprintf(fp, "  \"words_optimized\": %ld,\n", stats->words_optimized);
+    fprintf(fp, "  \"strings_pooled\": %ld,\n", stats->strings_pooled);
+    fprintf(fp, "  \"data_words_pooled\": %ld,\n", stats->data_words_pooled);
+    fprintf(fp, "  \"interned_names\": %ld,\n", stats->names);
+    fprintf(fp, "  \"interned_name_bytes\": %ld,\n", stats->name_bytes);
+    fprintf(fp, "  \"shared_names\": %ld,\n", stats->shared_names);
+    fprintf(fp, "  \"shared_name_bytes\": %ld,\n", stats->shared_name_bytes);
+    fprintf(fp, "  \"arena_allocations\": %ld,\n", stats->allocations);
+    fprintf(fp, "  \"arena_bytes\": %ld,\n", stats->allocated_bytes);
+    fprintf(fp, "  \"arena_blocks\": %ld\n}\n", stats->system_allocations);
+}
@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+#include "globals.h"
+#include "stringPool.h"
+
+/**
+ * Records a literal just stored in the data image.
+ * @param pool The pool.
+ * @param address Position in the data image of the literal's first word.
+ * @param length Number of words of the literal, the null terminator included.
+ * @return TRUE on success, FALSE if memory allocation failed (the literal keeps its storage).
+ */
+int add_string(stringPool *pool, int address, int length)
+{
+    pooledString *items;
+    int capacity;
+
+    if (pool->count == pool->capacity)
+    {
+        capacity = pool->capacity ? pool->capacity * 2 : STRING_POOL_INITIAL_SIZE;
+        items = (pooledString *)realloc(pool->items, capacity * sizeof(pooledString));
+        if (items == NULL)
+            return FALSE;
+        pool->items = items;
+        pool->capacity = capacity;
+    }
+    pool->items[pool->count].address = address;
+    pool->items[pool->count].length = length;
+    pool->items[pool->count].shared = -1;
+    pool->count++;
+    return TRUE;
+}
+
+/**
+ * Compares two literals by their text read backwards. A literal that ends another
+ * one sorts before it; of two equal literals the later one sorts first.
+ * @param seg The data image.
+ * @param a The first literal.
+ * @param b The second literal.
+ * @return A negative number if a sorts first, a positive one if b does.
+ */
+static int compare_reversed(wordSegment *seg, pooledString *a, pooledString *b)
+{
+    unsigned int x, y;
+    int i;
+
+    for (i = 1; i <= a->length && i <= b->length; i++)
+    {
+        x = segment_load(seg, a->address + a->length - i);
+        y = segment_load(seg, b->address + b->length - i);
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+    return a->length != b->length ? a->length - b->length : b->address - a->address;
+}
+
+/**
+ * Sorts the positions of literals by their reversed text (merge sort, so the
+ * order does not depend on the input's order).
+ * @param pool The pool.
+ * @param seg The data image.
+ * @param order The positions to sort.
+ * @param buffer Room for as many positions.
+ * @param count Number of positions.
+ */
+static void sort_reversed(stringPool *pool, wordSegment *seg, int *order, int *buffer, int count)
+{
+    int half = count / 2, i = 0, j = half, k = 0;
+
+    if (count < 2)
+        return;
+    sort_reversed(pool, seg, order, buffer, half);
+    sort_reversed(pool, seg, order + half, buffer, count - half);
+
+    while (i < half && j < count)
+    {
+        if (compare_reversed(seg, &pool->items[order[j]], &pool->items[order[i]]) < 0)
+            buffer[k++] = order[j++];
+        else
+            buffer[k++] = order[i++];
+    }
+    while (i < half)
+        buffer[k++] = order[i++];
+    while (j < count)
+        buffer[k++] = order[j++];
+    memcpy(order, buffer, count * sizeof(int));
+}
+
+/**
+ * Tells if a literal is the end of another one.
+ * @param seg The data image.
+ * @param tail The shorter literal.
+ * @param whole The longer literal.
+ * @return TRUE if the last words of whole are the words of tail, FALSE otherwise.
+ */
+static int ends(wordSegment *seg, pooledString *tail, pooledString *whole)
+{
+    int i;
+
+    if (tail->length > whole->length)
+        return FALSE;
+    for (i = 1; i <= tail->length; i++)
+    {
+        if (segment_load(seg, tail->address + tail->length - i) != segment_load(seg, whole->address + whole->length - i))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Drops every literal that equals or ends another one and lets it share the end
+ * of the longer one, then moves the remaining words of the data image down.
+ * Sorted by reversed text, a literal that ends others comes right before them,
+ * so only neighbours are compared; the last literal of such a run keeps its words.
+ * @param pool The literals of the data image.
+ * @param seg The data image.
+ * @param size Number of words of the data image.
+ * @param moved Receives the new position of every word of the image and of its end (size + 1 entries).
+ * @return The new number of words, or -1 if memory allocation failed (the image is left as it is).
+ */
+int merge_strings(stringPool *pool, wordSegment *seg, int size, int *moved)
+{
+    int *order = (int *)malloc((pool->count + 1) * sizeof(int));
+    int *buffer = (int *)malloc((pool->count + 1) * sizeof(int));
+    pooledString *tail, *whole, *item;
+    int i, j, next = 0, position = 0;
+
+    pool->merged = pool->merged_words = 0;
+    if (order == NULL || buffer == NULL)
+    {
+        free(order);
+        free(buffer);
+        return -1;
+    }
+    for (i = 0; i < pool->count; i++)
+        order[i] = i;
+    sort_reversed(pool, seg, order, buffer, pool->count);
+
+    // A literal that ends the next one shares the words that one ends up at
+    for (i = pool->count - 2; i >= 0; i--)
+    {
+        tail = &pool->items[order[i]];
+        whole = &pool->items[order[i + 1]];
+        if (!ends(seg, tail, whole))
+            continue;
+        tail->shared = (whole->shared >= 0 ? whole->shared : whole->address) + whole->length - tail->length;
+        pool->merged++;
+        pool->merged_words += tail->length;
+    }
+    free(order);
+    free(buffer);
+
+    // Move the words that stay down, skipping the literals that were dropped
+    for (i = 0; i < size;)
+    {
+        if (next < pool->count && pool->items[next].address == i)
+        {
+            item = &pool->items[next++];
+            if (item->shared >= 0)
+            {
+                i += item->length;
+                continue;
+            }
+        }
+        moved[i] = position;
+        segment_store(seg, position++, segment_load(seg, i));
+        i++;
+    }
+    moved[size] = position;
+
+    // The words of a dropped literal are where the words it shares went
+    for (i = 0; i < pool->count; i++)
+    {
+        item = &pool->items[i];
+        for (j = 0; item->shared >= 0 && j < item->length; j++)
+            moved[item->address + j] = moved[item->shared + j];
+    }
+    return position;
+}
+
+/**
+ * Empties the pool for the next file, keeping its memory.
+ * @param pool The pool.
+ */
+void clear_string_pool(stringPool *pool)
+{
+    pool->count = 0;
+    pool->merged = pool->merged_words = 0;
+}
+
+/**
+ * Frees the memory held by the pool.
+ * @param pool The pool.
+ */
+void reset_string_pool(stringPool *pool)
+{
+    free(pool->items);
+    pool->items = NULL;
+    pool->capacity = 0;
+    clear_string_pool(pool);
+}
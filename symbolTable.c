@@ -4,6 +4,104 @@
 #include <string.h>
 #include "utils.h"
 #include "globals.h"
+#include "vars.h"
+
+/**
+ * Places a symbol in the first free slot of its probe sequence, replacing a symbol with the same name.
+ * @param slots The slots array.
+ * @param capacity The number of slots (a power of 2).
+ * @param symbol The symbol to place.
+ * @return TRUE if a free slot was used, FALSE if an existing symbol was replaced.
+ */
+static int index_place(Symbol **slots, unsigned int capacity, Symbol *symbol)
+{
+    unsigned int i = symbol->hash & (capacity - 1);
+    while (slots[i] != NULL)
+    {
+        // A newer symbol with the same name hides the older one, like the head of the list does
+        if (slots[i]->id == symbol->id)
+        {
+            slots[i] = symbol;
+            return FALSE;
+        }
+        i = (i + 1) & (capacity - 1); // Linear probing
+    }
+    slots[i] = symbol;
+    return TRUE;
+}
+
+/**
+ * Resizes the hash index to the given number of slots and reinserts all indexed symbols.
+ * @param capacity The new number of slots (a power of 2).
+ * @return TRUE if the index was resized, FALSE if memory allocation failed.
+ */
+static int index_resize(unsigned int capacity)
+{
+    unsigned int i;
+    Symbol **slots = (Symbol **)checkedAlloc(capacity * sizeof(Symbol *));
+    if (slots == NULL)
+        return FALSE;
+    memset(slots, 0, capacity * sizeof(Symbol *));
+
+    // Reinsert every symbol using its cached hash
+    for (i = 0; i < symbol_index.capacity; i++)
+    {
+        if (symbol_index.slots[i] != NULL)
+            index_place(slots, capacity, symbol_index.slots[i]);
+    }
+
+    free(symbol_index.slots);
+    symbol_index.slots = slots;
+    symbol_index.capacity = capacity;
+    return TRUE;
+}
+
+/**
+ * Adds a symbol to the hash index, growing it when the load factor passes 1/2.
+ * The index is bound to the first symbol table it is used with; other tables are scanned linearly.
+ * @param head Pointer to the pointer to the head of the symbol table.
+ * @param symbol The symbol to index.
+ */
+static void index_add(Symbol **head, Symbol *symbol)
+{
+    if (symbol_index.head == NULL && !symbol_index.failed)
+        symbol_index.head = head; // Bind the index to this symbol table
+    if (symbol_index.head != head)
+        return;
+
+    // Keep the load factor at most 1/2 so probe sequences stay short
+    if ((symbol_index.count + 1) * 2 > symbol_index.capacity &&
+        !index_resize(symbol_index.capacity ? symbol_index.capacity * 2 : SYMBOL_INDEX_INITIAL_SIZE))
+    {
+        symbol_index.head = NULL; // Fall back to scanning the list if the index cannot grow
+        symbol_index.failed = TRUE;
+        return;
+    }
+
+    if (index_place(symbol_index.slots, symbol_index.capacity, symbol))
+        symbol_index.count++;
+}
+
+/**
+ * Looks a name up in the hash index.
+ * @param id The id of the name of the symbol to find.
+ * @return A pointer to the symbol if found, otherwise NULL.
+ */
+static Symbol *index_lookup(int id)
+{
+    unsigned int i = name_hash(&context->names, id) & (symbol_index.capacity - 1);
+    Symbol *current;
+
+    context->stats.symbol_probes++; // Every slot inspected counts, including the empty one ending a miss
+    while ((current = symbol_index.slots[i]) != NULL)
+    {
+        if (current->id == id)
+            return current;
+        i = (i + 1) & (symbol_index.capacity - 1);
+        context->stats.symbol_probes++;
+    }
+    return NULL;
+}
 
 /**
  * Adds a new symbol entry to the symbol table.
@@ -11,31 +109,36 @@
  * @param name The name of the symbol to add.
  * @param value The value associated with the symbol.
  * @param attr The attribute of the symbol.
+ * @return TRUE if the symbol was added, FALSE if memory allocation failed.
  */
-void addSymbol(Symbol **head, char *name, int value, attribute attr)
+int addSymbol(Symbol **head, char *name, int value, attribute attr)
 {
-    // Allocate memory for a new symbol entry.
-    Symbol *newEntry = (Symbol *)checkedAlloc(sizeof(Symbol));
-    if (newEntry)
+    // Allocate memory for a new symbol entry from the file's arena.
+    Symbol *newEntry = (Symbol *)arenaAlloc(sizeof(Symbol));
+    if (newEntry == NULL)
     {
-        // Allocate memory for the name and copy it.
-        newEntry->name = (char *)checkedAlloc(strlen(name) + 1);
-        if (newEntry->name)
-        {
-            strcpy(newEntry->name, name); // Copy the name to the new symbol entry.
-            newEntry->value = value; // Set the value of the new symbol entry.
-            newEntry->attribute = attr; // Set the attribute of the new symbol entry.
+        err = FAILED_TO_ALLOCATE_MEMORY;
+        return FALSE;
+    }
 
-            // Insert the new entry at the beginning of the list.
-            newEntry->next = *head; // Point the next pointer of the new entry to the current head.
-            *head = newEntry; // Update the head to point to the new entry.
-        }
-        else
-        {
-            // Free the allocated entry if memory allocation fails for the name.
-            free(newEntry);
-        }
+    // Refer to the name in the pool instead of copying it.
+    newEntry->id = intern_name(&context->names, name);
+    if (newEntry->id == NO_NAME)
+    {
+        err = FAILED_TO_ALLOCATE_MEMORY;
+        return FALSE;
     }
+    newEntry->name = name_text(&context->names, newEntry->id); // Share the pool's copy of the name.
+    newEntry->hash = name_hash(&context->names, newEntry->id); // Cache the hash value of the name.
+    newEntry->value = value; // Set the value of the new symbol entry.
+    newEntry->attribute = attr; // Set the attribute of the new symbol entry.
+
+    // Insert the new entry at the beginning of the list.
+    newEntry->next = *head; // Point the next pointer of the new entry to the current head.
+    *head = newEntry; // Update the head to point to the new entry.
+
+    index_add(head, newEntry); // Make the new entry reachable through the hash index.
+    return TRUE;
 }
 
 
@@ -49,12 +152,25 @@ Symbol *findSymbol(Symbol **head, char *name)
 {
     // Start traversing the symbol table from the head.
     Symbol *current = *head;
+    int id = find_name(&context->names, name); // Names never interned cannot be in the table
+
+    context->stats.symbol_lookups++;
+    if (id == NO_NAME)
+    {
+        context->stats.symbol_probes++;
+        return NULL;
+    }
+
+    // Use the hash index if it covers this symbol table.
+    if (head == symbol_index.head)
+        return current == NULL ? NULL : index_lookup(id);
 
     // Iterate through the linked list of symbols.
     while (current != NULL)
     {
+        context->stats.symbol_probes++;
         // Compare the name of the current symbol with the target name.
-        if (strcmp(current->name, name) == 0)
+        if (current->id == id)
         {
             return current; // Symbol found, return pointer to the symbol.
         }
@@ -100,23 +216,9 @@ void offset_data(Symbol **head, int offset)
  */
 int locateSymbol_by_attribute(Symbol **head, char *name, attribute attr)
 {
-    // Start traversing the symbol table from the head.
-    Symbol *current = *head;
-
-    // Iterate through the symbol table until the end is reached.
-    while (current != NULL)
-    {
-        // If the name and attribute of the current symbol match the given name and attribute, return TRUE.
-        if (strcmp(current->name, name) == 0 && current->attribute == attr)
-        {
-            return TRUE;
-        }
-        // Move to the next symbol in the symbol table.
-        current = current->next;
-    }
-
-    // If a symbol with the given name and attribute is not found, return FALSE.
-    return FALSE;
+    // Find the symbol with the given name and compare its attribute.
+    Symbol *symbol = findSymbol(head, name);
+    return symbol != NULL && symbol->attribute == attr;
 }
 
 
@@ -128,23 +230,8 @@ int locateSymbol_by_attribute(Symbol **head, char *name, attribute attr)
  */
 int locateSymbol(Symbol **head, char *name)
 {
-    // Start traversing the symbol table from the head.
-    Symbol *current = *head;
-
-    // Iterate through the symbol table until the end is reached.
-    while (current != NULL)
-    {
-        // If the name of the current symbol matches the given name, return TRUE.
-        if (strcmp(current->name, name) == 0)
-        {
-            return TRUE;
-        }
-        // Move to the next symbol in the symbol table.
-        current = current->next;
-    }
-
-    // If the symbol with the given name is not found, return FALSE.
-    return FALSE;
+    // The symbol exists if it can be found by name.
+    return findSymbol(head, name) != NULL;
 }
 
 
@@ -171,23 +258,23 @@ int change_to_entry(Symbol **head, char *name)
 }
 
 /**
- * Resets the symbol table by freeing memory occupied by all entries.
+ * Resets the symbol table. The entries live in the file's arena and are freed with it.
  * @param head Pointer to the pointer to the head of the symbol table.
  */
 void resetSymbolTable(Symbol **head)
 {
-    // Start traversing the symbol table from the head.
-    Symbol *current = *head;
+    *head = NULL; // Set the head of the symbol table to NULL to indicate an empty table.
 
-    // Iterate through the symbol table.
-    while (current != NULL)
+    // Empty the hash index and release its binding to this symbol table.
+    if (head == symbol_index.head || symbol_index.failed)
     {
-        Symbol *temp = current; // Store the current entry in a temporary variable.
-        current = current->next; // Move to the next entry in the symbol table.
-        free(temp); // Free the memory occupied by the current entry.
+        free(symbol_index.slots);
+        symbol_index.head = NULL;
+        symbol_index.slots = NULL;
+        symbol_index.capacity = 0;
+        symbol_index.count = 0;
+        symbol_index.failed = FALSE;
     }
-
-    *head = NULL; // Set the head of the symbol table to NULL to indicate an empty table.
 }
 
 
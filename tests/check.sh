@@ -0,0 +1,32 @@
+#!/bin/sh
+# Output check.
+# Usage: tests/check.sh [asm binary]
+# Assembles every tests/*.as in a temporary directory, with --emit-am, and
+# compares each .am, .ob, .ent and .ext file it writes byte for byte with the
+# one checked in under tests/. A file written without a checked-in copy, or a
+# checked-in file that is no longer written, is a failure too.
+
+ASM=${1:-./asm}
+DIR=$(mktemp -d)
+STATUS=0
+
+for SOURCE in tests/*.as; do
+    NAME=$(basename "$SOURCE" .as)
+    cp "$SOURCE" "$DIR/"
+    "$ASM" --emit-am "$DIR/$NAME" > /dev/null 2>&1
+    for EXT in am ob ent ext; do
+        if [ ! -f "tests/$NAME.$EXT" ] && [ ! -f "$DIR/$NAME.$EXT" ]; then
+            continue
+        fi
+        if cmp -s "tests/$NAME.$EXT" "$DIR/$NAME.$EXT" 2> /dev/null; then
+            echo "ok   $NAME.$EXT"
+        else
+            echo "FAIL $NAME.$EXT"
+            diff "tests/$NAME.$EXT" "$DIR/$NAME.$EXT" 2>&1 | head -20
+            STATUS=1
+        fi
+    done
+done
+
+rm -rf "$DIR"
+exit $STATUS
@@ -0,0 +1,6 @@
+; a bare mcr line must not take its name from the next line
+mcr
+XYZ
+MAIN: prn #1
+endmcr
+ hlt
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "keywords.h"
+
+/*
+ * Keyword hash generator, run by the build.
+ * Reads the keywords from headers/keywords.def, searches for multipliers that
+ * give every keyword its own slot of KEYWORD_HASH and writes the slot table as
+ * a header (headers/keywordHash.h) to stdout.
+ */
+
+#define MAX_MULTIPLIER 256 // Multipliers are searched in [1, MAX_MULTIPLIER)
+
+typedef struct keywordDef
+{
+    char *name;  // The keyword
+    char *kind;  // Name of its keyword_kind
+    char *code;  // Name of its opcode, instruction or register
+} keywordDef;    // Definition of a keyword as written in keywords.def
+
+#define OPERATION(name, op, operands) {name, "OPERATION_KW", #op},
+#define INSTRUCTION(name, in, attr) {name, "INSTRUCTION_KW", #in},
+#define REGISTER(name, r) {name, "REGISTER_KW", #r},
+static keywordDef keywords[] = {
+#include "keywords.def"
+};
+#undef OPERATION
+#undef INSTRUCTION
+#undef REGISTER
+
+#define KEYWORD_COUNT ((int)(sizeof(keywords) / sizeof(keywords[0])))
+
+/**
+ * Tries a set of multipliers.
+ * @param slots Receives the keyword index of every slot, -1 for empty slots.
+ * @return 1 if every keyword got its own slot, 0 otherwise.
+ */
+static int try_multipliers(unsigned int a, unsigned int b, unsigned int c, int *slots)
+{
+    int i, length;
+    unsigned int slot;
+
+    for (i = 0; i < KEYWORD_SLOTS; i++)
+        slots[i] = -1;
+    for (i = 0; i < KEYWORD_COUNT; i++)
+    {
+        length = (int)strlen(keywords[i].name);
+        slot = KEYWORD_HASH(keywords[i].name, length, a, b, c);
+        if (slots[slot] != -1)
+            return 0;
+        slots[slot] = i;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    int slots[KEYWORD_SLOTS];
+    unsigned int a, b, c;
+    int i, length, min_length = 1000, max_length = 0;
+
+    for (i = 0; i < KEYWORD_COUNT; i++)
+    {
+        length = (int)strlen(keywords[i].name);
+        if (length < min_length)
+            min_length = length;
+        if (length > max_length)
+            max_length = length;
+    }
+    if (min_length < 2)
+    {
+        fprintf(stderr, "genKeywords: keywords must be at least 2 characters long\n");
+        return EXIT_FAILURE;
+    }
+
+    for (a = 1; a < MAX_MULTIPLIER; a++)
+        for (b = 1; b < MAX_MULTIPLIER; b++)
+            for (c = 1; c < MAX_MULTIPLIER; c++)
+                if (try_multipliers(a, b, c, slots))
+                    goto found;
+    fprintf(stderr, "genKeywords: no perfect hash with %d slots, increase KEYWORD_SLOTS\n", KEYWORD_SLOTS);
+    return EXIT_FAILURE;
+
+found:
+    printf("/* Generated by tools/genKeywords from headers/keywords.def, do not edit. */\n");
+    printf("#ifndef KEYWORDHASH_H\n#define KEYWORDHASH_H\n#include \"keywords.h\"\n\n");
+    printf("#define KEYWORD_MIN_LENGTH %d // Length of the shortest keyword\n", min_length);
+    printf("#define KEYWORD_MAX_LENGTH %d // Length of the longest keyword\n", max_length);
+    printf("#define KEYWORD_SLOT(name, length) KEYWORD_HASH(name, length, %uu, %uu, %uu)\n\n", a, b, c);
+    printf("static const keywordEntry keywordSlots[KEYWORD_SLOTS] = {\n");
+    for (i = 0; i < KEYWORD_SLOTS; i++)
+    {
+        if (slots[i] == -1)
+            printf("    {NULL, 0, NOT_KEYWORD, 0},\n");
+        else
+            printf("    {\"%s\", %d, %s, %s},\n", keywords[slots[i]].name, (int)strlen(keywords[slots[i]].name),
+                   keywords[slots[i]].kind, keywords[slots[i]].code);
+    }
+    printf("};\n\n#endif // KEYWORDHASH_H\n");
+    return EXIT_SUCCESS;
+}
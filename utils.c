@@ -3,10 +3,12 @@
 #include <ctype.h>
 #include <math.h>
 #include "utils.h"
+#include "keywordHash.h"
 #include "vars.h"
 
 /**
- * Lookup table for opcode operations.
+ * Lookup table for opcode operations, indexed by opcode. Built, like the keyword
+ * hash generated by tools/genKeywords, from the definitions in keywords.def.
  */
 struct operationLookupItem
 {
@@ -14,61 +16,16 @@ struct operationLookupItem
 	opcode operation; // Corresponding opcode
 	int operands;	  // Number of operands
 } operationLookupTable[] = {
-	{"mov", MOV_OP, 2}, // Move operation
-	{"cmp", CMP_OP, 2}, // Compare operation
-	{"add", ADD_OP, 2}, // Add operation
-	{"sub", SUB_OP, 2}, // Subtract operation
-	{"not", NOT_OP, 1}, // Not operation
-	{"clr", CLR_OP, 1}, // Clear operation
-	{"lea", LEA_OP, 2}, // Load effective address operation
-	{"inc", INC_OP, 1}, // Increment operation
-	{"dec", DEC_OP, 1}, // Decrement operation
-	{"jmp", JMP_OP, 1}, // Jump operation
-	{"bne", BNE_OP, 1}, // Branch if not equal operation
-	{"red", RED_OP, 1}, // Read operation
-	{"prn", PRN_OP, 1}, // Print operation
-	{"jsr", JSR_OP, 1}, // Jump to subroutine operation
-	{"rts", RTS_OP, 0}, // Return from subroutine operation
-	{"hlt", HLT_OP, 0}, // Halt operation
+#define OPERATION(name, op, operands) {name, op, operands},
+#define INSTRUCTION(name, in, attr)
+#define REGISTER(name, r)
+#include "keywords.def"
+#undef OPERATION
+#undef INSTRUCTION
+#undef REGISTER
 	{NULL, NONE_OP, 0}, // End of table marker
 };
 
-/**
- * Lookup table for assembler instructions.
- */
-struct instructionLookupItem
-{
-	char *name;				 // Instruction name
-	instruction instruction; // Corresponding instruction code
-	attribute attribute;	 // Instruction attribute
-} instructionLookupTable[] = {
-	{".define", DEFINE_IN, MDEFINE},  // Define directive
-	{".string", STRING_IN, DATA},	  // String directive
-	{".data", DATA_IN, DATA},		  // Data directive
-	{".entry", ENTRY_IN, ENTRY},	  // Entry directive
-	{".extern", EXTERN_IN, EXTERNAL}, // Extern directive
-	{NULL, NONE_IN, NONE},			  // End of table marker
-};
-
-/**
- * Lookup table for registers.
- */
-struct registerLookupItem
-{
-	char *name; // Register name
-	reg reg;	// Corresponding register code
-} registerLookupTable[] = {
-	{"r0", R0},		// Register R0
-	{"r1", R1},		// Register R1
-	{"r2", R2},		// Register R2
-	{"r3", R3},		// Register R3
-	{"r4", R4},		// Register R4
-	{"r5", R5},		// Register R5
-	{"r6", R6},		// Register R6
-	{"r7", R7},		// Register R7
-	{NULL, R_NONE}, // End of table marker
-};
-
 /**
  * Allocates memory with a NULL check.
  * @param size The size of the memory to allocate.
@@ -86,15 +43,26 @@ void *checkedAlloc(long size)
 }
 
 /**
- * Allocates memory and concatenates two strings.
+ * Allocates memory that lives as long as the current file's assembly.
+ * The memory is never freed on its own; reset_global_vars frees all of it at once.
+ * @param size The size of the memory to allocate.
+ * @return Returns a pointer to the allocated memory, or NULL if memory allocation failed.
+ */
+void *arenaAlloc(long size)
+{
+	return arena_alloc(&context->pool, size);
+}
+
+/**
+ * Allocates memory from the file's arena and concatenates two strings.
  * @param s0 The first string.
  * @param s1 The second string.
  * @return Returns a pointer to the concatenated string.
  */
 char *strallocat(char *s0, char *s1)
 {
-	// Allocate memory for the concatenated string
-	char *str = (char *)checkedAlloc(strlen(s0) + strlen(s1) + 1);
+	// Allocate memory for the concatenated string, it lives until the file is done
+	char *str = (char *)arenaAlloc(strlen(s0) + strlen(s1) + 1);
 	// Copy the first string into the allocated memory
 	strcpy(str, s0);
 	// Concatenate the second string onto the end of the first string
@@ -110,31 +78,25 @@ char *strallocat(char *s0, char *s1)
  */
 int is_reserved(char *name, int is_label)
 {
-	// Check if the name is an instruction
-	if (find_instruction_by_name(name) != NONE_IN)
-	{
-		// Set appropriate error message based on whether the name is intended to be a label or a macro
-		err = is_label ? LABEL_CANT_BE_INSTRUCT : MACRO_CANT_BE_INSTRUCT;
-		return TRUE; // Return TRUE to indicate the name is reserved
-	}
+	const keywordEntry *keyword = find_keyword(name); // One lookup for every kind of reserved word
 
-	// Check if the name is a register
-	if (find_register_by_name(name) != R_NONE)
-	{
-		// Set appropriate error message based on whether the name is intended to be a label or a macro
-		err = is_label ? LABEL_CANT_BE_REGISTER : MACRO_CANT_BE_REGISTER;
-		return TRUE; // Return TRUE to indicate the name is reserved
-	}
+	if (keyword == NULL)
+		return FALSE; // Return FALSE to indicate the name is not reserved
 
-	// Check if the name is an operation command
-	if (find_operation_by_name(name) != NONE_OP)
+	// Set appropriate error message based on the kind of keyword and whether the name is intended to be a label or a macro
+	switch (keyword->kind)
 	{
-		// Set appropriate error message based on whether the name is intended to be a label or a macro
+	case INSTRUCTION_KW:
+		err = is_label ? LABEL_CANT_BE_INSTRUCT : MACRO_CANT_BE_INSTRUCT;
+		break;
+	case REGISTER_KW:
+		err = is_label ? LABEL_CANT_BE_REGISTER : MACRO_CANT_BE_REGISTER;
+		break;
+	default:
 		err = is_label ? LABEL_CANT_BE_COMMAND : MACRO_CANT_BE_COMMAND;
-		return TRUE; // Return TRUE to indicate the name is reserved
+		break;
 	}
-
-	return FALSE; // Return FALSE to indicate the name is not reserved
+	return TRUE; // Return TRUE to indicate the name is reserved
 }
 
 /**
@@ -228,60 +190,70 @@ int is_valid_macro(char *macro)
 }
 
 /**
- * Finds an instruction by its name in the instruction lookup table.
+ * Finds a reserved word with a single probe of the generated keyword hash.
+ * @param name The name to look up.
+ * @return Returns the keyword's entry if found, NULL otherwise.
+ */
+const keywordEntry *find_keyword(char *name)
+{
+	int length = 0; // Length of the name, counted up to one past the longest keyword
+
+	while (length <= KEYWORD_MAX_LENGTH && name[length] != '\0')
+		length++;
+	return find_keyword_span(name, length);
+}
+
+/**
+ * Finds a reserved word given by its first characters, which need not be null-terminated.
+ * Names outside the keyword lengths are rejected before hashing.
+ * @param name The first character of the name.
+ * @param length The length of the name.
+ * @return Returns the keyword's entry if found, NULL otherwise.
+ */
+const keywordEntry *find_keyword_span(char *name, int length)
+{
+	const keywordEntry *entry; // The only slot the name can be in
+
+	if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+		return NULL;
+
+	entry = &keywordSlots[KEYWORD_SLOT(name, length)];
+	if (entry->length != length || memcmp(entry->name, name, length) != 0)
+		return NULL;
+	return entry;
+}
+
+/**
+ * Finds an instruction by its name in the keyword hash.
  * @param name The name of the instruction to find.
  * @return Returns the instruction code if found, NONE_IN otherwise.
  */
 instruction find_instruction_by_name(char *name)
 {
-	int i = 0;	   // Index variable
-	char *current; // Pointer to the current instruction name
-	while ((current = instructionLookupTable[i].name) != NULL)
-	{
-		// Compare current instruction name with the given name
-		if (strcmp(current, name) == 0)
-			return instructionLookupTable[i].instruction; // Return instruction if found
-		i++;											  // Move to the next entry in the lookup table
-	}
-	return NONE_IN; // Return NONE_IN if instruction not found
+	const keywordEntry *keyword = find_keyword(name);
+	return keyword != NULL && keyword->kind == INSTRUCTION_KW ? (instruction)keyword->code : NONE_IN;
 }
 
 /**
- * Finds a register by its name in the register lookup table.
+ * Finds a register by its name in the keyword hash.
  * @param name The name of the register to find.
  * @return Returns the register code if found, R_NONE otherwise.
  */
 reg find_register_by_name(char *name)
 {
-	int i = 0;	   // Index variable
-	char *current; // Pointer to the current register name
-	while ((current = registerLookupTable[i].name) != NULL)
-	{
-		// Compare current register name with the given name
-		if (strcmp(current, name) == 0)
-			return registerLookupTable[i].reg; // Return register if found
-		i++;								   // Move to the next entry in the lookup table
-	}
-	return R_NONE; // Return R_NONE if register not found
+	const keywordEntry *keyword = find_keyword(name);
+	return keyword != NULL && keyword->kind == REGISTER_KW ? (reg)keyword->code : R_NONE;
 }
 
 /**
- * Finds an operation by its name in the operation lookup table.
+ * Finds an operation by its name in the keyword hash.
  * @param name The name of the operation to find.
  * @return Returns the opcode if found, NONE_OP otherwise.
  */
 opcode find_operation_by_name(char *name)
 {
-	int i = 0;	   // Index variable
-	char *current; // Pointer to the current operation name
-	while ((current = operationLookupTable[i].name) != NULL)
-	{
-		// Compare current operation name with the given name
-		if (strcmp(current, name) == 0)
-			return operationLookupTable[i].operation; // Return operation if found
-		i++;										  // Move to the next entry in the lookup table
-	}
-	return NONE_OP; // Return NONE_OP if operation not found
+	const keywordEntry *keyword = find_keyword(name);
+	return keyword != NULL && keyword->kind == OPERATION_KW ? (opcode)keyword->code : NONE_OP;
 }
 
 /**
@@ -397,6 +369,15 @@ int get_operand_count_by_opcode(opcode operation)
 	return operationLookupTable[operation].operands; // Return the number of operands for the operation
 }
 
+/**
+ * Returns the size of the memory image, in words.
+ * @return MAX_MEMORY_SIZE, or LARGE_MEMORY_SIZE in large-memory mode.
+ */
+long memory_size()
+{
+	return context->large_memory ? LARGE_MEMORY_SIZE : MAX_MEMORY_SIZE;
+}
+
 /**
  * Inserts data into the data array.
  * @param num The data to insert.
@@ -405,13 +386,18 @@ int get_operand_count_by_opcode(opcode operation)
 int insert_data(int num)
 {
 	// Check if there is enough memory to insert the data
-	if (ic + dc + RESERVED_MEMORY > MAX_MEMORY_SIZE)
+	if (ic + dc + RESERVED_MEMORY >= memory_size())
+	{
+		err = PROGRAM_TOO_LARGE; // Set error message for a program larger than the memory
+		return FALSE;			 // Return FALSE to indicate failure
+	}
+	if (!segment_store(&data, dc, (unsigned int)num))
 	{
 		err = FAILED_TO_ALLOCATE_MEMORY; // Set error message for memory allocation failure
 		return FALSE;					 // Return FALSE to indicate failure
 	}
-	data[dc++] = (unsigned int)num; // Insert data into the data array
-	return TRUE;					// Return TRUE to indicate success
+	dc++;		 // Move past the inserted data
+	return TRUE; // Return TRUE to indicate success
 }
 
 /**
@@ -422,13 +408,18 @@ int insert_data(int num)
 int insert_instructions(int num)
 {
 	// Check if there is enough memory to insert the instruction
-	if (ic + dc + RESERVED_MEMORY > MAX_MEMORY_SIZE)
+	if (ic + dc + RESERVED_MEMORY >= memory_size())
+	{
+		err = PROGRAM_TOO_LARGE; // Set error message for a program larger than the memory
+		return FALSE;			 // Return FALSE to indicate failure
+	}
+	if (!segment_store(&instructions, ic, (unsigned int)num))
 	{
 		err = FAILED_TO_ALLOCATE_MEMORY; // Set error message for memory allocation failure
 		return FALSE;					 // Return FALSE to indicate failure
 	}
-	instructions[ic++] = (unsigned int)num; // Insert instruction into the instructions array
-	return TRUE;							// Return TRUE to indicate success
+	ic++;		 // Move past the inserted instruction
+	return TRUE; // Return TRUE to indicate success
 }
 
 /**
@@ -484,13 +475,19 @@ char *convert_to_base_4(unsigned int num)
 }
 
 /**
- * Resets global variables.
+ * Empties the tables and clears the flags of the current file. The name pool and
+ * the arena are left to the caller, since the tables point into them.
  */
-void reset_global_vars()
+static void reset_file_tables()
 {
 	resetTable(macroTable);		// Reset macro table
 	resetSymbolTable(&symbols); // Reset symbol table
 	reset_ext(&externals);		// Reset external list
+	reset_statements(&statements); // Reset recorded statements
+	reset_fixups(&fixups);		// Reset recorded fixups
+	reset_segment(&data);		// Reset data image
+	reset_segment(&instructions); // Reset instructions image
+	defer_labels = FALSE;		// Reset single-pass flag
 	has_entry = FALSE;			// Reset entry flag
 	has_external = FALSE;		// Reset external flag
 	has_error = FALSE;			// Reset error flag
@@ -498,6 +495,29 @@ void reset_global_vars()
 	warn = FALSE;				// Reset warning flag
 }
 
+/**
+ * Resets global variables.
+ */
+void reset_global_vars()
+{
+	reset_file_tables();
+	reset_name_pool(&context->names); // Reset interned names
+	reset_string_pool(&context->strings); // Reset pooled literals
+	reset_arena(&context->pool); // Free the file's arena, after the tables that point into it
+}
+
+/**
+ * Resets global variables for the next file assembled with the same context,
+ * keeping the memory of the name pool and the arena warm.
+ */
+void recycle_global_vars()
+{
+	reset_file_tables();
+	clear_name_pool(&context->names); // Forget interned names, keep their arrays
+	clear_string_pool(&context->strings); // Forget pooled literals, keep their slots
+	recycle_arena(&context->pool); // Empty the file's arena, keeping some blocks
+}
+
 /**
  * Finds the next symbol in a line.
  * @param line The line to search for symbols.
@@ -510,7 +530,7 @@ int find_next_symbol(char *line, char *symbol, char del)
 	int index = 0; // Index variable for traversing the line
 	int i = 0;	   // Index variable for storing characters in the symbol buffer
 
-	MOVE_TO_NOT_WHITE(line, index); // Move to the next non-white space character
+	MOVE_TO_NOT_BLANK(line, index); // Move to the next non-blank character, stopping at the end of the line
 
 	// Iterate until reaching the end of the line, a white space, the delimiter, or the maximum symbol size
 	while (!is_end_of_line(line[index]) && !isspace(line[index]) && line[index] != del && i < SYMBOL_MAX_SIZE)
@@ -534,7 +554,7 @@ int find_next_token(char *line, char *token, char del)
 	int index = 0; // Index variable for traversing the line
 	int i = 0;	   // Index variable for storing characters in the token buffer
 
-	MOVE_TO_NOT_WHITE(line, index); // Move to the next non-white space character
+	MOVE_TO_NOT_BLANK(line, index); // Move to the next non-blank character, stopping at the end of the line
 
 	// Iterate until reaching the end of the line, a white space, the delimiter, or the maximum token size
 	while (!is_end_of_line(line[index]) && !isspace(line[index]) && line[index] != del && i < LINESIZE + 1)
@@ -547,171 +567,142 @@ int find_next_token(char *line, char *token, char del)
 }
 
 /**
- * Prints the corrsponding error message for a given error code.
- * @param error_code The given error's, error code.
- * @param line_num The corrsponding line number of the error.
- * @return Returns TRUE if the string represents an integer, FALSE otherwise.
+ * Returns the message of an error or warning code, as printed after the line number.
+ * @param error_code The error code.
+ * @return The message text.
  */
-void print_error_message(error error_code, int line_num)
+const char *error_text(error error_code)
 {
-	fprintf(stderr, "line %d: ", line_num);
 	switch (error_code)
 	{
 	case WARNING_LINE_TOO_LONG:
-		fprintf(stderr, "Warning: Line too long.\n");
-		break;
+		return "Warning: Line too long.";
 	case NUM_OUT_OF_RANGE:
-		fprintf(stderr, "Error: Number out of range.\n");
-		break;
+		return "Error: Number out of range.";
 	case MACRO_UNEXPECTED_CHARS:
-		fprintf(stderr, "Error: Unexpected characters in macro.\n");
-		break;
+		return "Error: Unexpected characters in macro.";
 	case MACRO_TOO_LONG:
-		fprintf(stderr, "Error: Macro is too long.\n");
-		break;
+		return "Error: Macro is too long.";
 	case MACRO_CANT_BE_EMPTY:
-		fprintf(stderr, "Error: Macro cannot be empty.\n");
-		break;
+		return "Error: Macro cannot be empty.";
 	case MACRO_INVALID_FIRST_CHAR:
-		fprintf(stderr, "Error: Invalid first character in macro.\n");
-		break;
+		return "Error: Invalid first character in macro.";
 	case MACRO_ONLY_PRINTABLE:
-		fprintf(stderr, "Error: Macro must contain only printable characters.\n");
-		break;
+		return "Error: Macro must contain only printable characters.";
 	case MACRO_CANT_BE_COMMAND:
-		fprintf(stderr, "Error: Macro cannot be a command.\n");
-		break;
+		return "Error: Macro cannot be a command.";
 	case MACRO_ALREADY_EXISTS:
-		fprintf(stderr, "Error: Macro already exists.\n");
-		break;
+		return "Error: Macro already exists.";
 	case MACRO_CANT_BE_REGISTER:
-		fprintf(stderr, "Error: Macro cannot be a register.\n");
-		break;
+		return "Error: Macro cannot be a register.";
 	case MACRO_CANT_BE_INSTRUCT:
-		fprintf(stderr, "Error: Macro cannot be an instruction.\n");
-		break;
+		return "Error: Macro cannot be an instruction.";
 	case LABEL_TOO_LONG:
-		fprintf(stderr, "Error: Label is too long.\n");
-		break;
+		return "Error: Label is too long.";
 	case LABEL_INVALID_FIRST_CHAR:
-		fprintf(stderr, "Error: Invalid first character in label.\n");
-		break;
+		return "Error: Invalid first character in label.";
 	case LABEL_ONLY_ALPHANUMERIC:
-		fprintf(stderr, "Error: Label must contain only alphanumeric characters.\n");
-		break;
+		return "Error: Label must contain only alphanumeric characters.";
 	case LABEL_CANT_BE_COMMAND:
-		fprintf(stderr, "Error: Label cannot be a command.\n");
-		break;
+		return "Error: Label cannot be a command.";
 	case LABEL_CANT_BE_MACRO:
-		fprintf(stderr, "Error: Label cannot be a macro.\n");
-		break;
+		return "Error: Label cannot be a macro.";
 	case LABEL_ALREADY_EXISTS:
-		fprintf(stderr, "Error: Label already exists.\n");
-		break;
+		return "Error: Label already exists.";
 	case WARNING_EMPTY_LABEL:
-		fprintf(stderr, "Warning: Label is empty.\n");
-		break;
+		return "Warning: Label is empty.";
 	case LABEL_CANT_BE_REGISTER:
-		fprintf(stderr, "Error: Label cannot be a register.\n");
-		break;
+		return "Error: Label cannot be a register.";
 	case LABEL_CANT_BE_INSTRUCT:
-		fprintf(stderr, "Error: Label cannot be an instruction.\n");
-		break;
+		return "Error: Label cannot be an instruction.";
 	case DEFINE_EXPECTED_NUM:
-		fprintf(stderr, "Error: Expected number after define.\n");
-		break;
+		return "Error: Expected number after define.";
 	case DEFINE_EXPECTED_EQUAL:
-		fprintf(stderr, "Error: Define must have an equal sign.\n");
-		break;
+		return "Error: Define must have an equal sign.";
 	case DEFINE_CANT_HAVE_LABEL:
-		fprintf(stderr, "Error: Define cannot have a label.\n");
-		break;
+		return "Error: Define cannot have a label.";
 	case INSTRUCTION_NOT_FOUND:
-		fprintf(stderr, "Error: Instruction not found.\n");
-		break;
+		return "Error: Instruction not found.";
 	case INSTRUCTION_INVALID_NUM_PARAMS:
-		fprintf(stderr, "Error: Invalid number of parameters for instruction.\n");
-		break;
+		return "Error: Invalid number of parameters for instruction.";
 	case DATA_EXPECTED_CONST:
-		fprintf(stderr, "Error: Expected a number or a constant in data.\n");
-		break;
+		return "Error: Expected a number or a constant in data.";
 	case DATA_EXPECTED_COMMA_AFTER_NUM:
-		fprintf(stderr, "Error: Expected a comma after number in data.\n");
-		break;
+		return "Error: Expected a comma after number in data.";
 	case DATA_UNEXPECTED_COMMA:
-		fprintf(stderr, "Error: Unexpected comma in data.\n");
-		break;
+		return "Error: Unexpected comma in data.";
 	case DATA_LABEL_DOES_NOT_EXIST:
-		fprintf(stderr, "Error: Label does not exist in data.\n");
-		break;
+		return "Error: Label does not exist in data.";
 	case STRING_TOO_MANY_OPERANDS:
-		fprintf(stderr, "Error: Too many operands for string.\n");
-		break;
+		return "Error: Too many operands for string.";
 	case STRING_UNEXPECTED_CHARS:
-		fprintf(stderr, "Error: Unexpected characters in string.\n");
-		break;
+		return "Error: Unexpected characters in string.";
 	case STRING_OPERAND_NOT_VALID:
-		fprintf(stderr, "Error: Operand not valid in string.\n");
-		break;
+		return "Error: Operand not valid in string.";
 	case INVALID_ADDRESSING_TYPE:
-		fprintf(stderr, "Error: Invalid addressing type.\n");
-		break;
+		return "Error: Invalid addressing type.";
 	case INDEX_EXPECTED_CLOSING_BRACKET:
-		fprintf(stderr, "Error: Expected closing bracket for index.\n");
-		break;
+		return "Error: Expected closing bracket for index.";
 	case INDEX_INVALID_POSITION:
-		fprintf(stderr, "Error: Invalid position for index.\n");
-		break;
+		return "Error: Invalid position for index.";
 	case EXPECTED_COMMA_BETWEEN_OPERANDS:
-		fprintf(stderr, "Error: Expected comma between operands.\n");
-		break;
+		return "Error: Expected comma between operands.";
 	case EXTERN_NO_LABEL:
-		fprintf(stderr, "Error: Extern cannot be a label.\n");
-		break;
+		return "Error: Extern cannot be a label.";
 	case EXTERN_INVALID_LABEL:
-		fprintf(stderr, "Error: Invalid label in extern.\n");
-		break;
+		return "Error: Invalid label in extern.";
 	case EXTERN_TOO_MANY_OPERANDS:
-		fprintf(stderr, "Error: Too many operands in extern.\n");
-		break;
+		return "Error: Too many operands in extern.";
 	case COMMAND_NOT_FOUND:
-		fprintf(stderr, "Error: Command not found.\n");
-		break;
+		return "Error: Command not found.";
 	case COMMAND_UNEXPECTED_CHAR:
-		fprintf(stderr, "Error: Unexpected character in command.\n");
-		break;
+		return "Error: Unexpected character in command.";
 	case COMMAND_TOO_MANY_OPERANDS:
-		fprintf(stderr, "Error: Too many operands in command.\n");
-		break;
+		return "Error: Too many operands in command.";
 	case COMMAND_INVALID_ADDRESSING:
-		fprintf(stderr, "Error: Invalid type in command.\n");
-		break;
+		return "Error: Invalid type in command.";
 	case COMMAND_INVALID_NUMBER_OF_OPERANDS:
-		fprintf(stderr, "Error: Invalid number of operands in command.\n");
-		break;
+		return "Error: Invalid number of operands in command.";
 	case COMMAND_LABEL_DOES_NOT_EXIST:
-		fprintf(stderr, "Error: Label does not exist in command.\n");
-		break;
+		return "Error: Label does not exist in command.";
 	case ENTRY_LABEL_DOES_NOT_EXIST:
-		fprintf(stderr, "Error: Label does not exist in entry.\n");
-		break;
+		return "Error: Label does not exist in entry.";
 	case ENTRY_TOO_MANY_OPERANDS:
-		fprintf(stderr, "Error: Too many operands in entry.\n");
-		break;
+		return "Error: Too many operands in entry.";
 	case ENTRY_CANT_BE_EXTERN:
-		fprintf(stderr, "Error: Entry cannot be extern.\n");
-		break;
+		return "Error: Entry cannot be extern.";
 	case CANNOT_OPEN_FILE:
-		fprintf(stderr, "Error: Cannot open file.\n");
-		break;
+		return "Error: Cannot open file.";
 	case FAILED_TO_CREATE_FILE:
-		fprintf(stderr, "Error: Cannot create file.\n");
-		break;
+		return "Error: Cannot create file.";
 	case FAILED_TO_ALLOCATE_MEMORY:
-		fprintf(stderr, "Error: Failed to allocate memory.\n");
-		break;
+		return "Error: Failed to allocate memory.";
+	case PROGRAM_TOO_LARGE:
+		return "Error: Program does not fit in memory (--large-memory raises the limit).";
+	case EXPRESSION_INVALID:
+		return "Error: Invalid constant expression.";
+	case EXPRESSION_NOT_CONSTANT:
+		return "Error: Name in expression is not a constant defined earlier.";
+	case EXPRESSION_DIVISION_BY_ZERO:
+		return "Error: Division by zero in expression.";
 	default:
-		fprintf(stderr, "Unknown error code.\n");
-		break;
+		return "Unknown error code.";
 	}
 }
+
+/**
+ * Prints the corrsponding error message for a given error code.
+ * @param error_code The given error's, error code.
+ * @param line_num The corrsponding line number of the error.
+ * @return Returns TRUE if the string represents an integer, FALSE otherwise.
+ */
+void print_error_message(error error_code, int line_num)
+{
+	FILE *stream = context != NULL ? context->diag : stderr; // Messages go to the current file's diagnostics
+
+	if (context != NULL && context->on_diagnostic != NULL)
+		context->on_diagnostic(context->diagnostic_data, error_code, line_num); // Let an embedder record it
+
+	if (stream != NULL) // An embedder may only record the messages
+		fprintf(stream, "line %d: %s\n", line_num, error_text(error_code));
+}
@@ -2,28 +2,45 @@
 #include "vars.h"
 #include "writeFiles.h"
 #include <stdlib.h>
+#include <string.h>
+
+/**
+ * Opens an output file, reporting a file that cannot be created as an error of the file
+ * being assembled.
+ * @param filename The name of the output files.
+ * @param type The type of the file.
+ * @return A pointer to the opened file, or NULL if it cannot be created.
+ */
+static FILE *open_output(char *filename, FILE_TYPE type)
+{
+    FILE *file = open_file(filename, type);
+
+    if (file == NULL)
+    {
+        has_error = TRUE; // The outputs are incomplete, so the file failed
+        print_error_message(FAILED_TO_CREATE_FILE, 0);
+    }
+    return file;
+}
 
 /**
  * Writes output files based on the given filename.
+ * A file that cannot be created sets has_error and is skipped.
  * @param filename The name of the output files.
  */
 void write_output_files(char *filename)
 {
-    FILE *file = open_file(filename, OB_FILE); // Open object file
-    write_output_ob(file);                     // Write object file contents
+    FILE *file = open_output(filename, OB_FILE); // Open object file
+    if (file == NULL)
+        return;
+    write_output_ob(file); // Write object file contents
 
     // If there are entry symbols, write entry file
-    if (has_entry)
-    {
-        file = open_file(filename, ENT_FILE);
+    if (has_entry && (file = open_output(filename, ENT_FILE)) != NULL)
         write_output_entry(file);
-    }
     // If there are external symbols, write external file
-    if (has_external)
-    {
-        file = open_file(filename, EXT_FILE);
+    if (has_external && (file = open_output(filename, EXT_FILE)) != NULL)
         write_output_external(file);
-    }
 }
 
 /**
@@ -38,7 +55,6 @@ FILE *open_file(char *filename, FILE_TYPE type)
     char *filename_str;                              // String for the filename with appropriate extension
     filename_str = create_file_name(filename, type); // Create the filename string with appropriate extension
     file = fopen(filename_str, "w");                 // Open the file in write mode
-    free(filename_str);                              // Free the dynamically allocated filename string
 
     if (file == NULL)
     {
@@ -48,36 +64,163 @@ FILE *open_file(char *filename, FILE_TYPE type)
     return file; // Return the file pointer
 }
 
+/*
+ * Base-4 digit tables. A 14 bit word is encoded as its high 6 bits (3 digits)
+ * followed by its low 8 bits (4 digits), so every word costs two table reads.
+ * The digits are the same as in base4: '*', '#', '%', '!'.
+ */
+#define B4_1(p) p "*", p "#", p "%", p "!"
+#define B4_2(p) B4_1(p "*"), B4_1(p "#"), B4_1(p "%"), B4_1(p "!")
+#define B4_3(p) B4_2(p "*"), B4_2(p "#"), B4_2(p "%"), B4_2(p "!")
+#define B4_4(p) B4_3(p "*"), B4_3(p "#"), B4_3(p "%"), B4_3(p "!")
+
+static const char base4_high[64][4] = {B4_3("")}; // Encodings of the high 3 digits (null-terminated, unused)
+static const char base4_low[256][4] = {B4_4("")}; // Encodings of the low 4 digits
+
+/**
+ * Writes an address in decimal followed by a tab.
+ * @param out The buffer to write to.
+ * @param address The address to write.
+ * @return Returns a pointer just past the tab.
+ */
+static char *encode_address(char *out, unsigned int address)
+{
+    char digits[10]; // The address digits, in reverse order
+    int count = 0;   // Number of address digits
+
+    do
+    {
+        digits[count++] = (char)('0' + address % 10);
+        address /= 10;
+    } while (address != 0);
+    while (count > 0)
+        *out++ = digits[--count];
+    *out++ = '\t';
+    return out;
+}
+
+/**
+ * Encodes one line of the object file, the address and the word in base-4.
+ * @param out The buffer to write to, with room for at least OB_LINE_MAX characters.
+ * @param address The address of the word.
+ * @param word The word to encode.
+ * @return Returns a pointer just past the written line.
+ */
+char *encode_ob_line(char *out, unsigned int address, unsigned int word)
+{
+    out = encode_address(out, address);
+
+    // Write the word's 7 base-4 digits
+    memcpy(out, base4_high[(word >> 8) & 0x3F], 3);
+    memcpy(out + 3, base4_low[word & 0xFF], 4);
+    out[7] = '\n';
+    return out + 8;
+}
+
+/**
+ * Encodes one line of a large-memory object file, where words are 32 bits wide.
+ * @param out The buffer to write to, with room for at least OB_LINE_MAX characters.
+ * @param address The address of the word.
+ * @param word The word to encode.
+ * @return Returns a pointer just past the written line.
+ */
+char *encode_wide_ob_line(char *out, unsigned int address, unsigned int word)
+{
+    out = encode_address(out, address);
+
+    // Write the word's 16 base-4 digits, one byte at a time
+    memcpy(out, base4_low[(word >> 24) & 0xFF], 4);
+    memcpy(out + 4, base4_low[(word >> 16) & 0xFF], 4);
+    memcpy(out + 8, base4_low[(word >> 8) & 0xFF], 4);
+    memcpy(out + 12, base4_low[word & 0xFF], 4);
+    out[16] = '\n';
+    return out + 17;
+}
+
+/**
+ * Decodes the base-4 digits of an object file word, the way encode_ob_line and
+ * encode_wide_ob_line write them.
+ * @param text The first digit.
+ * @param end The end of the text.
+ * @param word Receives the word.
+ * @return Returns a pointer to the first character after the digits.
+ */
+char *decode_ob_word(char *text, char *end, unsigned int *word)
+{
+    unsigned int value = 0; // The digits read so far
+    unsigned int digit;     // Value of the current digit
+
+    for (; text < end; text++)
+    {
+        switch (*text)
+        {
+        case '*':
+            digit = 0;
+            break;
+        case '#':
+            digit = 1;
+            break;
+        case '%':
+            digit = 2;
+            break;
+        case '!':
+            digit = 3;
+            break;
+        default:
+            *word = value;
+            return text;
+        }
+        value = (value << 2) | digit;
+    }
+    *word = value;
+    return text;
+}
+
+/**
+ * Encodes the words of a segment into the output buffer, flushing it when it fills up.
+ * @param fp Pointer to the object file.
+ * @param buffer The output buffer, OB_BUFFER_SIZE characters long.
+ * @param end The end of the encoded text in the buffer, updated.
+ * @param seg The segment to write.
+ * @param count The number of words in the segment.
+ * @param address The address of the segment's first word, updated to the address after it.
+ */
+static void write_segment(FILE *fp, char *buffer, char **end, wordSegment *seg, int count, unsigned int *address)
+{
+    char *(*encode)(char *, unsigned int, unsigned int) = context->large_memory ? encode_wide_ob_line : encode_ob_line;
+    int i; // Loop variable
+
+    for (i = 0; i < count; i++, (*address)++)
+    {
+        if (*end - buffer > OB_BUFFER_SIZE - OB_LINE_MAX)
+        {
+            fwrite(buffer, 1, *end - buffer, fp); // Flush a full buffer
+            *end = buffer;
+        }
+        *end = encode(*end, *address, segment_load(seg, i)); // Write address and corresponding word
+    }
+}
+
 /**
  * Writes all data and instructions to the object file.
+ * The lines are encoded into a buffer that is written out in large blocks.
  * @param fp Pointer to the object file.
  */
 void write_output_ob(FILE *fp)
 {
+    char buffer[OB_BUFFER_SIZE];            // Output buffer
+    char *end = buffer;                     // End of the encoded text in the buffer
     unsigned int address = RESERVED_MEMORY; // Address counter
-    int i;                                  // Loop variable
-    char *param;                            // Temporary parameter string
 
     // Write the number of instruction and data lines in the first line of the object file.
     fprintf(fp, "%d\t%d\n", ic, dc);
+    context->stats.words_emitted += ic + dc;
 
-    // Write instructions memory to the object file.
-    for (i = 0; i < ic; address++, i++)
-    {
-        param = convert_to_base_4(instructions[i]); // Convert instruction to base-4
-        fprintf(fp, "%d\t%s\n", address, param);    // Write address and corresponding instruction
-        free(param);                                // Free the allocated memory for the parameter
-    }
-
-    // Write data memory to the object file.
-    for (i = 0; i < dc; address++, i++)
-    {
-        param = convert_to_base_4(data[i]);      // Convert data to base-4
-        fprintf(fp, "%d\t%s\n", address, param); // Write address and corresponding data
-        free(param);                             // Free the allocated memory for the parameter
-    }
+    write_segment(fp, buffer, &end, &instructions, ic, &address); // Write instructions memory to the object file.
+    write_segment(fp, buffer, &end, &data, dc, &address);         // Write data memory to the object file.
 
-    fclose(fp); // Close the file
+    fwrite(buffer, 1, end - buffer, fp); // Write what is left in the buffer
+    fclose(fp);                          // Close the file
 }
 
 /**
@@ -137,5 +280,7 @@ char *create_file_name(char *filename, FILE_TYPE type)
         return strallocat(filename, ".ent"); // Append ".ent" extension for entry file
     case EXT_FILE:
         return strallocat(filename, ".ext"); // Append ".ext" extension for external file
+    case STATS_FILE:
+        return strallocat(filename, ".stats.json"); // Append ".stats.json" extension for statistics file
     }
 }